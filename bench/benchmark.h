@@ -0,0 +1,115 @@
+#pragma once
+
+#include "core/common.h"
+#include "core/simd_kernels.h"
+
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+// Shared helpers of the benchmark cases in this directory. Timings are wall clock, and cases which repeat a
+// measurement report the fastest run, which is the one least disturbed by other processes. The numbers are only
+// comparable within one run on one machine.
+
+struct BenchmarkTimer
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	double milliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+};
+
+// Fastest of repetition_count calls of f, in milliseconds.
+template <typename F>
+static double best_milliseconds(u32 repetition_count, F&& f)
+{
+	double best = 1e30;
+	for (u32 i = 0; i < repetition_count; ++i)
+	{
+		BenchmarkTimer timer;
+		f();
+		best = min(best, timer.milliseconds());
+	}
+	return best;
+}
+
+// Calls f(level_name) once for every level of the kernels in simd_kernels.h which the build and the CPU support,
+// with the kernels set to that level. Afterwards, the best level is used again.
+template <typename F>
+static void for_each_simd_level(F&& f)
+{
+	for (u32 level = 0; level <= (u32)get_cpu_simd_level(); ++level)
+	{
+		if (set_simd_level((SimdLevel)level) == (SimdLevel)level)
+		{
+			f(get_simd_level_name((SimdLevel)level));
+		}
+	}
+	set_simd_level(get_cpu_simd_level());
+}
+
+// Defined in another translation unit, so the compiler has to assume that the data is read and can't remove the
+// computation which produced it.
+void do_not_optimize(const void* data);
+
+// Page faults of the whole process so far, including those which did not need to read from disk.
+u64 get_page_fault_count();
+
+// Time stamp counter. It ticks at a constant rate, the base clock of the CPU, whatever the current clock is.
+u64 read_cycle_counter();
+
+// Accuracy and speed of the simd.h math functions for one instruction set level, see simd_math_benchmarks_impl.h.
+// Return false if the compiler does not support that level.
+bool run_simd_math_benchmarks_sse2();
+bool run_simd_math_benchmarks_sse4_1();
+bool run_simd_math_benchmarks_avx2();
+bool run_simd_math_benchmarks_avx512();
+
+// Cases of wide_benchmarks_impl.h, which run once per instruction set level.
+enum class WideBenchmark
+{
+	CompressStore,
+	Random,
+	IntersectRay,
+};
+
+// Runs one case at every instruction set level which the compiler and the CPU support.
+void run_wide_benchmark(WideBenchmark benchmark);
+
+// One line of the random case, in million samples per second.
+void print_random_rates(const char* name, double floats, double vec2s, double hemisphere_samples);
+
+// Rays and boxes of the intersect_ray case. Boxes are six floats each (min corner, max corner) like AABB in math.h,
+// origins and inverse directions three floats each.
+struct RayBenchmarkScene
+{
+	std::vector<float> boxes;
+	std::vector<float> origins;
+	std::vector<float> inv_directions;
+};
+
+const RayBenchmarkScene& get_ray_benchmark_scene();
+
+// Run one case for one instruction set level. Return false if the compiler does not support that level.
+bool run_wide_benchmark_sse2(WideBenchmark benchmark);
+bool run_wide_benchmark_sse4_1(WideBenchmark benchmark);
+bool run_wide_benchmark_avx2(WideBenchmark benchmark);
+bool run_wide_benchmark_avx512(WideBenchmark benchmark);
+
+
+// Benchmark cases, see main.cpp.
+void benchmark_arena_commit();
+void benchmark_concurrent_arena();
+void benchmark_tlsf();
+void benchmark_lock_free();
+void benchmark_simd_math();
+void benchmark_aos_to_soa();
+void benchmark_compress_store();
+void benchmark_half_conversion();
+void benchmark_random();
+void benchmark_transform_positions();
+void benchmark_matrices();
+void benchmark_aabb_grow();
+void benchmark_intersect_ray();
@@ -0,0 +1,110 @@
+#include "benchmark.h"
+#include "core/lock_free.h"
+#include "core/linked_list.h"
+
+#include <thread>
+#include <vector>
+
+struct BenchmarkItem : LockFreeLink
+{
+	BenchmarkItem* next;
+	BenchmarkItem* prev;
+};
+
+// A mutex and a linked list, which is what the command queue and the graveyard used before.
+struct LockedQueue
+{
+	void push(BenchmarkItem* item) { std::lock_guard<std::mutex> lock(mutex); list.push_back(item); }
+	BenchmarkItem* pop() { std::lock_guard<std::mutex> lock(mutex); return list.pop_front(); }
+
+	std::mutex mutex;
+	DoublyLinkedList<BenchmarkItem> list;
+};
+
+// Producers push their items while one consumer pops them, like submission threads and the cleanup thread.
+template <typename queue_t>
+static double produce_and_consume(u32 producer_count, u32 items_per_producer)
+{
+	queue_t queue;
+	std::vector<BenchmarkItem> items((u64)producer_count * items_per_producer);
+
+	BenchmarkTimer timer;
+
+	std::thread consumer([&queue, &items]()
+	{
+		for (u64 popped = 0; popped < items.size(); )
+		{
+			popped += (queue.pop() != nullptr);
+		}
+	});
+
+	std::vector<std::thread> producers;
+	for (u32 p = 0; p < producer_count; ++p)
+	{
+		producers.emplace_back([&queue, &items, p, items_per_producer]()
+		{
+			for (u32 i = 0; i < items_per_producer; ++i)
+			{
+				queue.push(&items[(u64)p * items_per_producer + i]);
+			}
+		});
+	}
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+	consumer.join();
+
+	return timer.milliseconds();
+}
+
+// Every thread pops an item and pushes it back, like command lists taken from and returned to the free list.
+template <typename stack_t>
+static double pop_and_push(u32 thread_count, u32 operations_per_thread)
+{
+	stack_t stack;
+	std::vector<BenchmarkItem> items(1024);
+	for (BenchmarkItem& item : items)
+	{
+		stack.push(&item);
+	}
+
+	BenchmarkTimer timer;
+
+	std::vector<std::thread> threads;
+	for (u32 t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&stack, operations_per_thread]()
+		{
+			for (u32 i = 0; i < operations_per_thread; ++i)
+			{
+				if (BenchmarkItem* item = stack.pop())
+				{
+					stack.push(item);
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	return timer.milliseconds();
+}
+
+// 2M items in total from 1 to 16 producers into one consumer, and 2M pops and pushes on 1 to 16 threads, lock-free
+// against a mutex.
+void benchmark_lock_free()
+{
+	const u32 total_count = 2000000;
+
+	for (u32 thread_count = 1; thread_count <= 16; thread_count *= 2)
+	{
+		std::cout << std::setw(2) << thread_count << " threads:"
+			<< " MPSCQueue" << std::setw(10) << produce_and_consume<MPSCQueue<BenchmarkItem>>(thread_count, total_count / thread_count) << " ms,"
+			<< " locked" << std::setw(10) << produce_and_consume<LockedQueue>(thread_count, total_count / thread_count) << " ms;"
+			<< " LockFreeStack" << std::setw(10) << pop_and_push<LockFreeStack<BenchmarkItem>>(thread_count, total_count / thread_count) << " ms,"
+			<< " locked" << std::setw(10) << pop_and_push<LockedQueue>(thread_count, total_count / thread_count) << " ms\n";
+	}
+}
@@ -0,0 +1,120 @@
+#include "benchmark.h"
+#include "core/cpu_features.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#include <intrin.h>
+#else
+#include <sys/resource.h>
+#include <x86intrin.h>
+#endif
+
+void do_not_optimize(const void* data)
+{
+#if defined(_MSC_VER)
+	(void)data;
+	_ReadWriteBarrier();
+#else
+	__asm__ volatile("" : : "g"(data) : "memory");
+#endif
+}
+
+u64 get_page_fault_count()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PageFaultCount;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (u64)(usage.ru_minflt + usage.ru_majflt);
+#endif
+}
+
+u64 read_cycle_counter()
+{
+	return __rdtsc();
+}
+
+// Every instruction set level which the compiler and the CPU support.
+void benchmark_simd_math()
+{
+	bool (*const level_benchmarks[])() = { run_simd_math_benchmarks_sse2, run_simd_math_benchmarks_sse4_1, run_simd_math_benchmarks_avx2, run_simd_math_benchmarks_avx512 };
+	static_assert(arraysize(level_benchmarks) == (u32)SimdLevel::Count);
+
+	for (u32 level = 0; level <= (u32)get_cpu_simd_level(); ++level)
+	{
+		std::cout << get_simd_level_name((SimdLevel)level) << ", cycles per element:\n";
+		if (!level_benchmarks[level]())
+		{
+			std::cout << "  not compiled\n";
+		}
+	}
+}
+
+void run_wide_benchmark(WideBenchmark benchmark)
+{
+	bool (*const level_benchmarks[])(WideBenchmark) = { run_wide_benchmark_sse2, run_wide_benchmark_sse4_1, run_wide_benchmark_avx2, run_wide_benchmark_avx512 };
+	static_assert(arraysize(level_benchmarks) == (u32)SimdLevel::Count);
+
+	for (u32 level = 0; level <= (u32)get_cpu_simd_level(); ++level)
+	{
+		std::cout << get_simd_level_name((SimdLevel)level) << ":\n";
+		if (!level_benchmarks[level](benchmark))
+		{
+			std::cout << "  not compiled\n";
+		}
+	}
+}
+
+void benchmark_compress_store() { run_wide_benchmark(WideBenchmark::CompressStore); }
+
+struct BenchmarkCase
+{
+	const char* name;
+	void (*run)();
+};
+
+static const BenchmarkCase benchmark_cases[] =
+{
+	{ "arena_commit", benchmark_arena_commit },
+	{ "concurrent_arena", benchmark_concurrent_arena },
+	{ "tlsf", benchmark_tlsf },
+	{ "lock_free", benchmark_lock_free },
+	{ "simd_math", benchmark_simd_math },
+	{ "aos_to_soa", benchmark_aos_to_soa },
+	{ "compress_store", benchmark_compress_store },
+	{ "half_conversion", benchmark_half_conversion },
+	{ "random", benchmark_random },
+	{ "transform_positions", benchmark_transform_positions },
+	{ "matrices", benchmark_matrices },
+	{ "aabb_grow", benchmark_aabb_grow },
+	{ "intersect_ray", benchmark_intersect_ray },
+};
+
+// Runs all cases, or only those whose name contains one of the arguments, e.g. "Benchmarks arena".
+int main(int argc, char** argv)
+{
+	std::cout << std::fixed << std::setprecision(2);
+
+	for (const BenchmarkCase& benchmark_case : benchmark_cases)
+	{
+		bool selected = (argc < 2);
+		for (i32 i = 1; i < argc; ++i)
+		{
+			selected |= (strstr(benchmark_case.name, argv[i]) != nullptr);
+		}
+
+		if (selected)
+		{
+			std::cout << "== " << benchmark_case.name << " ==\n";
+			benchmark_case.run();
+			std::cout << '\n';
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,481 @@
+#include "benchmark.h"
+#include "core/half.h"
+#include "core/math.h"
+#include "core/random.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+static double gigabytes_per_second(u64 bytes, double milliseconds)
+{
+	return bytes / (milliseconds * 1e6);
+}
+
+// Like VertexAttribute in dx/mesh.h, which the benchmarks can't include.
+struct NormalAndUv
+{
+	vec3 normal;
+	vec2 uv;
+};
+
+// vec3, vertex attribute and Transform streams to structures of arrays and back, with 16K elements in cache and 1M
+// in memory, against a scalar loop. In GB/s of floats read plus written. The counts are odd and the arrays
+// unaligned, so that the tails are part of the measurement.
+void benchmark_aos_to_soa()
+{
+	struct StreamType
+	{
+		const char* name;
+		u64 stride_in_bytes;
+		u32 component_count;
+	};
+
+	const StreamType stream_types[] =
+	{
+		{ "vec3", sizeof(vec3), 3 },
+		{ "VertexAttribute", sizeof(NormalAndUv), 5 },
+		{ "Transform", sizeof(Transform), transform_component_count },
+	};
+
+	for (u64 count : { 16384 + 7, 1000000 + 7 })
+	{
+		u32 repetition_count = (count < 100000) ? 200 : 10;
+
+		for (const StreamType& type : stream_types)
+		{
+			u64 stride = type.stride_in_bytes / sizeof(float);
+			std::vector<float> aos_memory(count * stride + 1);
+			std::vector<float> soa_memory(type.component_count * (count + 1));
+			for (u64 i = 0; i < aos_memory.size(); ++i)
+			{
+				aos_memory[i] = (float)i;
+			}
+
+			float* aos = aos_memory.data() + 1;
+			float* soa[transform_component_count];
+			for (u32 c = 0; c < type.component_count; ++c)
+			{
+				soa[c] = soa_memory.data() + c * (count + 1) + 1;
+			}
+
+			u64 bytes = 2 * count * type.component_count * sizeof(float);
+
+			std::cout << type.name << ", " << count << " elements\n";
+
+			double to_soa = best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					for (u32 c = 0; c < type.component_count; ++c)
+					{
+						soa[c][i] = aos[i * stride + c];
+					}
+				}
+				do_not_optimize(soa_memory.data());
+			});
+			double to_aos = best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					for (u32 c = 0; c < type.component_count; ++c)
+					{
+						aos[i * stride + c] = soa[c][i];
+					}
+				}
+				do_not_optimize(aos_memory.data());
+			});
+			std::cout << "  " << std::left << std::setw(10) << "Scalar" << std::right
+				<< std::setw(8) << gigabytes_per_second(bytes, to_soa) << " GB/s to SoA"
+				<< std::setw(8) << gigabytes_per_second(bytes, to_aos) << " GB/s to AoS\n";
+
+			for_each_simd_level([&](const char* level_name)
+			{
+				double to_soa = best_milliseconds(repetition_count, [&]()
+				{
+					aos_to_soa(aos, type.stride_in_bytes, type.component_count, soa, count);
+				});
+				double to_aos = best_milliseconds(repetition_count, [&]()
+				{
+					soa_to_aos(soa, type.component_count, aos, type.stride_in_bytes, count);
+				});
+				std::cout << "  " << std::left << std::setw(10) << level_name << std::right
+					<< std::setw(8) << gigabytes_per_second(bytes, to_soa) << " GB/s to SoA"
+					<< std::setw(8) << gigabytes_per_second(bytes, to_aos) << " GB/s to AoS\n";
+			});
+		}
+	}
+}
+
+// Float streams to halves and back, with 50K floats in cache and 3M in memory, against a scalar loop. In GB/s of
+// floats and halves read plus written. The values are normally distributed with a standard deviation of 100, so
+// that some are subnormal or overflow as halves.
+void benchmark_half_conversion()
+{
+	for (u64 count : { 50000 + 7, 3000000 + 7 })
+	{
+		u32 repetition_count = (count < 100000) ? 200 : 10;
+
+		std::vector<float> floats(count);
+		std::vector<float> converted_floats(count);
+		std::vector<half> halves(count);
+		std::vector<half> expected_halves(count);
+
+		std::mt19937 random(1);
+		std::normal_distribution<float> distribution(0.f, 100.f);
+		for (float& f : floats)
+		{
+			f = distribution(random);
+		}
+
+		u64 bytes = count * (sizeof(float) + sizeof(half));
+
+		std::cout << count << " floats\n";
+
+		double to_half = best_milliseconds(repetition_count, [&]()
+		{
+			for (u64 i = 0; i < count; ++i)
+			{
+				expected_halves[i] = half(floats[i]);
+			}
+			do_not_optimize(expected_halves.data());
+		});
+		double to_float = best_milliseconds(repetition_count, [&]()
+		{
+			for (u64 i = 0; i < count; ++i)
+			{
+				converted_floats[i] = (float)expected_halves[i];
+			}
+			do_not_optimize(converted_floats.data());
+		});
+		std::cout << "  " << std::left << std::setw(10) << "Scalar" << std::right
+			<< std::setw(8) << gigabytes_per_second(bytes, to_half) << " GB/s to half"
+			<< std::setw(8) << gigabytes_per_second(bytes, to_float) << " GB/s to float\n";
+
+		for_each_simd_level([&](const char* level_name)
+		{
+			double to_half = best_milliseconds(repetition_count, [&]()
+			{
+				float_to_half(floats.data(), halves.data(), count);
+			});
+			double to_float = best_milliseconds(repetition_count, [&]()
+			{
+				half_to_float(halves.data(), converted_floats.data(), count);
+			});
+
+			std::cout << "  " << std::left << std::setw(10) << level_name << std::right
+				<< std::setw(8) << gigabytes_per_second(bytes, to_half) << " GB/s to half"
+				<< std::setw(8) << gigabytes_per_second(bytes, to_float) << " GB/s to float\n";
+		});
+	}
+}
+
+void print_random_rates(const char* name, double floats, double vec2s, double hemisphere_samples)
+{
+	std::cout << "  " << std::left << std::setw(6) << name << std::right
+		<< std::setw(8) << floats << " float"
+		<< std::setw(8) << vec2s << " vec2"
+		<< std::setw(8) << hemisphere_samples << " cosine weighted hemisphere\n";
+}
+
+// Random floats, vec2s and cosine weighted hemisphere samples for every pixel of a 1024 x 1024 image, in million
+// samples per second. One pixel at a time with u32, then the wide ints at every instruction set level (see
+// wide_benchmarks_impl.h).
+void benchmark_random()
+{
+	const u32 width = 1024, height = 1024;
+
+	float sum = 0.f;
+	auto samples_per_second = [&](auto&& sample)
+	{
+		double milliseconds = best_milliseconds(5, [&]()
+		{
+			for (u32 y = 0; y < height; ++y)
+			{
+				for (u32 x = 0; x < width; ++x)
+				{
+					sum += sample(x, y);
+				}
+			}
+			do_not_optimize(&sum);
+		});
+		return width * height / (milliseconds * 1e3);
+	};
+
+	double floats = samples_per_second([](u32 x, u32 y) { return random_float<u32>(x, y, 0, 1); });
+	double vec2s = samples_per_second([](u32 x, u32 y)
+	{
+		vec2 E = random_vec2(x, y, 0, 1);
+		return E.x + E.y;
+	});
+	double hemisphere_samples = samples_per_second([](u32 x, u32 y)
+	{
+		vec4 direction = cosine_sample_hemisphere(random_vec2(x, y, 0, 1));
+		return direction.x + direction.y + direction.z;
+	});
+
+	std::cout << "Scalar:\n";
+	print_random_rates("u32", floats, vec2s, hemisphere_samples);
+
+	run_wide_benchmark(WideBenchmark::Random);
+}
+
+// 1M points transformed with a mat4, a Transform and a dual_quat, against scalar loops over transform_position,
+// in ms.
+void benchmark_transform_positions()
+{
+	const u64 count = 1000000 + 7;
+	const u32 repetition_count = 20;
+
+	std::vector<vec3> positions(count);
+	std::vector<vec3> result(count);
+	std::vector<vec3> expected(count);
+	for (u64 i = 0; i < count; ++i)
+	{
+		positions[i] = vec3((float)(i % 1000), (float)(i % 777) * 0.5f, -(float)(i % 313));
+	}
+
+	quat rotation = normalize(quat(vec3(0.3f, 1.f, 0.2f), 0.7f));
+	Transform transform(vec3(1.f, 2.f, 3.f), rotation, vec3(2.f, 3.f, 0.5f));
+	mat4 m = transform_to_mat4(transform);
+	dual_quat q(rotation, vec3(1.f, 2.f, 3.f));
+
+	auto scalar_milliseconds = [&](const auto& t)
+	{
+		return best_milliseconds(repetition_count, [&]()
+		{
+			for (u64 i = 0; i < count; ++i)
+			{
+				expected[i] = transform_position(t, positions[i]);
+			}
+			do_not_optimize(expected.data());
+		});
+	};
+	double dual_quat_milliseconds = scalar_milliseconds(q);
+	double transform_milliseconds = scalar_milliseconds(transform);
+	double mat4_milliseconds = scalar_milliseconds(m);
+
+	auto print_milliseconds = [](const char* name, double mat4_milliseconds, double transform_milliseconds, double dual_quat_milliseconds)
+	{
+		std::cout << "  " << std::left << std::setw(10) << name << std::right
+			<< std::setw(8) << mat4_milliseconds << " ms mat4"
+			<< std::setw(8) << transform_milliseconds << " ms Transform"
+			<< std::setw(8) << dual_quat_milliseconds << " ms dual_quat\n";
+	};
+
+	print_milliseconds("Scalar", mat4_milliseconds, transform_milliseconds, dual_quat_milliseconds);
+
+	for_each_simd_level([&](const char* level_name)
+	{
+		auto batched_milliseconds = [&](const auto& t)
+		{
+			return best_milliseconds(repetition_count, [&]()
+			{
+				transform_positions(t, Range<vec3>(positions.data(), count), Range<vec3>(result.data(), count));
+			});
+		};
+		double dual_quat_milliseconds = batched_milliseconds(q);
+		double transform_milliseconds = batched_milliseconds(transform);
+		double mat4_milliseconds = batched_milliseconds(m);
+
+		print_milliseconds(level_name, mat4_milliseconds, transform_milliseconds, dual_quat_milliseconds);
+	});
+}
+
+// The batched matrix functions for 10K matrices in cache and 1M in memory, against scalar loops, in ms. The scalar
+// version of transforms_to_rows_3x4 is transpose(transform_to_mat4(t)), of which the top three rows are copied.
+void benchmark_matrices()
+{
+	struct Rows3x4
+	{
+		float m[12];
+	};
+
+	for (u64 count : { 10000, 1000000 })
+	{
+		u32 repetition_count = (count < 100000) ? 200 : 10;
+
+		std::vector<Transform> transforms(count);
+		std::vector<mat4> a(count), b(count), result(count);
+		std::vector<Rows3x4> rows(count);
+		for (u64 i = 0; i < count; ++i)
+		{
+			float f = (float)i;
+			transforms[i] = Transform(vec3(f * 0.1f, 2.f - f * 0.01f, 3.f), normalize(quat(vec3(0.3f + f * 0.001f, 1.f, 0.2f), 0.7f + f)), vec3(1.f + (i % 7) * 0.3f, 2.f, 0.5f));
+			a[i] = transform_to_mat4(transforms[i]);
+			b[i] = transform_to_mat4(Transform(vec3(1.f, -2.f, f), normalize(quat(vec3(1.f, 0.5f, f), 0.3f)), vec3(1.5f)));
+			b[i].m30 = 0.1f;
+			b[i].m31 = 0.2f * (i % 3);
+		}
+
+		auto print_milliseconds = [](const char* name, const double (&milliseconds)[5])
+		{
+			std::cout << "  " << std::left << std::setw(10) << name << std::right << std::setprecision(3);
+			for (double m : milliseconds)
+			{
+				std::cout << std::setw(10) << m;
+			}
+			std::cout << std::setprecision(2) << '\n';
+		};
+
+		std::cout << count << " matrices, in ms\n" << std::setw(22) << "multiply" << std::setw(10) << "invert" << std::setw(10) << "affine"
+			<< std::setw(10) << "to_mat4" << std::setw(10) << "rows_3x4" << '\n';
+
+		double scalar_milliseconds[] =
+		{
+			best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					result[i] = a[i] * b[i];
+				}
+				do_not_optimize(result.data());
+			}),
+			best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					result[i] = invert(b[i]);
+				}
+				do_not_optimize(result.data());
+			}),
+			best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					result[i] = invert_affine_matrix(a[i]);
+				}
+				do_not_optimize(result.data());
+			}),
+			best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					result[i] = transform_to_mat4(transforms[i]);
+				}
+				do_not_optimize(result.data());
+			}),
+			best_milliseconds(repetition_count, [&]()
+			{
+				for (u64 i = 0; i < count; ++i)
+				{
+					mat4 m = transpose(transform_to_mat4(transforms[i]));
+					memcpy(rows[i].m, m.m, sizeof(Rows3x4));
+				}
+				do_not_optimize(rows.data());
+			}),
+		};
+		print_milliseconds("Scalar", scalar_milliseconds);
+
+		for_each_simd_level([&](const char* level_name)
+		{
+			double milliseconds[] =
+			{
+				best_milliseconds(repetition_count, [&]() { multiply(Range<mat4>(a.data(), count), Range<mat4>(b.data(), count), Range<mat4>(result.data(), count)); }),
+				best_milliseconds(repetition_count, [&]() { invert(Range<mat4>(b.data(), count), Range<mat4>(result.data(), count)); }),
+				best_milliseconds(repetition_count, [&]() { invert_affine_matrices(Range<mat4>(a.data(), count), Range<mat4>(result.data(), count)); }),
+				best_milliseconds(repetition_count, [&]() { transforms_to_mat4(Range<Transform>(transforms.data(), count), Range<mat4>(result.data(), count)); }),
+				best_milliseconds(repetition_count, [&]() { transforms_to_rows_3x4(transforms.data(), sizeof(Transform), rows[0].m, sizeof(Rows3x4), count); }),
+			};
+			print_milliseconds(level_name, milliseconds);
+		});
+	}
+}
+
+// The box around 16K points in cache and 1M in memory, against a scalar loop over grow, in ms.
+void benchmark_aabb_grow()
+{
+	for (u64 count : { 16384, 1000000 + 3 })
+	{
+		u32 repetition_count = (count < 100000) ? 200 : 20;
+
+		std::vector<vec3> points(count);
+		for (u64 i = 0; i < count; ++i)
+		{
+			points[i] = vec3(sinf(i * 0.37f) * 100.f, cosf(i * 0.11f) * 50.f, (float)(i % 977) - 400.f);
+		}
+
+		AABB expected;
+		double scalar_milliseconds = best_milliseconds(repetition_count, [&]()
+		{
+			expected = AABB::empty;
+			for (u64 i = 0; i < count; ++i)
+			{
+				expected = grow(expected, points[i]);
+			}
+			do_not_optimize(&expected);
+		});
+
+		std::cout << count << " points\n" << std::setprecision(3);
+		std::cout << "  " << std::left << std::setw(10) << "Scalar" << std::right << std::setw(8) << scalar_milliseconds << " ms\n";
+
+		for_each_simd_level([&](const char* level_name)
+		{
+			AABB box;
+			double milliseconds = best_milliseconds(repetition_count, [&]()
+			{
+				box = grow(AABB::empty, Range<vec3>(points.data(), count));
+				do_not_optimize(&box);
+			});
+
+			std::cout << "  " << std::left << std::setw(10) << level_name << std::right << std::setw(8) << milliseconds << " ms\n";
+		});
+		std::cout << std::setprecision(2);
+	}
+}
+
+static RayBenchmarkScene ray_benchmark_scene;
+
+const RayBenchmarkScene& get_ray_benchmark_scene()
+{
+	return ray_benchmark_scene;
+}
+
+// 1000 rays against 4096 boxes, each ray against all boxes, in ms. A scalar slab test here, then intersect_ray in
+// wide_math.h at every instruction set level (see wide_benchmarks_impl.h).
+void benchmark_intersect_ray()
+{
+	const u64 box_count = 4096;
+	const u64 ray_count = 1000;
+
+	std::vector<AABB> boxes(box_count);
+	for (u64 i = 0; i < box_count; ++i)
+	{
+		vec3 center(sinf(i * 1.3f) * 20.f, cosf(i * 0.7f) * 20.f, (float)(i % 41) - 20.f);
+		boxes[i] = AABB(center - vec3(1.f + i % 3), center + vec3(1.5f));
+	}
+
+	std::vector<vec3> origins(ray_count);
+	std::vector<vec3> inv_directions(ray_count);
+	for (u64 r = 0; r < ray_count; ++r)
+	{
+		origins[r] = vec3(sinf(r * 0.1f) * 30.f, 0.f, -40.f);
+		inv_directions[r] = 1.f / vec3(-sinf(r * 0.1f) * 0.5f + 0.3f * cosf(r * 0.31f), 0.05f * sinf(r * 1.7f), 1.f);
+	}
+
+	u64 hit_count = 0;
+	double milliseconds = best_milliseconds(5, [&]()
+	{
+		hit_count = 0;
+		for (u64 r = 0; r < ray_count; ++r)
+		{
+			for (const AABB& box : boxes)
+			{
+				vec3 t0 = (box.min_corner - origins[r]) * inv_directions[r];
+				vec3 t1 = (box.max_corner - origins[r]) * inv_directions[r];
+				float entry = max(max(min(t0.x, t1.x), min(t0.y, t1.y)), max(min(t0.z, t1.z), 0.f));
+				float exit = min(min(max(t0.x, t1.x), max(t0.y, t1.y)), min(max(t0.z, t1.z), FLT_MAX));
+				hit_count += (entry <= exit);
+			}
+		}
+		do_not_optimize(&hit_count);
+	});
+
+	std::cout << "Scalar:\n  " << std::left << std::setw(6) << "AABB" << std::right << std::setw(8) << milliseconds << " ms, " << hit_count << " hits\n";
+
+	ray_benchmark_scene.boxes.assign(&boxes[0].min_corner.x, &boxes[0].min_corner.x + 6 * box_count);
+	ray_benchmark_scene.origins.assign(&origins[0].x, &origins[0].x + 3 * ray_count);
+	ray_benchmark_scene.inv_directions.assign(&inv_directions[0].x, &inv_directions[0].x + 3 * ray_count);
+
+	run_wide_benchmark(WideBenchmark::IntersectRay);
+}
@@ -0,0 +1,211 @@
+#include "benchmark.h"
+#include "core/memory.h"
+#include "core/tlsf.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Fills a 512 MB arena with 512 byte allocations, touching each one, with the default and with large page commits.
+void benchmark_arena_commit()
+{
+	const u64 arena_size = MB(512);
+	const u64 allocation_size = 512;
+
+	for (bool use_large_pages : { false, true })
+	{
+		double best = 1e30;
+		u64 page_faults = 0;
+
+		for (u32 repetition = 0; repetition < 3; ++repetition)
+		{
+			Arena arena(arena_size, use_large_pages);
+
+			u64 page_faults_before = get_page_fault_count();
+			BenchmarkTimer timer;
+
+			for (u64 i = 0; i < arena_size / allocation_size; ++i)
+			{
+				u8* allocation = (u8*)arena.allocate(allocation_size, 16);
+				allocation[0] = 1;
+				allocation[allocation_size - 1] = 1;
+			}
+
+			best = min(best, timer.milliseconds());
+			page_faults = get_page_fault_count() - page_faults_before;
+		}
+
+		std::cout << std::left << std::setw(16) << (use_large_pages ? "Large pages" : "Default") << std::right
+			<< std::setw(10) << best << " ms"
+			<< std::setw(10) << page_faults << " page faults\n";
+	}
+}
+
+// 16M allocations of 16 to 143 bytes with alignments of 1 to 64, split evenly over 1 to 8 threads, or up to the
+// number of hardware threads if there are more.
+void benchmark_concurrent_arena()
+{
+	const u64 allocation_count = 1 << 24;
+	const u32 max_thread_count = max(8u, std::thread::hardware_concurrency());
+
+	for (u32 thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+	{
+		ConcurrentArena arena(GB(4));
+
+		BenchmarkTimer timer;
+
+		std::vector<std::thread> threads;
+		for (u32 t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back([&arena, t, thread_count]()
+			{
+				u32 random = t * 7919 + 1;
+				for (u64 i = 0; i < allocation_count / thread_count; ++i)
+				{
+					random = random * 1664525 + 1013904223;
+					u64 size = 16 + ((random >> 16) & 127);
+					u64 alignment = 1ull << (((random >> 8) & 3) * 2);
+
+					u8* allocation = (u8*)arena.allocate(size, alignment);
+					allocation[0] = 1;
+					allocation[size - 1] = 1;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		double milliseconds = timer.milliseconds();
+
+		std::cout << std::setw(2) << thread_count << " threads"
+			<< std::setw(10) << milliseconds << " ms"
+			<< std::setw(10) << (allocation_count / milliseconds / 1000.0) << " M allocations/s\n";
+	}
+}
+
+struct AllocatorFunctions
+{
+	const char* name;
+	void* (*allocate)(u64 size);
+	void (*free)(void* memory);
+};
+
+static const AllocatorFunctions tlsf_and_malloc[] =
+{
+	{ "TLSF", [](u64 size) { return get_object_allocator().allocate(size); }, [](void* memory) { get_object_allocator().free(memory); } },
+	{ "malloc", [](u64 size) { return malloc(size); }, [](void* memory) { free(memory); } },
+};
+
+// Random allocations and frees over slot_count slots. 7 of 8 sizes are 16 to 527 bytes, the rest up to 64 KB.
+static void allocate_and_free_randomly(const AllocatorFunctions& allocator, u32 seed, u32 slot_count, u32 operation_count, std::vector<double>* latencies, u64* peak_bytes)
+{
+	struct Slot
+	{
+		u8* memory;
+		u32 size;
+	};
+
+	std::vector<Slot> slots(slot_count, Slot{ nullptr, 0 });
+	u64 live_bytes = 0;
+
+	u32 random = seed;
+	auto next_random = [&random]() { random ^= random << 13; random ^= random >> 17; random ^= random << 5; return random; };
+
+	for (u32 i = 0; i < operation_count; ++i)
+	{
+		Slot& slot = slots[next_random() % slot_count];
+
+		auto start = std::chrono::high_resolution_clock::now();
+		if (slot.memory)
+		{
+			allocator.free(slot.memory);
+			live_bytes -= slot.size;
+			slot.memory = nullptr;
+		}
+		else
+		{
+			slot.size = (next_random() % 8 == 0) ? 16 + next_random() % KB(64) : 16 + next_random() % 512;
+			slot.memory = (u8*)allocator.allocate(slot.size);
+			slot.memory[0] = 1;
+			live_bytes += slot.size;
+		}
+
+		if (latencies)
+		{
+			latencies->push_back(std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		if (peak_bytes)
+		{
+			*peak_bytes = max(*peak_bytes, live_bytes);
+		}
+	}
+
+	for (Slot& slot : slots)
+	{
+		allocator.free(slot.memory);
+	}
+}
+
+// Latency percentiles of 2M random operations on one thread, and the pool overhead of TLSF over the peak of live
+// bytes. Then the same pattern on 1 to 8 threads, each with its own slots.
+void benchmark_tlsf()
+{
+	const u32 slot_count = 20000;
+	const u32 operation_count = 2000000;
+
+	for (const AllocatorFunctions& allocator : tlsf_and_malloc)
+	{
+		std::vector<double> latencies;
+		latencies.reserve(operation_count);
+		u64 peak_bytes = 0;
+		u64 pool_bytes_before = get_object_allocator().get_stats().pool_bytes;
+
+		BenchmarkTimer timer;
+		allocate_and_free_randomly(allocator, 12345, slot_count, operation_count, &latencies, &peak_bytes);
+		double milliseconds = timer.milliseconds();
+
+		std::sort(latencies.begin(), latencies.end());
+
+		std::cout << std::left << std::setw(8) << allocator.name << std::right
+			<< std::setw(10) << milliseconds << " ms, p50"
+			<< std::setw(8) << latencies[latencies.size() / 2] << " ns, p99"
+			<< std::setw(8) << latencies[latencies.size() * 99 / 100] << " ns, p99.99"
+			<< std::setw(10) << latencies[latencies.size() * 9999 / 10000] << " ns";
+
+		if (&allocator == &tlsf_and_malloc[0])
+		{
+			u64 pool_bytes = get_object_allocator().get_stats().pool_bytes - pool_bytes_before;
+			std::cout << ", pools " << (100.0 * pool_bytes / peak_bytes - 100.0) << "% above peak live bytes";
+		}
+		std::cout << '\n';
+	}
+
+	const u32 max_thread_count = max(8u, std::thread::hardware_concurrency());
+	for (u32 thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+	{
+		std::cout << std::setw(2) << thread_count << " threads";
+		for (const AllocatorFunctions& allocator : tlsf_and_malloc)
+		{
+			BenchmarkTimer timer;
+
+			std::vector<std::thread> threads;
+			for (u32 t = 0; t < thread_count; ++t)
+			{
+				threads.emplace_back([&allocator, t, thread_count]()
+				{
+					allocate_and_free_randomly(allocator, 12345 + t, slot_count / thread_count, operation_count / thread_count, nullptr, nullptr);
+				});
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			std::cout << ", " << allocator.name << std::setw(10) << timer.milliseconds() << " ms";
+		}
+		std::cout << '\n';
+	}
+}
@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx2
+#include "simd_math_benchmarks_impl.h"
+
+bool run_simd_math_benchmarks_avx2()
+{
+#if defined(SIMD_AVX_2) && defined(SIMD_FMA)
+	avx2::run_simd_math_benchmarks();
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx512
+#include "simd_math_benchmarks_impl.h"
+
+bool run_simd_math_benchmarks_avx512()
+{
+#if defined(SIMD_AVX_512) && defined(SIMD_FMA)
+	avx512::run_simd_math_benchmarks();
+	return true;
+#else
+	return false;
+#endif
+}
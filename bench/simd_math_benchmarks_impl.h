@@ -0,0 +1,267 @@
+// Accuracy and speed of the transcendental functions in simd.h, the figures quoted in its comments. Included once
+// by every simd_math_benchmarks_<level>.cpp. Like simd_kernels_impl.h, these define SIMD_NAMESPACE first and are
+// compiled with the instruction set flags of their level, so every level is measured the way it ships.
+
+#if !defined(SIMD_NAMESPACE)
+#error Define SIMD_NAMESPACE before including simd_math_benchmarks_impl.h.
+#endif
+
+#include "core/simd.h"
+#include "benchmark.h"
+
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace SIMD_NAMESPACE {
+
+enum class MathFunction
+{
+	Cos,
+	Sin,
+	Exp2,
+	Log2,
+	Exp,
+	Pow,
+	Tanh,
+	Atan,
+	Atan2,
+	Acos,
+};
+
+template <MathFunction function, Precision precision, typename float_t>
+static float_t evaluate(float_t x, float_t y)
+{
+	if constexpr (function == MathFunction::Cos) { return cos<precision>(x); }
+	if constexpr (function == MathFunction::Sin) { return sin<precision>(x); }
+	if constexpr (function == MathFunction::Exp2) { return exp2<precision>(x); }
+	if constexpr (function == MathFunction::Log2) { return log2<precision>(x); }
+	if constexpr (function == MathFunction::Exp) { return exp<precision>(x); }
+	if constexpr (function == MathFunction::Pow) { return pow<precision>(x, y); }
+	if constexpr (function == MathFunction::Tanh) { return tanh<precision>(x); }
+	if constexpr (function == MathFunction::Atan) { return atan<precision>(x); }
+	if constexpr (function == MathFunction::Atan2) { return atan2<precision>(y, x); }
+	if constexpr (function == MathFunction::Acos) { return acos<precision>(x); }
+}
+
+// Arguments of one function, with the double precision libm result of each.
+struct MathSweep
+{
+	const char* name;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<double> reference;
+	float (*libm)(float x, float y);
+};
+
+template <typename F>
+static std::vector<float> generate_arguments(u64 count, u32 seed, F&& generate)
+{
+	std::mt19937 random(seed);
+	std::vector<float> arguments(count);
+	for (float& argument : arguments)
+	{
+		argument = generate(random);
+	}
+	return arguments;
+}
+
+static std::vector<float> uniform_arguments(u64 count, u32 seed, double low, double high)
+{
+	std::uniform_real_distribution<double> distribution(low, high);
+	return generate_arguments(count, seed, [&](std::mt19937& random) { return (float)distribution(random); });
+}
+
+// Uniform in the logarithm, for functions of positive arguments over many orders of magnitude.
+static std::vector<float> logarithmic_arguments(u64 count, u32 seed, double low, double high)
+{
+	std::uniform_real_distribution<double> distribution(std::log(low), std::log(high));
+	return generate_arguments(count, seed, [&](std::mt19937& random) { return (float)std::exp(distribution(random)); });
+}
+
+template <typename F>
+static MathSweep create_sweep(const char* name, std::vector<float> x, std::vector<float> y, F&& reference, float (*libm)(float x, float y))
+{
+	MathSweep sweep = { name, std::move(x), std::move(y), {}, libm };
+	sweep.reference.resize(sweep.x.size());
+	for (u64 i = 0; i < sweep.x.size(); ++i)
+	{
+		sweep.reference[i] = reference((double)sweep.x[i], (double)sweep.y[i]);
+	}
+	return sweep;
+}
+
+// Distance between adjacent floats at the magnitude of value. Below the smallest normal float, that of the
+// smallest normal float.
+static double ulp_at(double value)
+{
+	float magnitude = max((float)std::abs(value), FLT_MIN);
+	return (double)(std::nextafter(magnitude, FLT_MAX) - magnitude);
+}
+
+template <MathFunction function, Precision precision, typename float_t>
+static void evaluate_sweep(const MathSweep& sweep, std::vector<float>& results)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	results.resize(sweep.x.size());
+	for (u64 i = 0; i + lane_count <= sweep.x.size(); i += lane_count)
+	{
+		evaluate<function, precision>(float_t(&sweep.x[i]), float_t(&sweep.y[i])).store(&results[i]);
+	}
+}
+
+// TSC cycles per element for the first 4096 arguments, which stay in the L1 cache. Best of 200 runs.
+template <MathFunction function, Precision precision, typename float_t>
+static double measure_cycles(const MathSweep& sweep)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	constexpr u32 count = 4096;
+
+	alignas(64) float results[count];
+	double best = 1e30;
+	for (u32 repetition = 0; repetition < 200; ++repetition)
+	{
+		u64 start = read_cycle_counter();
+		for (u32 i = 0; i < count; i += lane_count)
+		{
+			evaluate<function, precision>(float_t(&sweep.x[i]), float_t(&sweep.y[i])).store(&results[i]);
+		}
+		best = min(best, (double)(read_cycle_counter() - start) / count);
+		do_not_optimize(results);
+	}
+	return best;
+}
+
+static double measure_libm_cycles(const MathSweep& sweep)
+{
+	constexpr u32 count = 4096;
+
+	static float results[count];
+	double best = 1e30;
+	for (u32 repetition = 0; repetition < 200; ++repetition)
+	{
+		u64 start = read_cycle_counter();
+		for (u32 i = 0; i < count; ++i)
+		{
+			results[i] = sweep.libm(sweep.x[i], sweep.y[i]);
+		}
+		best = min(best, (double)(read_cycle_counter() - start) / count);
+		do_not_optimize(results);
+	}
+	return best;
+}
+
+// Prints the errors against double precision libm and the speed of one width.
+template <MathFunction function, Precision precision, typename float_t>
+static void benchmark_sweep(const MathSweep& sweep, const char* precision_name, const char* width_name)
+{
+	std::vector<float> results;
+	evaluate_sweep<function, precision, float_t>(sweep, results);
+
+	// The domains of all sweeps are chosen so that every reference is finite.
+	double max_absolute = 0.0, max_relative = 0.0, max_ulp = 0.0, sum_ulp = 0.0;
+	for (u64 i = 0; i < sweep.x.size(); ++i)
+	{
+		double reference = sweep.reference[i];
+		double absolute = std::abs((double)results[i] - reference);
+		double ulp = absolute / ulp_at(reference);
+
+		max_absolute = max(max_absolute, absolute);
+		max_ulp = max(max_ulp, ulp);
+		sum_ulp += ulp;
+		if (std::abs(reference) > 1e-30)
+		{
+			max_relative = max(max_relative, absolute / std::abs(reference));
+		}
+	}
+
+	std::cout << "  " << std::left << std::setw(8) << sweep.name << std::setw(10) << precision_name << std::setw(5) << width_name << std::right
+		<< std::scientific << std::setprecision(2)
+		<< std::setw(11) << max_absolute
+		<< std::setw(11) << max_relative
+		<< std::setw(11) << max_ulp
+		<< std::setw(11) << (sum_ulp / sweep.x.size())
+		<< std::fixed
+		<< std::setw(8) << measure_cycles<function, precision, float_t>(sweep) << '\n';
+}
+
+// Only the widths with instructions at this level, the others fall back to simd_scalar.h.
+template <MathFunction function, Precision precision>
+static void benchmark_widths(const MathSweep& sweep, const char* precision_name)
+{
+	benchmark_sweep<function, precision, w4_float>(sweep, precision_name, "w4");
+#if defined(SIMD_AVX_2)
+	benchmark_sweep<function, precision, w8_float>(sweep, precision_name, "w8");
+#endif
+#if defined(SIMD_AVX_512)
+	benchmark_sweep<function, precision, w16_float>(sweep, precision_name, "w16");
+#endif
+}
+
+template <MathFunction function>
+static void benchmark_function(const MathSweep& sweep)
+{
+	benchmark_widths<function, Precision::Fast>(sweep, "Fast");
+	benchmark_widths<function, Precision::Balanced>(sweep, "Balanced");
+	benchmark_widths<function, Precision::Accurate>(sweep, "Accurate");
+	std::cout << "  " << std::left << std::setw(8) << sweep.name << std::setw(15) << "libm" << std::right << std::setw(52) << measure_libm_cycles(sweep) << '\n';
+}
+
+static void run_simd_math_benchmarks()
+{
+	const u64 n = 1 << 22;
+	const double pi = 3.14159265358979323846;
+
+	std::vector<float> zeros(n, 0.f);
+
+	std::cout << "  " << std::left << std::setw(23) << "Function" << std::right
+		<< std::setw(11) << "Max abs" << std::setw(11) << "Max rel" << std::setw(11) << "Max ulp" << std::setw(11) << "Mean ulp"
+		<< std::setw(8) << "Cycles" << '\n';
+
+	benchmark_function<MathFunction::Cos>(create_sweep("cos", uniform_arguments(n, 1, -pi, pi), zeros,
+		[](double x, double) { return std::cos(x); }, [](float x, float) { return std::cos(x); }));
+	benchmark_function<MathFunction::Cos>(create_sweep("cos1000", uniform_arguments(n, 2, -1000.0, 1000.0), zeros,
+		[](double x, double) { return std::cos(x); }, [](float x, float) { return std::cos(x); }));
+	benchmark_function<MathFunction::Sin>(create_sweep("sin", uniform_arguments(n, 3, -pi, pi), zeros,
+		[](double x, double) { return std::sin(x); }, [](float x, float) { return std::sin(x); }));
+	benchmark_function<MathFunction::Exp2>(create_sweep("exp2", uniform_arguments(n, 4, -126.0, 127.9), zeros,
+		[](double x, double) { return std::exp2(x); }, [](float x, float) { return std::exp2(x); }));
+	benchmark_function<MathFunction::Log2>(create_sweep("log2", logarithmic_arguments(n, 5, 1e-37, 1e37), zeros,
+		[](double x, double) { return std::log2(x); }, [](float x, float) { return std::log2(x); }));
+	benchmark_function<MathFunction::Log2>(create_sweep("log2_1", uniform_arguments(n, 6, 0.5, 2.0), zeros,
+		[](double x, double) { return std::log2(x); }, [](float x, float) { return std::log2(x); }));
+	benchmark_function<MathFunction::Exp>(create_sweep("exp", uniform_arguments(n, 7, -87.0, 88.0), zeros,
+		[](double x, double) { return std::exp(x); }, [](float x, float) { return std::exp(x); }));
+	benchmark_function<MathFunction::Pow>(create_sweep("pow", logarithmic_arguments(n, 8, 1e-2, 1e2), uniform_arguments(n, 9, -4.0, 4.0),
+		[](double x, double y) { return std::pow(x, y); }, [](float x, float y) { return std::pow(x, y); }));
+	benchmark_function<MathFunction::Tanh>(create_sweep("tanh", uniform_arguments(n, 10, -10.0, 10.0), zeros,
+		[](double x, double) { return std::tanh(x); }, [](float x, float) { return std::tanh(x); }));
+
+	// Tangents of uniform angles, so that the whole real line is covered.
+	std::vector<float> tangents = uniform_arguments(n, 11, -pi / 2 + 1e-3, pi / 2 - 1e-3);
+	for (float& t : tangents)
+	{
+		t = std::tan(t);
+	}
+	benchmark_function<MathFunction::Atan>(create_sweep("atan", tangents, zeros,
+		[](double x, double) { return std::atan(x); }, [](float x, float) { return std::atan(x); }));
+
+	// Points at all angles and radii from 1e-3 to 1e3. x holds the x coordinates, y the y coordinates.
+	std::vector<float> angles = uniform_arguments(n, 12, -pi, pi);
+	std::vector<float> radii = logarithmic_arguments(n, 13, 1e-3, 1e3);
+	std::vector<float> xs(n), ys(n);
+	for (u64 i = 0; i < n; ++i)
+	{
+		xs[i] = radii[i] * std::cos(angles[i]);
+		ys[i] = radii[i] * std::sin(angles[i]);
+	}
+	benchmark_function<MathFunction::Atan2>(create_sweep("atan2", xs, ys,
+		[](double x, double y) { return std::atan2(y, x); }, [](float x, float y) { return std::atan2(y, x); }));
+
+	benchmark_function<MathFunction::Acos>(create_sweep("acos", uniform_arguments(n, 14, -1.0, 1.0), zeros,
+		[](double x, double) { return std::acos(x); }, [](float x, float) { return std::acos(x); }));
+}
+
+}
@@ -0,0 +1,8 @@
+#define SIMD_NAMESPACE sse2
+#include "simd_math_benchmarks_impl.h"
+
+bool run_simd_math_benchmarks_sse2()
+{
+	sse2::run_simd_math_benchmarks();
+	return true;
+}
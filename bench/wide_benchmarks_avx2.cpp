@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx2
+#include "wide_benchmarks_impl.h"
+
+bool run_wide_benchmark_avx2(WideBenchmark benchmark)
+{
+#if defined(SIMD_AVX_2) && defined(SIMD_FMA)
+	avx2::run_wide_benchmark(benchmark);
+	return true;
+#else
+	return false;
+#endif
+}
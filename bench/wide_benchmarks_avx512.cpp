@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx512
+#include "wide_benchmarks_impl.h"
+
+bool run_wide_benchmark_avx512(WideBenchmark benchmark)
+{
+#if defined(SIMD_AVX_512) && defined(SIMD_FMA)
+	avx512::run_wide_benchmark(benchmark);
+	return true;
+#else
+	return false;
+#endif
+}
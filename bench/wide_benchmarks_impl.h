@@ -0,0 +1,237 @@
+// Benchmark cases of the wide types in simd.h, which have to be compiled once per instruction set level. Included
+// once by every wide_benchmarks_<level>.cpp, which define SIMD_NAMESPACE first, like simd_math_benchmarks_impl.h.
+
+#if !defined(SIMD_NAMESPACE)
+#error Define SIMD_NAMESPACE before including wide_benchmarks_impl.h.
+#endif
+
+#include "core/random.h"
+#include "core/simd.h"
+#include "benchmark.h"
+
+#include <random>
+#include <vector>
+
+namespace SIMD_NAMESPACE {
+
+static void print_rate(const char* name, double rate, const char* unit)
+{
+	std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(8) << rate << ' ' << unit << '\n';
+}
+
+// Stream compaction of 10M uniform floats in [0, 1) with x < t, at 1%, 50% and 99% selectivity, in G elements/s.
+// A branchy and a branchless scalar loop, compiled with the flags of this level, against compress_store. SimdTests
+// checks the results of compress_store.
+static void run_compress_store_benchmarks()
+{
+	const u64 count = 10000000;
+
+	std::vector<float> input(count);
+	std::vector<float> output(count + 16);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(0.f, 1.f);
+	for (float& x : input)
+	{
+		x = distribution(random);
+	}
+
+	for (float threshold : { 0.01f, 0.5f, 0.99f })
+	{
+		auto report = [&](const char* name, u64 (*filter)(const float* input, float* output, u64 count, float threshold))
+		{
+			double milliseconds = best_milliseconds(5, [&]()
+			{
+				filter(input.data(), output.data(), count, threshold);
+				do_not_optimize(output.data());
+			});
+			print_rate(name, count / (milliseconds * 1e6), "G elements/s");
+		};
+
+		std::cout << "  Selectivity " << (u32)(threshold * 100.f + 0.5f) << "%\n";
+
+		report("Scalar branchy", [](const float* input, float* output, u64 count, float threshold)
+		{
+			u64 output_count = 0;
+			for (u64 i = 0; i < count; ++i)
+			{
+				if (input[i] < threshold)
+				{
+					output[output_count++] = input[i];
+				}
+			}
+			return output_count;
+		});
+		report("Scalar branchless", [](const float* input, float* output, u64 count, float threshold)
+		{
+			u64 output_count = 0;
+			for (u64 i = 0; i < count; ++i)
+			{
+				output[output_count] = input[i];
+				output_count += (input[i] < threshold);
+			}
+			return output_count;
+		});
+
+		// count is a multiple of 16, so there is no tail.
+		report("w4", [](const float* input, float* output, u64 count, float threshold)
+		{
+			float* end = output;
+			for (u64 i = 0; i < count; i += 4)
+			{
+				w4_float x = input + i;
+				end += compress_store(end, x, to_bit_mask(x < threshold));
+			}
+			return (u64)(end - output);
+		});
+#if defined(SIMD_AVX_2)
+		report("w8", [](const float* input, float* output, u64 count, float threshold)
+		{
+			float* end = output;
+			for (u64 i = 0; i < count; i += 8)
+			{
+				w8_float x = input + i;
+				end += compress_store(end, x, to_bit_mask(x < threshold));
+			}
+			return (u64)(end - output);
+		});
+#endif
+#if defined(SIMD_AVX_512)
+		report("w16", [](const float* input, float* output, u64 count, float threshold)
+		{
+			float* end = output;
+			for (u64 i = 0; i < count; i += 16)
+			{
+				w16_float x = input + i;
+				end += compress_store(end, x, to_bit_mask(x < threshold));
+			}
+			return (u64)(end - output);
+		});
+#endif
+	}
+}
+
+// Lane l of the result is first + l.
+template <typename int_t>
+static int_t consecutive_ints(i32 first)
+{
+	alignas(64) i32 lanes[16];
+	for (i32 l = 0; l < 16; ++l)
+	{
+		lanes[l] = first + l;
+	}
+	return int_t(lanes);
+}
+
+// See benchmark_random.
+template <typename float_t, typename int_t>
+static void benchmark_random_width(const char* width_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	constexpr u32 width = 1024, height = 1024;
+
+	int_t lane_indices = consecutive_ints<int_t>(0);
+	float_t sum = 0.f;
+	auto samples_per_second = [&](auto&& sample)
+	{
+		double milliseconds = best_milliseconds(5, [&]()
+		{
+			for (u32 y = 0; y < height; ++y)
+			{
+				for (u32 x = 0; x < width; x += lane_count)
+				{
+					sum += sample(lane_indices + int_t((i32)x), int_t((i32)y));
+				}
+			}
+			do_not_optimize(&sum);
+		});
+		return width * height / (milliseconds * 1e3);
+	};
+
+	double floats = samples_per_second([](int_t x, int_t y) { return random_float(x, y, int_t(0), int_t(1)); });
+	double vec2s = samples_per_second([](int_t x, int_t y)
+	{
+		wN_vec2<float_t> E = random_vec2(x, y, int_t(0), int_t(1));
+		return E.x + E.y;
+	});
+	double hemisphere_samples = samples_per_second([](int_t x, int_t y)
+	{
+		wN_vec4<float_t> direction = cosine_sample_hemisphere(random_vec2(x, y, int_t(0), int_t(1)));
+		return direction.x + direction.y + direction.z;
+	});
+
+	print_random_rates(width_name, floats, vec2s, hemisphere_samples);
+}
+
+static void run_random_benchmarks()
+{
+	benchmark_random_width<w4_float, w4_int>("w4");
+#if defined(SIMD_AVX_2)
+	benchmark_random_width<w8_float, w8_int>("w8");
+#endif
+#if defined(SIMD_AVX_512)
+	benchmark_random_width<w16_float, w16_int>("w16");
+#endif
+}
+
+// See benchmark_intersect_ray. The boxes are loaded into groups of lane_count first.
+template <typename float_t>
+static void benchmark_intersect_ray_width(const char* width_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	const RayBenchmarkScene& scene = get_ray_benchmark_scene();
+	u64 group_count = scene.boxes.size() / (6 * lane_count);
+	u64 ray_count = scene.origins.size() / 3;
+
+	std::vector<wN_AABB<float_t>> groups(group_count);
+	for (u64 g = 0; g < group_count; ++g)
+	{
+		groups[g] = load_aabbs<float_t>(&scene.boxes[6 * lane_count * g]);
+	}
+
+	u64 hit_count = 0;
+	double milliseconds = best_milliseconds(5, [&]()
+	{
+		hit_count = 0;
+		for (u64 r = 0; r < ray_count; ++r)
+		{
+			const float* origin = &scene.origins[3 * r];
+			const float* inv_direction = &scene.inv_directions[3 * r];
+			wN_vec3<float_t> wide_origin(origin[0], origin[1], origin[2]);
+			wN_vec3<float_t> wide_inv_direction(inv_direction[0], inv_direction[1], inv_direction[2]);
+
+			for (const wN_AABB<float_t>& group : groups)
+			{
+				float_t t_entry;
+				hit_count += count_set_bits((u32)intersect_ray(wide_origin, wide_inv_direction, group, float_t(0.f), float_t(FLT_MAX), t_entry));
+			}
+		}
+		do_not_optimize(&hit_count);
+	});
+
+	std::cout << "  " << std::left << std::setw(6) << width_name << std::right << std::setw(8) << milliseconds << " ms, " << hit_count << " hits\n";
+}
+
+static void run_intersect_ray_benchmarks()
+{
+	benchmark_intersect_ray_width<w4_float>("w4");
+#if defined(SIMD_AVX_2)
+	benchmark_intersect_ray_width<w8_float>("w8");
+#endif
+#if defined(SIMD_AVX_512)
+	benchmark_intersect_ray_width<w16_float>("w16");
+#endif
+}
+
+static void run_wide_benchmark(WideBenchmark benchmark)
+{
+	switch (benchmark)
+	{
+		case WideBenchmark::CompressStore: run_compress_store_benchmarks(); break;
+		case WideBenchmark::Random: run_random_benchmarks(); break;
+		case WideBenchmark::IntersectRay: run_intersect_ray_benchmarks(); break;
+	}
+}
+
+}
@@ -0,0 +1,8 @@
+#define SIMD_NAMESPACE sse2
+#include "wide_benchmarks_impl.h"
+
+bool run_wide_benchmark_sse2(WideBenchmark benchmark)
+{
+	sse2::run_wide_benchmark(benchmark);
+	return true;
+}
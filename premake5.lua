@@ -60,6 +60,39 @@ group ""
 -- GENERATE PROJECT
 -----------------------------------------
 
+-- Settings of every project which compiles src/core.
+function core_build_options()
+	floatingpoint "Fast"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "On"
+		inlining "Auto"
+
+	-- SIMD kernels are compiled once per instruction set and picked at runtime, see src/core/simd_kernels.h.
+	-- MSVC has no switch for SSE4.1.
+	filter { "files:**_sse4_1.cpp", "toolset:not msc*" }
+		buildoptions { "-msse4.1" }
+
+	filter { "files:**_avx2.cpp", "toolset:msc*" }
+		buildoptions { "/arch:AVX2" }
+
+	filter { "files:**_avx2.cpp", "toolset:not msc*" }
+		buildoptions { "-mavx2", "-mfma", "-mf16c" }
+
+	filter { "files:**_avx512.cpp", "toolset:msc*" }
+		buildoptions { "/arch:AVX512" }
+
+	filter { "files:**_avx512.cpp", "toolset:not msc*" }
+		buildoptions { "-mavx512f", "-mavx512vl", "-mavx512dq", "-mavx512bw", "-mfma", "-mf16c" }
+
+	filter {}
+end
+
 project "MinimalDX12Raytracing"
 	--location "bin/MinimalDX12Raytracing"
 	kind "ConsoleApp"
@@ -112,16 +145,6 @@ project "MinimalDX12Raytracing"
 	}
 
 	--vectorextensions "AVX2"
-	floatingpoint "Fast"
-
-	filter "configurations:Debug"
-        runtime "Debug"
-		symbols "On"
-		
-	filter "configurations:Release"
-        runtime "Release"
-		optimize "On"
-		inlining "Auto"
 
 	filter "system:windows"
 		systemversion (sdk_version_string)
@@ -134,6 +157,8 @@ project "MinimalDX12Raytracing"
 
 		defines { "SHADER_BIN_DIR=L\"" .. shaderoutputdir .. "\"" }
 
+	core_build_options()
+
 	filter "files:**.hlsl"
 		shadermodel "6.5"
 		shaderdefines {
@@ -193,4 +218,79 @@ project "MinimalDX12Raytracing"
 	filter("files:**_cs.hlsl")
 		removeflags("ExcludeFromBuild")
 		shadertype("Compute")
-		
\ No newline at end of file
+		
+
+-- Returns non-zero if a test failed.
+project "SimdTests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "Off"
+
+	targetdir ("./bin/" .. outputdir)
+	objdir ("./bin_int/" .. outputdir ..  "/%{prj.name}")
+	debugdir "."
+
+	files {
+		"tests/**.h",
+		"tests/**.cpp",
+		"src/core/common.h",
+		"src/core/cpu_features.h",
+		"src/core/cpu_features.cpp",
+		"src/core/simd.h",
+		"src/core/simd_scalar.h",
+		"src/core/simd_kernels*.h",
+		"src/core/simd_kernels*.cpp",
+		"src/core/math.h",
+		"src/core/math.cpp",
+		"src/core/half.h",
+		"src/core/half.cpp",
+		"src/core/random.h",
+		"src/core/range.h",
+		"src/core/wide_math.h",
+	}
+
+	includedirs {
+		"src",
+	}
+
+	core_build_options()
+
+	filter "system:windows"
+		systemversion (sdk_version_string)
+
+
+project "Benchmarks"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "Off"
+
+	targetdir ("./bin/" .. outputdir)
+	objdir ("./bin_int/" .. outputdir ..  "/%{prj.name}")
+	debugdir "."
+
+	-- Only the platform independent part of src/core, so that the benchmarks also build on Linux.
+	files {
+		"bench/**.h",
+		"bench/**.cpp",
+		"src/core/**.h",
+		"src/core/**.cpp",
+	}
+
+	removefiles {
+		"src/core/window.*",
+		"src/core/input.*",
+	}
+
+	includedirs {
+		"src",
+	}
+
+	core_build_options()
+
+	filter "system:windows"
+		systemversion (sdk_version_string)
+
+	filter "system:linux"
+		links { "pthread" }
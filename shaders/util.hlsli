@@ -2,6 +2,23 @@
 
 #define M_PI float(3.14159265358979323846)
 
+// Counter-based random numbers, the same bits as random_bits and random_float in src/core/random.h.
+static uint4 random_bits(uint pixel_x, uint pixel_y, uint sample, uint dimension)
+{
+    uint4 v = uint4(pixel_x, pixel_y, sample, dimension) * 1664525u + 1013904223u;
+
+    v.x += v.y * v.w; v.y += v.z * v.x; v.z += v.x * v.y; v.w += v.y * v.z;
+    v ^= v >> 16u;
+    v.x += v.y * v.w; v.y += v.z * v.x; v.z += v.x * v.y; v.w += v.y * v.z;
+
+    return v;
+}
+
+static float random_float(uint pixel_x, uint pixel_y, uint sample, uint dimension)
+{
+    return float(random_bits(pixel_x, pixel_y, sample, dimension).x >> 8) * (1.f / 16777216.f);
+}
+
 static float2 interpolate_attribute(float2 vertex_attribute[3], BuiltInTriangleIntersectionAttributes attribs)
 {
     return vertex_attribute[0] +
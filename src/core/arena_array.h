@@ -0,0 +1,80 @@
+#pragma once
+
+#include "memory.h"
+
+// Growable array which reserves address space for max_count elements up front and commits more pages as it grows.
+// Elements are never moved or copied on growth, so pointers and references to them stay valid until they are
+// removed by clear or the array is destroyed. There is no default for max_count: every array reserves and commits
+// at least one page, so small or numerous arrays are better off in a std::vector or a plain array.
+template <typename T>
+struct ArenaArray
+{
+	ArenaArray(const char* tag, u64 max_count) : arena(tag, max_count * sizeof(T)) {}
+	ArenaArray(const ArenaArray&) = delete;
+	ArenaArray(ArenaArray&& o) noexcept : arena(std::move(o.arena)), size(std::exchange(o.size, 0)) {}
+
+	void operator=(const ArenaArray&) = delete;
+	void operator=(ArenaArray&& o) noexcept
+	{
+		clear();
+		arena = std::move(o.arena);
+		size = std::exchange(o.size, 0);
+	}
+
+	~ArenaArray() { clear(); }
+
+
+	template <typename... Args>
+	T& emplace_back(Args&& ...args)
+	{
+		T* result = arena.construct<T>(std::forward<Args>(args)...);
+		++size;
+		return *result;
+	}
+
+	T& push_back(const T& t) { return emplace_back(t); }
+	T& push_back(T&& t) { return emplace_back(std::move(t)); }
+
+	// Commits memory for at least count elements, so that the next pushes don't have to.
+	void reserve(u64 count)
+	{
+		if (count > size)
+		{
+			arena.ensure_free((count - size) * sizeof(T), alignof(T));
+		}
+	}
+
+	void clear()
+	{
+		for (u64 i = size; i > 0; --i)
+		{
+			data()[i - 1].~T();
+		}
+		size = 0;
+
+		if (arena.memory)
+		{
+			arena.reset();
+		}
+	}
+
+	u64 count() const { return size; }
+	bool empty() const { return size == 0; }
+
+	T* data() { return (T*)arena.memory; }
+	const T* data() const { return (const T*)arena.memory; }
+
+	T& operator[](u64 index) { ASSERT(index < size); return data()[index]; }
+	const T& operator[](u64 index) const { ASSERT(index < size); return data()[index]; }
+
+	T* begin() { return data(); }
+	T* end() { return data() + size; }
+	const T* begin() const { return data(); }
+	const T* end() const { return data() + size; }
+
+	Range<T> range() { return Range<T>(data(), size); }
+
+private:
+	Arena arena;
+	u64 size = 0;
+};
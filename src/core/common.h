@@ -7,9 +7,11 @@
 #include <iostream>
 #include <filesystem>
 
+#if defined(_WIN32)
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#endif
 
 typedef int8_t i8;
 typedef uint8_t u8;
@@ -0,0 +1,113 @@
+#include "cpu_features.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuid(u32 leaf, u32 subleaf, u32 registers[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex((int*)registers, (int)leaf, (int)subleaf);
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static u64 xgetbv(u32 index)
+{
+#if defined(_MSC_VER)
+	return _xgetbv(index);
+#else
+	// _xgetbv needs -mxsave on GCC and Clang, which this file is not compiled with.
+	u32 eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return ((u64)edx << 32) | eax;
+#endif
+}
+
+static CPUFeatures detect_cpu_features()
+{
+	CPUFeatures features = {};
+
+	u32 registers[4];
+	cpuid(0, 0, registers);
+	u32 max_leaf = registers[0];
+
+	cpuid(1, 0, registers);
+	u32 ecx1 = registers[2];
+
+	u32 ebx7 = 0;
+	if (max_leaf >= 7)
+	{
+		cpuid(7, 0, registers);
+		ebx7 = registers[1];
+	}
+
+	// The OS has to save the YMM (and for AVX-512 the opmask and ZMM) registers on context switches.
+	bool os_saves_ymm = false;
+	bool os_saves_zmm = false;
+	if (ecx1 & (1 << 27)) // OSXSAVE.
+	{
+		u64 xcr0 = xgetbv(0);
+		os_saves_ymm = (xcr0 & 0x6) == 0x6;
+		os_saves_zmm = (xcr0 & 0xE6) == 0xE6;
+	}
+
+	features.sse4_1 = ecx1 & (1 << 19);
+	features.avx = (ecx1 & (1 << 28)) && os_saves_ymm;
+	features.fma = (ecx1 & (1 << 12)) && features.avx;
+	features.f16c = (ecx1 & (1 << 29)) && features.avx;
+	features.avx2 = (ebx7 & (1 << 5)) && features.avx;
+	features.avx512f = (ebx7 & (1 << 16)) && os_saves_zmm;
+	features.avx512dq = (ebx7 & (1 << 17)) && features.avx512f;
+	features.avx512bw = (ebx7 & (1u << 30)) && features.avx512f;
+	features.avx512vl = (ebx7 & (1u << 31)) && features.avx512f;
+
+	return features;
+}
+#else
+static CPUFeatures detect_cpu_features()
+{
+	return {};
+}
+#endif
+
+const CPUFeatures& get_cpu_features()
+{
+	static const CPUFeatures features = detect_cpu_features();
+	return features;
+}
+
+SimdLevel get_cpu_simd_level()
+{
+	const CPUFeatures& f = get_cpu_features();
+
+	if (f.avx2 && f.fma && f.f16c)
+	{
+		if (f.avx512f && f.avx512vl && f.avx512dq && f.avx512bw)
+		{
+			return SimdLevel::AVX512;
+		}
+		return SimdLevel::AVX2;
+	}
+	if (f.sse4_1)
+	{
+		return SimdLevel::SSE4_1;
+	}
+	return SimdLevel::SSE2;
+}
+
+const char* get_simd_level_name(SimdLevel level)
+{
+	switch (level)
+	{
+		case SimdLevel::SSE2: return "SSE2";
+		case SimdLevel::SSE4_1: return "SSE4.1";
+		case SimdLevel::AVX2: return "AVX2";
+		case SimdLevel::AVX512: return "AVX-512";
+		default: return "Unknown";
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "common.h"
+
+struct CPUFeatures
+{
+	bool sse4_1;
+	bool avx;
+	bool avx2;
+	bool fma;
+	bool f16c;
+	bool avx512f;
+	bool avx512vl;
+	bool avx512dq;
+	bool avx512bw;
+};
+
+// Instruction set levels the SIMD kernels are compiled for. Each level includes all previous ones.
+enum class SimdLevel
+{
+	SSE2,		// Baseline, scalar on targets other than x64.
+	SSE4_1,
+	AVX2,		// AVX2 + FMA + F16C.
+	AVX512,		// AVX-512 F + VL + DQ + BW.
+
+	Count,
+};
+
+// Queried once via cpuid. Features whose register state the OS does not save (XGETBV) are reported as missing.
+const CPUFeatures& get_cpu_features();
+
+// Highest level which the CPU and OS fully support.
+SimdLevel get_cpu_simd_level();
+
+const char* get_simd_level_name(SimdLevel level);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "memory.h"
+
+// Ring of arenas for CPU data which lives for frame_count frames. Allocating is a pointer bump and nothing is
+// freed individually. Instead, begin_frame resets the slot of the new frame, which was last used frame_count
+// frames ago. Any thread may allocate during a frame, but begin_frame must not race with allocations.
+template <u32 frame_count>
+struct FrameArena
+{
+	static_assert(frame_count > 0);
+
+	FrameArena(const char* tag = "Frame")
+	{
+		for (ConcurrentArena& arena : arenas)
+		{
+			arena.tag = tag;
+		}
+	}
+
+	void begin_frame(u64 frame_id)
+	{
+		current_slot = (u32)(frame_id % frame_count);
+		arenas[current_slot].reset();
+	}
+
+	ConcurrentArena& current() { return arenas[current_slot]; }
+
+	void* allocate(u64 size, u64 alignment = 1, bool clear_to_zero = false)
+	{
+		return current().allocate(size, alignment, clear_to_zero);
+	}
+
+	template <typename T>
+	T* allocate(u64 count = 1, bool clear_to_zero = false)
+	{
+		return (T*)allocate(sizeof(T) * count, alignof(T), clear_to_zero);
+	}
+
+	template <typename T>
+	Range<T> allocate_range(u64 count, bool clear_to_zero = false)
+	{
+		return Range<T>{ allocate<T>(count, clear_to_zero), count };
+	}
+
+	template <typename T, typename... Args>
+	T* construct(Args&& ...args)
+	{
+		return new(allocate<T>(1)) T(std::forward<Args>(args)...);
+	}
+
+private:
+	ConcurrentArena arenas[frame_count];
+	u32 current_slot = 0;
+};
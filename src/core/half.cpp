@@ -0,0 +1,38 @@
+#include "half.h"
+#include "simd_kernels.h"
+
+static_assert(sizeof(half2) == 2 * sizeof(half) && sizeof(half4) == 4 * sizeof(half), "Half vectors must be tightly packed.");
+
+void float_to_half(const float* in, half* out, u64 count)
+{
+	get_simd_kernels().float_to_half(in, (u16*)out, count);
+}
+
+void half_to_float(const half* in, float* out, u64 count)
+{
+	get_simd_kernels().half_to_float((const u16*)in, out, count);
+}
+
+void float_to_half(Range<vec2> in, Range<half2> out)
+{
+	ASSERT(in.count == out.count);
+	float_to_half((const float*)in.first, (half*)out.first, 2 * in.count);
+}
+
+void half_to_float(Range<half2> in, Range<vec2> out)
+{
+	ASSERT(in.count == out.count);
+	half_to_float((const half*)in.first, (float*)out.first, 2 * in.count);
+}
+
+void float_to_half(Range<vec4> in, Range<half4> out)
+{
+	ASSERT(in.count == out.count);
+	float_to_half((const float*)in.first, (half*)out.first, 4 * in.count);
+}
+
+void half_to_float(Range<half4> in, Range<vec4> out)
+{
+	ASSERT(in.count == out.count);
+	half_to_float((const half*)in.first, (float*)out.first, 4 * in.count);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "math.h"
+
+// IEEE 754 half precision floats, for streams where 16 bits are enough, e.g. vertex normals and uvs or HDR render
+// targets. They halve the memory traffic, but there is no arithmetic on them: convert to float, compute, convert
+// back. Conversions round to nearest even and give the same bits as F16C (and the GPU) on every machine.
+
+static u16 float_to_half_bits(float f)
+{
+	return (u16)float_to_half_internal<scalar_w_float<1>, scalar_w_int<1>>(scalar_w_float<1>(f))[0];
+}
+
+static float half_bits_to_float(u16 h)
+{
+	return half_to_float_internal<scalar_w_float<1>, scalar_w_int<1>>(scalar_w_int<1>(h))[0];
+}
+
+struct half
+{
+	u16 bits;
+
+	half() = default;
+	explicit half(float f) : bits(float_to_half_bits(f)) {}
+
+	explicit operator float() const { return half_bits_to_float(bits); }
+};
+
+struct half2
+{
+	half x, y;
+
+	half2() = default;
+	explicit half2(vec2 v) : x(v.x), y(v.y) {}
+
+	explicit operator vec2() const { return vec2((float)x, (float)y); }
+};
+
+struct half4
+{
+	half x, y, z, w;
+
+	half4() = default;
+	explicit half4(vec4 v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+	explicit operator vec4() const { return vec4((float)x, (float)y, (float)z, (float)w); }
+};
+
+// Batched conversions, run on the widest SIMD kernels the CPU supports (see simd_kernels.h). vec3 streams convert as
+// 3 * count floats.
+// See the half_conversion case of the Benchmarks project for speeds.
+void float_to_half(const float* in, half* out, u64 count);
+void half_to_float(const half* in, float* out, u64 count);
+
+void float_to_half(Range<vec2> in, Range<half2> out);
+void half_to_float(Range<half2> in, Range<vec2> out);
+void float_to_half(Range<vec4> in, Range<half4> out);
+void half_to_float(Range<half4> in, Range<vec4> out);
@@ -0,0 +1,319 @@
+#include "job_system.h"
+#include "memory.h"
+#include "pool.h"
+
+#include <thread>
+#include <condition_variable>
+
+// Chase-Lev work-stealing deque, with the memory orderings of Lê et al., "Correct and Efficient Work-Stealing for
+// Weak Memory Models". The owning worker pushes and pops at the bottom, all other threads steal from the top.
+struct WorkStealingDeque
+{
+	static constexpr i64 capacity = 4096;
+
+	bool push(Job* job)
+	{
+		i64 b = bottom.load(std::memory_order_relaxed);
+		i64 t = top.load(std::memory_order_acquire);
+		if (b - t >= capacity)
+		{
+			return false;
+		}
+
+		jobs[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job* pop()
+	{
+		i64 b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		i64 t = top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = jobs[b & (capacity - 1)].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// Last job, race against thieves.
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* steal()
+	{
+		i64 t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		i64 b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+		{
+			return nullptr;
+		}
+
+		Job* job = jobs[t & (capacity - 1)].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return job;
+	}
+
+	bool empty()
+	{
+		return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+	}
+
+	alignas(64) std::atomic<i64> top = 0;
+	alignas(64) std::atomic<i64> bottom = 0;
+	std::atomic<Job*> jobs[capacity] = {};
+};
+
+struct JobWorker
+{
+	WorkStealingDeque deque;
+	std::thread thread;
+};
+
+static Arena job_arena("Jobs");
+static ConcurrentPool<Job> job_pool(job_arena, 64);
+
+static JobWorker* workers = nullptr;
+static u32 worker_count = 0;
+static std::atomic<bool> workers_running = false;
+
+// Jobs submitted by threads which are not workers.
+static LockFreeStack<Job> injected_jobs;
+
+static std::atomic<u32> pending_job_count = 0;
+static std::atomic<u32> sleeping_worker_count = 0;
+static std::mutex sleep_mutex;
+static std::condition_variable wake_condition;
+
+static thread_local i32 worker_index = -1;
+
+static u32 next_random()
+{
+	thread_local u32 state = (u32)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static Job* get_next_job()
+{
+	Job* job = nullptr;
+
+	if (worker_index >= 0)
+	{
+		job = workers[worker_index].deque.pop();
+	}
+	if (!job)
+	{
+		job = injected_jobs.pop();
+	}
+	if (!job && worker_count > 1)
+	{
+		u32 first_victim = next_random() % worker_count;
+		for (u32 i = 0; i < worker_count && !job; ++i)
+		{
+			u32 victim = (first_victim + i) % worker_count;
+			if ((i32)victim != worker_index)
+			{
+				job = workers[victim].deque.steal();
+			}
+		}
+	}
+
+	if (job)
+	{
+		pending_job_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+static void execute_job(Job* job)
+{
+	job->invoke(job->data);
+
+	JobCounter* counter = job->counter;
+	job_pool.free(job);
+
+	if (counter)
+	{
+		// Decrement under the lock, so that the counter can't be destroyed before we are done with it.
+		Job* waiting = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(counter->mutex);
+			if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				waiting = std::exchange(counter->waiting_jobs, nullptr);
+			}
+		}
+
+		while (waiting)
+		{
+			Job* next = waiting->next_waiting;
+			submit_job(waiting);
+			waiting = next;
+		}
+	}
+}
+
+static void worker_loop(i32 index)
+{
+	worker_index = index;
+
+	while (workers_running.load(std::memory_order_relaxed))
+	{
+		if (Job* job = get_next_job())
+		{
+			execute_job(job);
+			continue;
+		}
+
+		// Jobs can be pending but invisible to us for a moment, e.g. while another thread is between pop and
+		// pending count update. Only go to sleep if there is nothing pending at all.
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleeping_worker_count.fetch_add(1);
+		wake_condition.wait(lock, []() { return pending_job_count.load() > 0 || !workers_running.load(); });
+		sleeping_worker_count.fetch_sub(1);
+	}
+
+	worker_index = -1;
+}
+
+void initialize_job_system(u32 count)
+{
+	ASSERT(!workers);
+
+	if (count == 0)
+	{
+		count = max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	worker_count = count;
+	workers = new JobWorker[count];
+	workers_running = true;
+
+	worker_index = 0;
+	for (u32 i = 1; i < count; ++i)
+	{
+		workers[i].thread = std::thread(worker_loop, (i32)i);
+	}
+}
+
+void shutdown_job_system()
+{
+	if (!workers)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		workers_running = false;
+	}
+	wake_condition.notify_all();
+
+	for (u32 i = 1; i < worker_count; ++i)
+	{
+		workers[i].thread.join();
+	}
+
+	// Run whatever is left, so that no counter stays incomplete. This includes the jobs in our own deque, which no
+	// one steals from if we are the only worker.
+	ASSERT(worker_index == 0);
+	while (Job* job = get_next_job())
+	{
+		execute_job(job);
+	}
+	worker_index = -1;
+
+	for (u32 i = 0; i < worker_count; ++i)
+	{
+		ASSERT(workers[i].deque.empty());
+	}
+	ASSERT(injected_jobs.empty());
+
+	delete[] workers;
+	workers = nullptr;
+	worker_count = 0;
+}
+
+u32 get_job_worker_count()
+{
+	return max(worker_count, 1u);
+}
+
+Job* allocate_job()
+{
+	return job_pool.allocate();
+}
+
+void submit_job(Job* job)
+{
+	if (!workers_running.load(std::memory_order_relaxed))
+	{
+		execute_job(job);
+		return;
+	}
+
+	pending_job_count.fetch_add(1);
+
+	if (worker_index < 0 || !workers[worker_index].deque.push(job))
+	{
+		injected_jobs.push(job);
+	}
+
+	if (sleeping_worker_count.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		wake_condition.notify_one();
+	}
+}
+
+void submit_job_after(JobCounter& dependency, Job* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (!dependency.is_done())
+		{
+			job->next_waiting = dependency.waiting_jobs;
+			dependency.waiting_jobs = job;
+			return;
+		}
+	}
+
+	submit_job(job);
+}
+
+void wait_for_counter(JobCounter& counter)
+{
+	while (!counter.is_done())
+	{
+		if (Job* job = get_next_job())
+		{
+			execute_job(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "common.h"
+#include "range.h"
+#include "lock_free.h"
+
+#include <atomic>
+#include <type_traits>
+
+struct Job;
+
+// Counts unfinished jobs. Every job which is started with a counter increments it and decrements it once it has
+// run. Jobs can also be deferred until a counter reaches zero, which is how dependencies are expressed.
+struct JobCounter
+{
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+
+	void operator=(const JobCounter&) = delete;
+
+	// The last job may still hold the lock right after the counter has reached zero.
+	~JobCounter() { std::lock_guard<std::mutex> lock(mutex); }
+
+	bool is_done() { return value.load(std::memory_order_acquire) == 0; }
+
+	std::atomic<u32> value = 0;
+
+	std::mutex mutex;
+	Job* waiting_jobs = nullptr;
+};
+
+struct Job : LockFreeLink
+{
+	static constexpr u64 data_size = 64;
+
+	void (*invoke)(void* data);
+	JobCounter* counter;
+	Job* next_waiting;
+
+	alignas(16) u8 data[data_size];
+};
+
+// Starts worker_count - 1 worker threads, the calling thread is the remaining worker. With worker_count = 0, one
+// worker per hardware thread is used. Until the job system is initialized, jobs run immediately on the caller.
+void initialize_job_system(u32 worker_count = 0);
+
+// Must be called on the thread which initialized the job system. Runs all jobs which are still queued.
+void shutdown_job_system();
+
+u32 get_job_worker_count();
+
+Job* allocate_job();
+void submit_job(Job* job);
+void submit_job_after(JobCounter& dependency, Job* job);
+
+// Waits until the counter reaches zero. The calling thread runs other jobs in the meantime, so waiting from
+// inside a job does not block a worker.
+void wait_for_counter(JobCounter& counter);
+
+
+template <typename F>
+Job* create_job(F&& f, JobCounter* counter)
+{
+	using Function = std::decay_t<F>;
+	static_assert(sizeof(Function) <= Job::data_size && alignof(Function) <= 16, "Job function captures too much. Capture by reference or pass a pointer.");
+
+	Job* job = allocate_job();
+	new(job->data) Function(std::forward<F>(f));
+	job->invoke = [](void* data)
+	{
+		Function& function = *(Function*)data;
+		function();
+		function.~Function();
+	};
+	job->counter = counter;
+
+	if (counter)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+template <typename F>
+void run_job(F&& f, JobCounter* counter = nullptr)
+{
+	submit_job(create_job(std::forward<F>(f), counter));
+}
+
+// Runs the job once dependency has reached zero.
+template <typename F>
+void run_job_after(JobCounter& dependency, F&& f, JobCounter* counter = nullptr)
+{
+	submit_job_after(dependency, create_job(std::forward<F>(f), counter));
+}
+
+// Calls f(begin, end) for chunks of the indices [0, count). The chunks have at least min_chunk_size indices, and
+// there are about four per worker, so that idle workers can steal the remainder. Returns once all chunks are done.
+template <typename F>
+void parallel_for_chunks(u64 count, const F& f, u64 min_chunk_size = 64)
+{
+	u64 worker_count = get_job_worker_count();
+	u64 chunk_size = max(max(min_chunk_size, (u64)1), (count + 4 * worker_count - 1) / (4 * worker_count));
+
+	JobCounter counter;
+	for (u64 begin = 0; begin < count; begin += chunk_size)
+	{
+		u64 end = min(begin + chunk_size, count);
+		run_job([&f, begin, end]() { f(begin, end); }, &counter);
+	}
+	wait_for_counter(counter);
+}
+
+// Calls f(item, index) for every item of the range, in chunks like parallel_for_chunks.
+template <typename T, typename F>
+void parallel_for(Range<T> range, const F& f, u64 min_chunk_size = 64)
+{
+	parallel_for_chunks(range.count, [&f, range](u64 begin, u64 end)
+	{
+		for (u64 i = begin; i < end; ++i)
+		{
+			f(range.first[i], i);
+		}
+	}, min_chunk_size);
+}
@@ -83,3 +83,128 @@ struct LinkedList
 		return result;
 	}
 };
+
+// Intrusive doubly linked list. T needs next and prev pointers. Unlike LinkedList, any item can be unlinked in
+// O(1) without knowing its predecessor, and the item count is cached instead of counted.
+template <typename T>
+struct DoublyLinkedList
+{
+	T* first = nullptr;
+	T* last = nullptr;
+	u32 item_count = 0;
+
+	bool empty()
+	{
+		return first == nullptr;
+	}
+
+	void push_front(T* item)
+	{
+		item->prev = nullptr;
+		item->next = first;
+		if (first)
+		{
+			first->prev = item;
+		}
+		first = item;
+		if (!last)
+		{
+			last = item;
+		}
+		++item_count;
+	}
+
+	void push_back(T* item)
+	{
+		item->next = nullptr;
+		item->prev = last;
+		if (last)
+		{
+			last->next = item;
+		}
+		last = item;
+		if (!first)
+		{
+			first = item;
+		}
+		++item_count;
+	}
+
+	T* pop_front()
+	{
+		T* result = first;
+		if (result)
+		{
+			remove(result);
+		}
+		return result;
+	}
+
+	T* pop_back()
+	{
+		T* result = last;
+		if (result)
+		{
+			remove(result);
+		}
+		return result;
+	}
+
+	T* peek_front()
+	{
+		return first;
+	}
+
+	void remove(T* item)
+	{
+		if (item->prev)
+		{
+			item->prev->next = item->next;
+		}
+		else
+		{
+			first = item->next;
+		}
+
+		if (item->next)
+		{
+			item->next->prev = item->prev;
+		}
+		else
+		{
+			last = item->prev;
+		}
+
+		item->next = item->prev = nullptr;
+		--item_count;
+	}
+
+	// Moves all items of other to the end of this list.
+	void splice_back(DoublyLinkedList& other)
+	{
+		if (other.empty())
+		{
+			return;
+		}
+
+		if (last)
+		{
+			last->next = other.first;
+			other.first->prev = last;
+		}
+		else
+		{
+			first = other.first;
+		}
+		last = other.last;
+		item_count += other.item_count;
+
+		other.first = other.last = nullptr;
+		other.item_count = 0;
+	}
+
+	u32 count()
+	{
+		return item_count;
+	}
+};
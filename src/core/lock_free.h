@@ -0,0 +1,180 @@
+#pragma once
+
+#include "common.h"
+
+#include <atomic>
+
+// Base for items of LockFreeStack and MPSCQueue. An item can only be in one of these containers at a time, and
+// its memory must stay mapped while other threads may still read the link, e.g. by coming from a pool.
+struct LockFreeLink
+{
+	std::atomic<LockFreeLink*> next_link = nullptr;
+};
+
+// Treiber stack. Safe for any number of pushing and popping threads. The head packs a pointer into the lower 48
+// bits and a modification counter into the upper 16 bits, so that a pop cannot succeed on a head which has been
+// popped and pushed again in the meantime (ABA problem).
+template <typename T>
+struct LockFreeStack
+{
+	void push(T* item)
+	{
+		push_chain(item, item);
+	}
+
+	// Pushes a chain of items which are already linked from first to last through next_link.
+	void push_chain(T* first, T* last, u32 count = 1)
+	{
+		// Count the items before publishing them, so that a concurrent pop can never decrement the count below zero.
+		item_count.fetch_add(count, std::memory_order_relaxed);
+
+		u64 old_head = head.load(std::memory_order_relaxed);
+		u64 new_head;
+		do
+		{
+			last->next_link.store(get_pointer(old_head), std::memory_order_relaxed);
+			new_head = pack_head(first, old_head);
+		} while (!head.compare_exchange_weak(old_head, new_head, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	T* pop()
+	{
+		u64 old_head = head.load(std::memory_order_acquire);
+		while (LockFreeLink* item = get_pointer(old_head))
+		{
+			// Another thread may pop and reuse this item concurrently, in which case we read garbage here. The
+			// counter in the head then makes the exchange fail.
+			u64 new_head = pack_head(item->next_link.load(std::memory_order_relaxed), old_head);
+			if (head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+			{
+				item_count.fetch_sub(1, std::memory_order_relaxed);
+				return static_cast<T*>(item);
+			}
+		}
+		return nullptr;
+	}
+
+	// Takes all items at once. They are returned in LIFO order, linked through next_link. Use next to walk them.
+	T* pop_all()
+	{
+		u64 old_head = head.load(std::memory_order_relaxed);
+		while (!head.compare_exchange_weak(old_head, pack_head(nullptr, old_head), std::memory_order_acquire, std::memory_order_relaxed)) {}
+
+		// Subtract all at once, so that other threads never see a count between the old and the new size.
+		LockFreeLink* first = get_pointer(old_head);
+		u32 count = 0;
+		for (LockFreeLink* item = first; item; item = item->next_link.load(std::memory_order_relaxed))
+		{
+			++count;
+		}
+		item_count.fetch_sub(count, std::memory_order_relaxed);
+		return static_cast<T*>(first);
+	}
+
+	static T* next(T* item)
+	{
+		return static_cast<T*>(item->next_link.load(std::memory_order_relaxed));
+	}
+
+	// Only a snapshot while other threads push or pop.
+	u32 count() { return item_count.load(std::memory_order_relaxed); }
+	bool empty() { return get_pointer(head.load(std::memory_order_relaxed)) == nullptr; }
+
+private:
+	static constexpr u64 pointer_mask = (1ull << 48) - 1;
+
+	static LockFreeLink* get_pointer(u64 head) { return (LockFreeLink*)(head & pointer_mask); }
+	static u64 pack_head(LockFreeLink* item, u64 old_head) { return (u64)item | ((old_head & ~pointer_mask) + (1ull << 48)); }
+
+	std::atomic<u64> head = 0;
+	std::atomic<u32> item_count = 0;
+};
+
+// Intrusive multi producer, single consumer FIFO queue (Dmitry Vyukov's non-intrusive MPSC queue, made intrusive
+// with a stub item). Pushing is wait-free: one atomic exchange and one store. peek and pop may only be called
+// from one thread at a time. While a producer is between its two steps, the consumer cannot see the items behind
+// it yet and gets nullptr, so callers must be prepared to retry.
+template <typename T>
+struct MPSCQueue
+{
+	MPSCQueue() : head(&stub), tail(&stub) {}
+	MPSCQueue(const MPSCQueue&) = delete;
+
+	void operator=(const MPSCQueue&) = delete;
+
+
+	void push(T* item)
+	{
+		item_count.fetch_add(1, std::memory_order_relaxed);
+		push_link(item);
+	}
+
+	// Returns the oldest item without removing it.
+	T* peek()
+	{
+		LockFreeLink* oldest = skip_stub();
+		return (oldest != &stub) ? static_cast<T*>(oldest) : nullptr;
+	}
+
+	T* pop()
+	{
+		LockFreeLink* oldest = skip_stub();
+		if (oldest == &stub)
+		{
+			return nullptr;
+		}
+
+		LockFreeLink* next = oldest->next_link.load(std::memory_order_acquire);
+		if (!next)
+		{
+			// oldest is the last item we can see. If a producer has already swapped the head, its link is about
+			// to appear. Otherwise, push the stub behind oldest, so that tail never runs empty.
+			if (oldest != head.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+
+			push_link(&stub);
+			next = oldest->next_link.load(std::memory_order_acquire);
+			if (!next)
+			{
+				return nullptr;
+			}
+		}
+
+		tail = next;
+		item_count.fetch_sub(1, std::memory_order_relaxed);
+		return static_cast<T*>(oldest);
+	}
+
+	// Only a snapshot while other threads push or pop.
+	u32 count() { return item_count.load(std::memory_order_relaxed); }
+	bool empty() { return count() == 0; }
+
+private:
+	void push_link(LockFreeLink* link)
+	{
+		link->next_link.store(nullptr, std::memory_order_relaxed);
+		LockFreeLink* prev = head.exchange(link, std::memory_order_acq_rel);
+		prev->next_link.store(link, std::memory_order_release);
+	}
+
+	LockFreeLink* skip_stub()
+	{
+		if (tail == &stub)
+		{
+			LockFreeLink* next = stub.next_link.load(std::memory_order_acquire);
+			if (next)
+			{
+				tail = next;
+			}
+		}
+		return tail;
+	}
+
+	std::atomic<LockFreeLink*> head; // Newest item, written by producers.
+	LockFreeLink* tail;              // Oldest item, only touched by the consumer.
+	LockFreeLink stub;
+
+	std::atomic<u32> item_count = 0;
+};
@@ -1,4 +1,6 @@
 #include "math.h"
+#include "simd_kernels.h"
+#include "random.h"
 
 const mat2 mat2::identity =
 {
@@ -53,6 +55,7 @@ const dual_quat dual_quat::identity = { { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f,
 const dual_quat dual_quat::zero = { { 0.f, 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f, 0.f } };
 
 const Transform Transform::identity = { vec3(0.f, 0.f, 0.f), quat(0.f, 0.f, 0.f, 1.f), vec3(1.f, 1.f, 1.f) };
+const AABB AABB::empty = { vec3(FLT_MAX), vec3(-FLT_MAX) };
 
 
 mat2 operator*(const mat2& a, const mat2& b)
@@ -218,8 +221,14 @@ mat3 transpose(const mat3& a)
 
 mat4 transpose(const mat4& a)
 {
-	mat4 result = a;
-	transpose(result.f40, result.f41, result.f42, result.f43);
+	w4_float col0 = a.f40, col1 = a.f41, col2 = a.f42, col3 = a.f43;
+	transpose(col0, col1, col2, col3);
+
+	mat4 result;
+	result.f40 = col0;
+	result.f41 = col1;
+	result.f42 = col2;
+	result.f43 = col3;
 	return result;
 }
 
@@ -471,6 +480,96 @@ vec3 transform_direction(const mat4& m, vec3 dir)
 	return (m * vec4(dir, 0.f)).xyz;
 }
 
+// The kernels take the top three rows of the matrix, row-major.
+static void transform_triplets(const mat4& m, bool translate, Range<vec3> in, Range<vec3> out)
+{
+	ASSERT(in.count == out.count);
+
+	const float matrix[12] =
+	{
+		m.m00, m.m01, m.m02, translate ? m.m03 : 0.f,
+		m.m10, m.m11, m.m12, translate ? m.m13 : 0.f,
+		m.m20, m.m21, m.m22, translate ? m.m23 : 0.f,
+	};
+	get_simd_kernels().transform_positions(matrix, (const float*)in.first, (float*)out.first, in.count);
+}
+
+static mat4 dual_quat_to_mat4(const dual_quat& q)
+{
+	quat translation = q.dual * conjugate(q.real);
+	return create_model_matrix(2.f * translation.v4.xyz, q.real);
+}
+
+void transform_positions(const mat4& m, Range<vec3> positions, Range<vec3> result)
+{
+	transform_triplets(m, true, positions, result);
+}
+
+void transform_directions(const mat4& m, Range<vec3> directions, Range<vec3> result)
+{
+	transform_triplets(m, false, directions, result);
+}
+
+void transform_positions(const Transform& t, Range<vec3> positions, Range<vec3> result)
+{
+	transform_triplets(transform_to_mat4(t), true, positions, result);
+}
+
+void transform_directions(const Transform& t, Range<vec3> directions, Range<vec3> result)
+{
+	// Like transform_direction, this only rotates.
+	transform_triplets(create_model_matrix(vec3(0.f), t.rotation), false, directions, result);
+}
+
+void transform_positions(const dual_quat& q, Range<vec3> positions, Range<vec3> result)
+{
+	transform_triplets(dual_quat_to_mat4(q), true, positions, result);
+}
+
+void transform_directions(const dual_quat& q, Range<vec3> directions, Range<vec3> result)
+{
+	transform_triplets(dual_quat_to_mat4(q), false, directions, result);
+}
+
+void aos_to_soa(const void* aos, u64 stride_in_bytes, u32 component_count, float* const* soa, u64 count)
+{
+	ASSERT(stride_in_bytes % sizeof(float) == 0);
+	ASSERT(stride_in_bytes >= component_count * sizeof(float));
+	get_simd_kernels().aos_to_soa((const float*)aos, stride_in_bytes / sizeof(float), component_count, soa, count);
+}
+
+void soa_to_aos(const float* const* soa, u32 component_count, void* aos, u64 stride_in_bytes, u64 count)
+{
+	ASSERT(stride_in_bytes % sizeof(float) == 0);
+	ASSERT(stride_in_bytes >= component_count * sizeof(float));
+	get_simd_kernels().soa_to_aos(soa, component_count, (float*)aos, stride_in_bytes / sizeof(float), count);
+}
+
+void aos_to_soa(Range<vec3> aos, float* x, float* y, float* z)
+{
+	float* soa[] = { x, y, z };
+	aos_to_soa(aos.first, sizeof(vec3), 3, soa, aos.count);
+}
+
+void soa_to_aos(const float* x, const float* y, const float* z, Range<vec3> aos)
+{
+	const float* soa[] = { x, y, z };
+	soa_to_aos(soa, 3, aos.first, sizeof(vec3), aos.count);
+}
+
+static_assert(offsetof(Transform, position) == 4 * sizeof(float) && offsetof(Transform, scale) == 7 * sizeof(float),
+	"The components of a transform must be contiguous.");
+
+void aos_to_soa(Range<Transform> aos, float* const soa[transform_component_count])
+{
+	aos_to_soa(aos.first, sizeof(Transform), transform_component_count, soa, aos.count);
+}
+
+void soa_to_aos(const float* const soa[transform_component_count], Range<Transform> aos)
+{
+	soa_to_aos(soa, transform_component_count, aos.first, sizeof(Transform), aos.count);
+}
+
 vec3 transform_position(const Transform& m, vec3 pos)
 {
 	return m.rotation * (m.scale * pos) + m.position;
@@ -481,6 +580,17 @@ vec3 transform_direction(const Transform& m, vec3 dir)
 	return m.rotation * dir;
 }
 
+vec3 transform_position(const dual_quat& q, vec3 pos)
+{
+	quat translation = q.dual * conjugate(q.real);
+	return q.real * pos + 2.f * translation.v4.xyz;
+}
+
+vec3 transform_direction(const dual_quat& q, vec3 dir)
+{
+	return q.real * dir;
+}
+
 vec3 inverse_transform_position(const Transform& m, vec3 pos)
 {
 	return (conjugate(m.rotation) * (pos - m.position)) / m.scale;
@@ -594,7 +704,7 @@ quat nlerp(quat* qs, float* weights, u32 count)
 		result += v1 * weights[i];
 	}
 
-	return { result.f4 };
+	return quat(result.f4);
 }
 
 mat3 quaternion_to_mat3(quat q)
@@ -1226,6 +1336,50 @@ mat4 invert_affine_matrix(const mat4& m)
 	return result;
 }
 
+void multiply(Range<mat4> a, Range<mat4> b, Range<mat4> result)
+{
+	ASSERT(a.count == result.count && b.count == result.count);
+	get_simd_kernels().multiply_matrices((const float*)a.first, 16, (const float*)b.first, 16, (float*)result.first, result.count);
+}
+
+void multiply(const mat4& a, Range<mat4> b, Range<mat4> result)
+{
+	ASSERT(b.count == result.count);
+	get_simd_kernels().multiply_matrices(a.m, 0, (const float*)b.first, 16, (float*)result.first, result.count);
+}
+
+void multiply(Range<mat4> a, const mat4& b, Range<mat4> result)
+{
+	ASSERT(a.count == result.count);
+	get_simd_kernels().multiply_matrices((const float*)a.first, 16, b.m, 0, (float*)result.first, result.count);
+}
+
+void invert(Range<mat4> matrices, Range<mat4> result)
+{
+	ASSERT(matrices.count == result.count);
+	get_simd_kernels().invert_matrices((const float*)matrices.first, (float*)result.first, result.count);
+}
+
+void invert_affine_matrices(Range<mat4> matrices, Range<mat4> result)
+{
+	ASSERT(matrices.count == result.count);
+	get_simd_kernels().invert_affine_matrices((const float*)matrices.first, (float*)result.first, result.count);
+}
+
+void transforms_to_mat4(Range<Transform> transforms, Range<mat4> result)
+{
+	ASSERT(transforms.count == result.count);
+	get_simd_kernels().transforms_to_matrices((const float*)transforms.first, sizeof(Transform) / sizeof(float), (float*)result.first, result.count);
+}
+
+void transforms_to_rows_3x4(const Transform* transforms, u64 transform_stride_in_bytes, float* result, u64 result_stride_in_bytes, u64 count)
+{
+	ASSERT(transform_stride_in_bytes % sizeof(float) == 0 && transform_stride_in_bytes >= sizeof(Transform));
+	ASSERT(result_stride_in_bytes % sizeof(float) == 0 && result_stride_in_bytes >= 12 * sizeof(float));
+	get_simd_kernels().transforms_to_rows_3x4((const float*)transforms, transform_stride_in_bytes / sizeof(float),
+		result, result_stride_in_bytes / sizeof(float), count);
+}
+
 bool is_point_in_triangle(vec3 point, vec3 triA, vec3 triB, vec3& triC)
 {
 	vec3 e10 = triB - triA;
@@ -1255,6 +1409,39 @@ bool is_point_in_box(vec3 p, vec3 minCorner, vec3 maxCorner)
 	return p.x >= minCorner.x && p.y >= minCorner.y && p.z >= minCorner.z && p.x <= maxCorner.x && p.y <= maxCorner.y && p.z <= maxCorner.z;
 }
 
+float surface_area(const AABB& box)
+{
+	vec3 e = max(box.max_corner - box.min_corner, vec3(0.f));
+	return 2.f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+AABB grow(const AABB& box, Range<vec3> points)
+{
+	AABB bounds;
+	get_simd_kernels().bounding_box((const float*)points.first, points.count, &bounds.min_corner.x, &bounds.max_corner.x);
+	return box_union(box, bounds);
+}
+
+// Center and extent form, like the wide version in wide_math.h. The halves are taken before subtracting, so that
+// empty boxes keep a finite, negative extent and stay empty.
+AABB transform_aabb(const mat4& m, const AABB& box)
+{
+	vec3 c = box.max_corner * 0.5f + box.min_corner * 0.5f;
+	vec3 e = box.max_corner * 0.5f - box.min_corner * 0.5f;
+
+	vec3 center = transform_position(m, c);
+	vec3 extent(
+		abs(m.m00) * e.x + abs(m.m01) * e.y + abs(m.m02) * e.z,
+		abs(m.m10) * e.x + abs(m.m11) * e.y + abs(m.m12) * e.z,
+		abs(m.m20) * e.x + abs(m.m21) * e.y + abs(m.m22) * e.z);
+	return AABB(center - extent, center + extent);
+}
+
+AABB transform_aabb(const Transform& t, const AABB& box)
+{
+	return transform_aabb(transform_to_mat4(t), box);
+}
+
 vec2 direction_to_panorama_uv(vec3 dir)
 {
 	const vec2 invAtan = vec2(INV_TAU, INV_PI);
@@ -1397,6 +1584,25 @@ vec4 uniform_sample_sphere(vec2 E)
 	return vec4(H, PDF);
 }
 
+// Through the wide versions with a single lane, so that the results match them bit for bit.
+vec4 uniform_sample_hemisphere(vec2 E)
+{
+	wN_vec4<scalar_w_float<1>> result = uniform_sample_hemisphere(wN_vec2<scalar_w_float<1>>(E.x, E.y));
+	return vec4(result.x[0], result.y[0], result.z[0], result.w[0]);
+}
+
+vec4 cosine_sample_hemisphere(vec2 E)
+{
+	wN_vec4<scalar_w_float<1>> result = cosine_sample_hemisphere(wN_vec2<scalar_w_float<1>>(E.x, E.y));
+	return vec4(result.x[0], result.y[0], result.z[0], result.w[0]);
+}
+
+vec2 random_vec2(u32 pixel_x, u32 pixel_y, u32 sample, u32 dimension)
+{
+	RandomBits<u32> bits = random_bits(pixel_x, pixel_y, sample, dimension);
+	return vec2(random_bits_to_float(bits.x), random_bits_to_float(bits.y));
+}
+
 
 
 #define _gamma 5.828427124f // FOUR_GAMMA_SQUARED = sqrt(8)+3;
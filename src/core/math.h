@@ -7,10 +7,13 @@
 #include <cmath>
 #include <cfloat>
 #include <iostream>
+#include <cstring>
 
 #include "common.h"
 #include "simd.h"
+#include "range.h"
 
+#undef M_PI
 #define M_PI 3.14159265359f
 #define M_PI_OVER_2 (M_PI * 0.5f)
 #define M_PI_OVER_180 (M_PI / 180.f)
@@ -119,6 +122,22 @@ static constexpr u32 align_to_power_of_two(u32 i)
 	return i == 0u ? 0u : 1u << log2(i);
 }
 
+// GCC rejects members with constructors in anonymous structs, so there the sub-vector members of the unions below
+// (xy, xyz, col0, ...) are views, which convert to and from the vector type. Other compilers use the type itself.
+#if defined(__GNUC__) && !defined(__clang__)
+template <typename vec_t>
+struct vector_view
+{
+	alignas(vec_t) u8 data[sizeof(vec_t)];
+
+	operator vec_t() const { vec_t result; memcpy(&result, data, sizeof(vec_t)); return result; }
+	vector_view& operator=(const vec_t& v) { memcpy(data, &v, sizeof(vec_t)); return *this; }
+};
+#define SUB_VECTOR(vec_t) vector_view<vec_t>
+#else
+#define SUB_VECTOR(vec_t) vec_t
+#endif
+
 union vec2
 {
 	struct
@@ -127,7 +146,7 @@ union vec2
 	};
 	float data[2];
 
-	vec2() {}
+	vec2() = default;
 	vec2(float v) : vec2(v, v) {}
 	vec2(float x, float y) : x(x), y(y) {}
 
@@ -144,19 +163,21 @@ union vec3
 	{
 		float r, g, b;
 	};
+	// Members which are already declared above get a leading underscore. Anonymous structs sharing member names is
+	// an MSVC extension.
 	struct
 	{
-		vec2 xy;
-		float z;
+		SUB_VECTOR(vec2) xy;
+		float _z;
 	};
 	struct
 	{
-		float x;
-		vec2 yz;
+		float _x;
+		SUB_VECTOR(vec2) yz;
 	};
 	float data[3];
 
-	vec3() {}
+	vec3() = default;
 	vec3(float v) : vec3(v, v, v) {}
 	vec3(float x, float y, float z) : x(x), y(y), z(z) {}
 	vec3(vec2 xy, float z) : x(xy.x), y(xy.y), z(z) {}
@@ -176,27 +197,27 @@ union vec4
 	};
 	struct
 	{
-		vec3 xyz;
-		float w;
+		SUB_VECTOR(vec3) xyz;
+		float _w;
 	};
 	struct
 	{
-		vec2 xy;
-		vec2 zw;
+		SUB_VECTOR(vec2) xy;
+		SUB_VECTOR(vec2) zw;
 	};
 	struct
 	{
-		float x;
-		vec3 yzw;
+		float _x;
+		SUB_VECTOR(vec3) yzw;
 	};
 	w4_float f4;
 	float data[4];
 
-	vec4() {}
+	vec4() = default;
 	vec4(float v) : vec4(v, v, v, v) {}
 	vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
 	vec4(vec3 xyz, float w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
-	vec4(w4_float f4) : f4(f4) {}
+	explicit vec4(w4_float f4) : f4(f4) {}
 
 	static const vec4 zero;
 };
@@ -209,7 +230,7 @@ union quat
 	};
 	struct
 	{
-		vec3 v;
+		SUB_VECTOR(vec3) v;
 		float cos_half_angle;
 	};
 	vec4 v4;
@@ -219,7 +240,7 @@ union quat
 	quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
 	quat(vec3 axis, float angle);
 	quat(vec4 v4) : v4(v4) {}
-	quat(w4_float f4) : f4(f4) {}
+	explicit quat(w4_float f4) : f4(f4) {}
 
 	static const quat identity;
 	static const quat zero;
@@ -252,8 +273,8 @@ union mat2
 	};
 	struct
 	{
-		vec2 row0;
-		vec2 row1;
+		SUB_VECTOR(vec2) row0;
+		SUB_VECTOR(vec2) row1;
 	};
 	vec2 rows[2];
 #else
@@ -265,8 +286,8 @@ union mat2
 	};
 	struct
 	{
-		vec2 col0;
-		vec2 col1;
+		SUB_VECTOR(vec2) col0;
+		SUB_VECTOR(vec2) col1;
 	};
 	vec2 cols[2];
 #endif
@@ -293,9 +314,9 @@ union mat3
 	};
 	struct
 	{
-		vec3 row0;
-		vec3 row1;
-		vec3 row2;
+		SUB_VECTOR(vec3) row0;
+		SUB_VECTOR(vec3) row1;
+		SUB_VECTOR(vec3) row2;
 	};
 	vec3 rows[3];
 #else
@@ -308,9 +329,9 @@ union mat3
 	};
 	struct
 	{
-		vec3 col0;
-		vec3 col1;
-		vec3 col2;
+		SUB_VECTOR(vec3) col0;
+		SUB_VECTOR(vec3) col1;
+		SUB_VECTOR(vec3) col2;
 	};
 	vec3 cols[3];
 #endif
@@ -339,10 +360,10 @@ union mat4
 	};
 	struct
 	{
-		vec4 row0;
-		vec4 row1;
-		vec4 row2;
-		vec4 row3;
+		SUB_VECTOR(vec4) row0;
+		SUB_VECTOR(vec4) row1;
+		SUB_VECTOR(vec4) row2;
+		SUB_VECTOR(vec4) row3;
 	};
 	vec4 rows[4];
 #else
@@ -356,19 +377,19 @@ union mat4
 	};
 	struct
 	{
-		vec4 col0;
-		vec4 col1;
-		vec4 col2;
-		vec4 col3;
+		SUB_VECTOR(vec4) col0;
+		SUB_VECTOR(vec4) col1;
+		SUB_VECTOR(vec4) col2;
+		SUB_VECTOR(vec4) col3;
 	};
 	vec4 cols[4];
 #endif
 	struct
 	{
-		w4_float f40;
-		w4_float f41;
-		w4_float f42;
-		w4_float f43;
+		SUB_VECTOR(w4_float) f40;
+		SUB_VECTOR(w4_float) f41;
+		SUB_VECTOR(w4_float) f42;
+		SUB_VECTOR(w4_float) f43;
 	};
 	float m[16];
 
@@ -415,6 +436,20 @@ struct Transform
 	static const Transform identity;
 };
 
+// Axis-aligned bounding box. Boxes with a min corner above the max corner are empty. See wide_math.h for the SoA
+// version, wN_AABB.
+struct AABB
+{
+	vec3 min_corner;
+	vec3 max_corner;
+
+	AABB() {}
+	AABB(vec3 min_corner, vec3 max_corner) : min_corner(min_corner), max_corner(max_corner) {}
+
+	// Grows to exactly the first point or box added, and stays empty under transforms.
+	static const AABB empty;
+};
+
 
 
 
@@ -463,19 +498,19 @@ static bool operator!=(vec3 a, vec3 b) { return !(a == b); }
 
 
 // Vec4 operators.
-static vec4 operator+(vec4 a, vec4 b) { vec4 result = { a.f4 + b.f4 }; return result; }
+static vec4 operator+(vec4 a, vec4 b) { vec4 result(a.f4 + b.f4); return result; }
 static vec4& operator+=(vec4& a, vec4 b) { a = a + b; return a; }
-static vec4 operator-(vec4 a, vec4 b) { vec4 result = { a.f4 - b.f4 }; return result; }
+static vec4 operator-(vec4 a, vec4 b) { vec4 result(a.f4 - b.f4); return result; }
 static vec4& operator-=(vec4& a, vec4 b) { a = a - b; return a; }
-static vec4 operator*(vec4 a, vec4 b) { vec4 result = { a.f4 * b.f4 }; return result; }
+static vec4 operator*(vec4 a, vec4 b) { vec4 result(a.f4 * b.f4); return result; }
 static vec4& operator*=(vec4& a, vec4 b) { a = a * b; return a; }
-static vec4 operator/(vec4 a, vec4 b) { vec4 result = { a.f4 / b.f4 }; return result; }
+static vec4 operator/(vec4 a, vec4 b) { vec4 result(a.f4 / b.f4); return result; }
 static vec4& operator/=(vec4& a, vec4 b) { a = a / b; return a; }
 
-static vec4 operator*(vec4 a, float b) { vec4 result = { a.f4 * w4_float(b) }; return result; }
+static vec4 operator*(vec4 a, float b) { vec4 result(a.f4 * w4_float(b)); return result; }
 static vec4 operator*(float a, vec4 b) { return b * a; }
 static vec4& operator*=(vec4& a, float b) { a = a * b; return a; }
-static vec4 operator/(vec4 a, float b) { vec4 result = { a.f4 / w4_float(b) }; return result; }
+static vec4 operator/(vec4 a, float b) { vec4 result(a.f4 / w4_float(b)); return result; }
 static vec4& operator/=(vec4& a, float b) { a = a / b; return a; }
 
 static vec4 operator-(vec4 a) { return vec4(-a.f4); }
@@ -531,10 +566,10 @@ static vec2 frac(vec2 a) { return vec2(frac(a.x), frac(a.y)); }
 static vec3 frac(vec3 a) { return vec3(frac(a.x), frac(a.y), frac(a.z)); }
 static vec4 frac(vec4 a) { return vec4(frac(a.x), frac(a.y), frac(a.z), frac(a.w)); }
 
-static quat normalize(quat a) { return { normalize(a.v4).f4 }; }
+static quat normalize(quat a) { return quat(normalize(a.v4).f4); }
 static quat conjugate(quat a) { return { -a.x, -a.y, -a.z, a.w }; }
 
-static quat operator+(quat a, quat b) { quat result = { a.f4 + b.f4 }; return result; }
+static quat operator+(quat a, quat b) { quat result(a.f4 + b.f4); return result; }
 
 static quat operator*(quat a, quat b)
 {
@@ -597,8 +632,8 @@ static vec2 exp(vec2 v) { return vec2(exp(v.x), exp(v.y)); }
 static vec3 exp(vec3 v) { return vec3(exp(v.x), exp(v.y), exp(v.z)); }
 static vec4 exp(vec4 v) { return vec4(exp(v.f4)); }
 
-static vec2 pow(vec2 v, float e) { return vec2(pow(v.x, e), pow(v.y, e)); }
-static vec3 pow(vec3 v, float e) { return vec3(pow(v.x, e), pow(v.y, e), pow(v.z, e)); }
+static vec2 pow(vec2 v, float e) { return vec2(powf(v.x, e), powf(v.y, e)); }
+static vec3 pow(vec3 v, float e) { return vec3(powf(v.x, e), powf(v.y, e), powf(v.z, e)); }
 static vec4 pow(vec4 v, float e) { return vec4(pow(v.f4, w4_float(e))); }
 
 static vec2 min(vec2 a, vec2 b) { return vec2(min(a.x, b.x), min(a.y, b.y)); }
@@ -687,6 +722,44 @@ vec3 transform_direction(const Transform& m, vec3 dir);
 vec3 inverse_transform_position(const Transform& m, vec3 pos);
 vec3 inverse_transform_direction(const Transform& m, vec3 dir);
 
+vec3 transform_position(const dual_quat& q, vec3 pos);
+vec3 transform_direction(const dual_quat& q, vec3 dir);
+
+// Batched versions, run on the SIMD kernels (see simd_kernels.h). result may be the input, for transforming in
+// place. Transforms and dual quaternions are turned into a matrix first, so the results can differ from the single
+// versions by rounding. Dual quaternions must be normalized.
+// See the transform_positions case of the Benchmarks project for speeds.
+void transform_positions(const mat4& m, Range<vec3> positions, Range<vec3> result);
+void transform_directions(const mat4& m, Range<vec3> directions, Range<vec3> result);
+void transform_positions(const Transform& t, Range<vec3> positions, Range<vec3> result);
+void transform_directions(const Transform& t, Range<vec3> directions, Range<vec3> result);
+void transform_positions(const dual_quat& q, Range<vec3> positions, Range<vec3> result);
+void transform_directions(const dual_quat& q, Range<vec3> directions, Range<vec3> result);
+
+static void transform_positions(const mat4& m, Range<vec3> positions) { transform_positions(m, positions, positions); }
+static void transform_directions(const mat4& m, Range<vec3> directions) { transform_directions(m, directions, directions); }
+static void transform_positions(const Transform& t, Range<vec3> positions) { transform_positions(t, positions, positions); }
+static void transform_directions(const Transform& t, Range<vec3> directions) { transform_directions(t, directions, directions); }
+static void transform_positions(const dual_quat& q, Range<vec3> positions) { transform_positions(q, positions, positions); }
+static void transform_directions(const dual_quat& q, Range<vec3> directions) { transform_directions(q, directions, directions); }
+
+// Conversion between arrays of structures and structures of arrays. Element i starts stride_in_bytes * i bytes after
+// aos, and its first component_count floats go to (or come from) soa[0][i], soa[1][i], ... This also covers fields
+// inside larger structures, e.g. the transforms of scene objects with aos = &objects[0].transform and
+// stride_in_bytes = sizeof(SceneObject). Neither side needs to be aligned, and soa_to_aos leaves everything
+// between the elements untouched.
+// See the aos_to_soa case of the Benchmarks project for speeds.
+void aos_to_soa(const void* aos, u64 stride_in_bytes, u32 component_count, float* const* soa, u64 count);
+void soa_to_aos(const float* const* soa, u32 component_count, void* aos, u64 stride_in_bytes, u64 count);
+
+void aos_to_soa(Range<vec3> aos, float* x, float* y, float* z);
+void soa_to_aos(const float* x, const float* y, const float* z, Range<vec3> aos);
+
+// The components of a transform are the rotation (x, y, z, w), the position (x, y, z) and the scale (x, y, z).
+static constexpr u32 transform_component_count = 10;
+void aos_to_soa(Range<Transform> aos, float* const soa[transform_component_count]);
+void soa_to_aos(const float* const soa[transform_component_count], Range<Transform> aos);
+
 quat rotate_from_to(vec3 from, vec3 to);
 quat look_at_quaternion(vec3 forward, vec3 up);
 void get_axis_rotation(quat q, vec3& axis, float& angle);
@@ -722,10 +795,40 @@ mat4 look_at_matrix(vec3 eye, vec3 target, vec3 up);
 mat4 create_view_matrix(vec3 position, quat rotation);
 mat4 invert_affine_matrix(const mat4& m);
 
+// Batched versions, run on the SIMD kernels (see simd_kernels.h). result may be the input. The inverses take several
+// matrices at a time, lane-wise, and return zero matrices for singular ones. invert_affine_matrices has the same
+// restrictions as invert_affine_matrix.
+// See the matrices case of the Benchmarks project for speeds.
+void multiply(Range<mat4> a, Range<mat4> b, Range<mat4> result);
+void multiply(const mat4& a, Range<mat4> b, Range<mat4> result);
+void multiply(Range<mat4> a, const mat4& b, Range<mat4> result);
+void invert(Range<mat4> matrices, Range<mat4> result);
+void invert_affine_matrices(Range<mat4> matrices, Range<mat4> result);
+void transforms_to_mat4(Range<Transform> transforms, Range<mat4> result);
+
+// Writes the top three rows of transform_to_mat4(transforms[i]) as 12 row-major floats, which is the layout of
+// D3D12_RAYTRACING_INSTANCE_DESC::Transform. Like aos_to_soa, the transforms and matrices can be fields of larger
+// structures, stride_in_bytes apart. The rest of these is left untouched.
+void transforms_to_rows_3x4(const Transform* transforms, u64 transform_stride_in_bytes, float* result, u64 result_stride_in_bytes, u64 count);
+
 bool is_point_in_triangle(vec3 point, vec3 triA, vec3 triB, vec3& triC);
 bool is_point_in_rectangle(vec2 p, vec2 topLeft, vec2 bottomRight);
 bool is_point_in_box(vec3 p, vec3 minCorner, vec3 maxCorner);
 
+// The argument order of min and max makes NaN points leave the box as it is, like in the batched version.
+static AABB grow(const AABB& box, vec3 point) { return AABB(min(point, box.min_corner), max(box.max_corner, point)); }
+static AABB box_union(const AABB& a, const AABB& b) { return AABB(min(a.min_corner, b.min_corner), max(a.max_corner, b.max_corner)); }
+float surface_area(const AABB& box);
+
+// Batched version, which reduces the points with SIMD min and max (see simd_kernels.h).
+// See the aabb_grow case of the Benchmarks project for speeds.
+AABB grow(const AABB& box, Range<vec3> points);
+
+// Box around the transformed box, with Arvo's method. Same as the box around the eight transformed corners, but
+// without transforming them.
+AABB transform_aabb(const mat4& m, const AABB& box);
+AABB transform_aabb(const Transform& t, const AABB& box);
+
 vec2 direction_to_panorama_uv(vec3 dir);
 
 float angle_to_zero_to_two_pi(float angle);
@@ -744,6 +847,15 @@ vec3 get_tangent(vec3 normal);
 // W = PDF = 1 / 4pi
 vec4 uniform_sample_sphere(vec2 E);
 
+// Directions around +z. W = PDF = 1 / 2pi.
+vec4 uniform_sample_hemisphere(vec2 E);
+// Directions around +z. W = PDF = cos(theta) / pi.
+vec4 cosine_sample_hemisphere(vec2 E);
+
+// Counter-based random numbers, bit for bit the same as the wide versions in random.h, where random_bits and
+// random_float work on u32 as they are.
+vec2 random_vec2(u32 pixel_x, u32 pixel_y, u32 sample, u32 dimension);
+
 
 
 
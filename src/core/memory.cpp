@@ -1,20 +1,241 @@
 #include "memory.h"
 
 #include <utility>
+#include <cstring>
+#include <vector>
+#include <iomanip>
 
-Arena::Arena(u64 reserve_address_space)
+#if defined(_WIN32)
+
+static u64 get_page_size()
 {
 	SYSTEM_INFO systemInfo;
 	GetSystemInfo(&systemInfo);
+	return systemInfo.dwPageSize;
+}
+
+static u8* reserve_virtual_memory(u64 size, bool large_pages)
+{
+	return (u8*)VirtualAlloc(0, size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+static void commit_virtual_memory(u8* address, u64 size)
+{
+	VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void decommit_virtual_memory(u8* address, u64 size)
+{
+	VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+static void release_virtual_memory(u8* address, u64 size)
+{
+	VirtualFree(address, 0, MEM_RELEASE);
+}
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+static u64 get_page_size()
+{
+	return (u64)sysconf(_SC_PAGESIZE);
+}
+
+static u8* reserve_virtual_memory(u64 size, bool large_pages)
+{
+	// Huge pages can only back 2 MB aligned ranges, so we over-reserve and trim the unaligned head and tail.
+	u64 alignment = large_pages ? Arena::large_page_commit_size : 0;
+
+	void* result = mmap(0, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (result == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	u8* memory = (u8*)result;
+
+	if (large_pages)
+	{
+		u8* aligned = (u8*)align_to((u64)memory, alignment);
+		u64 head = aligned - memory;
+		u64 tail = alignment - head;
+
+		if (head)
+		{
+			munmap(memory, head);
+		}
+		if (tail)
+		{
+			munmap(aligned + size, tail);
+		}
+
+		memory = aligned;
+
+		// Transparent huge pages instead of MAP_HUGETLB, since the latter requires a preallocated huge page pool
+		// and raises SIGBUS on first touch if that pool is exhausted.
+		madvise(memory, size, MADV_HUGEPAGE);
+	}
+
+	return memory;
+}
+
+static void commit_virtual_memory(u8* address, u64 size)
+{
+	mprotect(address, size, PROT_READ | PROT_WRITE);
+}
+
+static void decommit_virtual_memory(u8* address, u64 size)
+{
+	mprotect(address, size, PROT_NONE);
+	madvise(address, size, MADV_DONTNEED);
+}
+
+static void release_virtual_memory(u8* address, u64 size)
+{
+	munmap(address, size);
+}
+
+#endif
+
+#if ARENA_STATISTICS
+
+struct ArenaRegistryEntry
+{
+	ArenaStats stats;
+	u32 live_count;
+	u32 total_count;
+};
+
+struct ArenaRegistry
+{
+	std::mutex mutex;
+	std::vector<Arena*> arenas;
+	std::vector<ConcurrentArena*> concurrent_arenas;
+	std::vector<ArenaRegistryEntry> retired; // Accumulated statistics of destroyed arenas, one entry per tag.
+};
+
+static ArenaRegistry& get_arena_registry()
+{
+	// Intentionally leaked, so that static and thread local arenas can still unregister during shutdown.
+	static ArenaRegistry* registry = new ArenaRegistry;
+	return *registry;
+}
+
+static ArenaRegistryEntry& find_registry_entry(std::vector<ArenaRegistryEntry>& entries, const char* tag)
+{
+	for (ArenaRegistryEntry& entry : entries)
+	{
+		if (strcmp(entry.stats.tag, tag) == 0)
+		{
+			return entry;
+		}
+	}
+
+	ArenaRegistryEntry& entry = entries.emplace_back();
+	entry = {};
+	entry.stats.tag = tag;
+	return entry;
+}
+
+static void accumulate_stats(ArenaStats& total, const ArenaStats& stats)
+{
+	total.used += stats.used;
+	total.committed += stats.committed;
+	total.reserved += stats.reserved;
+	total.decommit_count += stats.decommit_count;
+	total.decommitted_bytes += stats.decommitted_bytes;
+
+	// Arenas are sized individually, so the largest peak is more useful than the sum.
+	total.peak = max(total.peak, stats.peak);
+	total.commit_count += stats.commit_count;
+	total.allocation_count += stats.allocation_count;
+	total.allocated_bytes += stats.allocated_bytes;
+	for (u32 i = 0; i < arena_histogram_bucket_count; ++i)
+	{
+		total.allocation_size_histogram[i] += stats.allocation_size_histogram[i];
+	}
+}
+
+static std::vector<Arena*>& get_live_arenas(ArenaRegistry& registry, Arena*) { return registry.arenas; }
+static std::vector<ConcurrentArena*>& get_live_arenas(ArenaRegistry& registry, ConcurrentArena*) { return registry.concurrent_arenas; }
+
+template <typename arena_t>
+static void register_arena(arena_t* arena)
+{
+	ArenaRegistry& registry = get_arena_registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	get_live_arenas(registry, arena).push_back(arena);
+}
+
+template <typename arena_t>
+static void retire_arena(arena_t* arena)
+{
+	ArenaRegistry& registry = get_arena_registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	ArenaRegistryEntry& entry = find_registry_entry(registry.retired, arena->tag);
+	accumulate_stats(entry.stats, arena->get_stats());
+	++entry.total_count;
+}
 
-	page_size = systemInfo.dwPageSize;
+template <typename arena_t>
+static void unregister_arena(arena_t* arena)
+{
+	ArenaRegistry& registry = get_arena_registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::vector<arena_t*>& arenas = get_live_arenas(registry, arena);
+	for (arena_t*& a : arenas)
+	{
+		if (a == arena)
+		{
+			a = arenas.back();
+			arenas.pop_back();
+			break;
+		}
+	}
+}
+
+static u32 get_histogram_bucket(u64 size)
+{
+	u32 bucket = 0;
+	while (size >>= 1)
+	{
+		++bucket;
+	}
+	return min(bucket, arena_histogram_bucket_count - 1);
+}
+
+#endif
+
+Arena::Arena(const char* tag, u64 reserve_address_space, bool use_large_pages)
+	: Arena(reserve_address_space, use_large_pages)
+{
+	this->tag = tag;
+}
+
+Arena::Arena(u64 reserve_address_space, bool use_large_pages)
+{
+#if ARENA_STATISTICS
+	register_arena(this);
+#endif
+
+	page_size = get_page_size();
+	large_pages = use_large_pages;
+	commit_size = large_pages ? large_page_commit_size : max(minimum_commit_size, page_size);
 
-	reserved = align_to(reserve_address_space, page_size);
-	memory = (u8*)VirtualAlloc(0, reserved, MEM_RESERVE, PAGE_READWRITE);
+	reserved = align_to(reserve_address_space, commit_size);
+	memory = reserve_virtual_memory(reserved, large_pages);
 }
 
 Arena::Arena(Arena&& o) noexcept
 {
+#if ARENA_STATISTICS
+	register_arena(this);
+#endif
 	*this = std::move(o);
 }
 
@@ -22,21 +243,47 @@ void Arena::operator=(Arena&& o) noexcept
 {
 	if (memory)
 	{
-		VirtualFree(memory, 0, MEM_RELEASE);
+#if ARENA_STATISTICS
+		retire_arena(this);
+#endif
+		release_virtual_memory(memory, reserved);
 	}
 
+	tag = o.tag;
 	memory = std::exchange(o.memory, nullptr);
 	reserved = o.reserved;
 	current = o.current;
 	committed = o.committed;
 	page_size = o.page_size;
+	commit_size = o.commit_size;
+	large_pages = o.large_pages;
+	decommit_high_water_mark = o.decommit_high_water_mark;
+	decommit_after_resets = o.decommit_after_resets;
+	resets_below_high_water_mark = o.resets_below_high_water_mark;
+	decommit_count = o.decommit_count;
+	decommitted_bytes = o.decommitted_bytes;
+
+#if ARENA_STATISTICS
+	peak = o.peak;
+	commit_count = o.commit_count;
+	allocation_count = o.allocation_count;
+	allocated_bytes = o.allocated_bytes;
+	memcpy(allocation_size_histogram, o.allocation_size_histogram, sizeof(allocation_size_histogram));
+#endif
 }
 
 Arena::~Arena()
 {
+#if ARENA_STATISTICS
+	unregister_arena(this);
+#endif
+
 	if (memory)
 	{
-		VirtualFree(memory, 0, MEM_RELEASE);
+#if ARENA_STATISTICS
+		retire_arena(this);
+#endif
+		release_virtual_memory(memory, reserved);
 	}
 }
 
@@ -59,6 +306,13 @@ void* Arena::allocate(u64 size, u64 alignment, bool clear_to_zero)
 		memset(result, 0, size);
 	}
 
+#if ARENA_STATISTICS
+	peak = max(peak, current);
+	++allocation_count;
+	allocated_bytes += size;
+	++allocation_size_histogram[get_histogram_bucket(size)];
+#endif
+
 	return result;
 }
 
@@ -76,12 +330,16 @@ void Arena::ensure_free(u64 size, u64 alignment)
 	if (aligned_current + size > committed)
 	{
 		u64 allocation = aligned_current + size - committed;
-		allocation = max(allocation, minimum_commit_size);
-		allocation = align_to(allocation, page_size);
+		allocation = align_to(allocation, commit_size);
+		allocation = min(allocation, reserved - committed);
 
-		VirtualAlloc(memory + committed, allocation, MEM_COMMIT, PAGE_READWRITE);
+		commit_virtual_memory(memory + committed, allocation);
 
 		committed += allocation;
+
+#if ARENA_STATISTICS
+		++commit_count;
+#endif
 	}
 }
 
@@ -93,6 +351,273 @@ void Arena::reset()
 void Arena::reset_to(u64 offset)
 {
 	ASSERT(offset <= current);
+
+	u64 used = current;
 	current = offset;
+
+	if (committed > decommit_high_water_mark)
+	{
+		// Only count resets of arenas which stayed below the high water mark. Otherwise we would keep
+		// decommitting and recommitting memory which is in fact needed every cycle.
+		resets_below_high_water_mark = (used <= decommit_high_water_mark) ? resets_below_high_water_mark + 1 : 0;
+
+		if (resets_below_high_water_mark >= decommit_after_resets)
+		{
+			trim(decommit_high_water_mark);
+			resets_below_high_water_mark = 0;
+		}
+	}
+}
+
+void Arena::trim(u64 keep_committed)
+{
+	u64 new_committed = align_to(max(current, keep_committed), commit_size);
+
+	if (memory && new_committed < committed)
+	{
+		decommit_virtual_memory(memory + new_committed, committed - new_committed);
+
+		++decommit_count;
+		decommitted_bytes += committed - new_committed;
+
+		committed = new_committed;
+	}
+}
+
+void Arena::set_decommit_policy(u64 high_water_mark, u32 resets_before_decommit)
+{
+	decommit_high_water_mark = high_water_mark;
+	decommit_after_resets = resets_before_decommit;
+	resets_below_high_water_mark = 0;
+}
+
+ArenaStats Arena::get_stats() const
+{
+	ArenaStats stats = {};
+	stats.tag = tag;
+	stats.used = current;
+	stats.committed = committed;
+	stats.reserved = reserved;
+	stats.decommit_count = decommit_count;
+	stats.decommitted_bytes = decommitted_bytes;
+
+#if ARENA_STATISTICS
+	stats.peak = peak;
+	stats.commit_count = commit_count;
+	stats.allocation_count = allocation_count;
+	stats.allocated_bytes = allocated_bytes;
+	memcpy(stats.allocation_size_histogram, allocation_size_histogram, sizeof(allocation_size_histogram));
+#endif
+
+	return stats;
+}
+
+ConcurrentArena::ConcurrentArena(const char* tag, u64 reserve_address_space, bool use_large_pages)
+	: ConcurrentArena(reserve_address_space, use_large_pages)
+{
+	this->tag = tag;
+}
+
+ConcurrentArena::ConcurrentArena(u64 reserve_address_space, bool use_large_pages)
+{
+#if ARENA_STATISTICS
+	register_arena(this);
+#endif
+
+	large_pages = use_large_pages;
+	commit_size = max(large_pages ? Arena::large_page_commit_size : max(Arena::minimum_commit_size, get_page_size()), concurrent_commit_size);
+
+	reserved = align_to(reserve_address_space, commit_size);
+	memory = reserve_virtual_memory(reserved, large_pages);
+}
+
+ConcurrentArena::~ConcurrentArena()
+{
+#if ARENA_STATISTICS
+	unregister_arena(this);
+#endif
+
+	if (memory)
+	{
+#if ARENA_STATISTICS
+		retire_arena(this);
+#endif
+		release_virtual_memory(memory, reserved);
+	}
+}
+
+void* ConcurrentArena::allocate(u64 size, u64 alignment, bool clear_to_zero)
+{
+	if (!memory || size == 0)
+	{
+		return 0;
+	}
+
+	ASSERT((alignment & (alignment - 1)) == 0);
+
+	// The reservation is page aligned, so aligning the offset aligns the address. Reserving the worst case padding
+	// up front lets every thread claim its range with a single atomic instruction.
+	u64 offset = current.fetch_add(size + alignment - 1, std::memory_order_relaxed);
+	offset = align_to(offset, alignment);
+
+	u64 end = offset + size;
+	ASSERT(end <= reserved);
+
+	if (end > committed.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(commit_mutex);
+
+		// Another thread may have committed this range while we were waiting for the lock.
+		u64 committed_end = committed.load(std::memory_order_relaxed);
+		if (end > committed_end)
+		{
+			u64 allocation = align_to(end - committed_end, commit_size);
+			allocation = min(allocation, reserved - committed_end);
+
+			commit_virtual_memory(memory + committed_end, allocation);
+
+			committed.store(committed_end + allocation, std::memory_order_release);
+
+#if ARENA_STATISTICS
+			++commit_count;
+#endif
+		}
+	}
+
+	u8* result = memory + offset;
+
+	if (clear_to_zero)
+	{
+		memset(result, 0, size);
+	}
+
+	return result;
+}
+
+void ConcurrentArena::reset()
+{
+#if ARENA_STATISTICS
+	peak = max(peak, current.load(std::memory_order_relaxed));
+#endif
+
+	current.store(0, std::memory_order_relaxed);
+}
+
+ArenaStats ConcurrentArena::get_stats() const
+{
+	ArenaStats stats = {};
+	stats.tag = tag;
+	stats.used = current.load(std::memory_order_relaxed);
+	stats.committed = committed.load(std::memory_order_relaxed);
+	stats.reserved = reserved;
+
+#if ARENA_STATISTICS
+	// The bump pointer only grows between resets.
+	stats.peak = max(peak, stats.used);
+	stats.commit_count = commit_count;
+#endif
+
+	return stats;
+}
+
+static Arena create_scratch_arena()
+{
+	// Scratch arenas live as long as their thread. Don't let a single large temporary allocation pin
+	// its memory for the rest of the thread's life.
+	Arena arena("Thread scratch");
+	arena.set_decommit_policy(MB(64), 64);
+	return arena;
+}
+
+ScratchArena get_thread_scratch(Arena* conflict)
+{
+	// Two arenas are enough to always hand out one which does not conflict with the caller's.
+	thread_local Arena scratch_arenas[2] = { create_scratch_arena(), create_scratch_arena() };
+
+	for (Arena& arena : scratch_arenas)
+	{
+		if (&arena != conflict)
+		{
+			return ScratchArena(arena);
+		}
+	}
+
+	ASSERT(false);
+	return ScratchArena(scratch_arenas[0]);
 }
 
+void print_arena_statistics()
+{
+#if ARENA_STATISTICS
+	ArenaRegistry& registry = get_arena_registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::vector<ArenaRegistryEntry> entries = registry.retired;
+	for (ArenaRegistryEntry& entry : entries)
+	{
+		// Destroyed arenas don't hold any memory anymore.
+		entry.stats.used = entry.stats.committed = entry.stats.reserved = 0;
+	}
+
+	auto add_live_arena = [&entries](const auto* arena)
+	{
+		if (arena->memory)
+		{
+			ArenaRegistryEntry& entry = find_registry_entry(entries, arena->tag);
+			accumulate_stats(entry.stats, arena->get_stats());
+			++entry.live_count;
+			++entry.total_count;
+		}
+	};
+
+	for (Arena* arena : registry.arenas)
+	{
+		add_live_arena(arena);
+	}
+	for (ConcurrentArena* arena : registry.concurrent_arenas)
+	{
+		add_live_arena(arena);
+	}
+
+	auto kb = [](u64 bytes) { return (bytes + KB(1) - 1) / KB(1); };
+
+	std::cout << "Arena statistics (sizes in KB, peak is the largest of any single arena):\n";
+	std::cout << std::left << std::setw(32) << "Tag" << std::right
+		<< std::setw(12) << "Live/Total"
+		<< std::setw(12) << "Used"
+		<< std::setw(12) << "Peak"
+		<< std::setw(12) << "Committed"
+		<< std::setw(12) << "Reserved"
+		<< std::setw(10) << "Commits"
+		<< std::setw(12) << "Decommits"
+		<< std::setw(14) << "Allocations"
+		<< std::setw(12) << "Avg size" << '\n';
+
+	for (const ArenaRegistryEntry& entry : entries)
+	{
+		const ArenaStats& stats = entry.stats;
+		u64 average_size = stats.allocation_count ? stats.allocated_bytes / stats.allocation_count : 0;
+
+		std::cout << std::left << std::setw(32) << stats.tag << std::right
+			<< std::setw(12) << (std::to_string(entry.live_count) + "/" + std::to_string(entry.total_count))
+			<< std::setw(12) << kb(stats.used)
+			<< std::setw(12) << kb(stats.peak)
+			<< std::setw(12) << kb(stats.committed)
+			<< std::setw(12) << kb(stats.reserved)
+			<< std::setw(10) << stats.commit_count
+			<< std::setw(12) << stats.decommit_count
+			<< std::setw(14) << stats.allocation_count
+			<< std::setw(12) << average_size << '\n';
+
+		std::cout << "    Sizes:";
+		for (u32 i = 0; i < arena_histogram_bucket_count; ++i)
+		{
+			if (stats.allocation_size_histogram[i])
+			{
+				std::cout << " [" << (1ull << i) << "B+] " << stats.allocation_size_histogram[i];
+			}
+		}
+		std::cout << '\n';
+	}
+#endif
+}
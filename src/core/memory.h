@@ -3,6 +3,8 @@
 #include "common.h"
 #include "range.h"
 
+#include <atomic>
+
 #define KB(n) (1024ull * (n))
 #define MB(n) (1024ull * KB(n))
 #define GB(n) (1024ull * MB(n))
@@ -18,9 +20,45 @@ static constexpr T align_to(T offset, T alignment)
 	return offset + adjustment;
 }
 
+// Per arena allocation statistics and the global arena registry are compiled in with ARENA_STATISTICS, which
+// defaults to on in debug builds.
+#if !defined(ARENA_STATISTICS)
+#if defined(_DEBUG)
+#define ARENA_STATISTICS 1
+#else
+#define ARENA_STATISTICS 0
+#endif
+#endif
+
+static constexpr u32 arena_histogram_bucket_count = 32;
+
+struct ArenaStats
+{
+	const char* tag;
+
+	u64 used;
+	u64 committed;
+	u64 reserved;
+
+	u64 decommit_count;
+	u64 decommitted_bytes;
+
+	// Only collected with ARENA_STATISTICS, zero otherwise.
+	u64 peak;
+	u64 commit_count;
+	u64 allocation_count;
+	u64 allocated_bytes;
+	u64 allocation_size_histogram[arena_histogram_bucket_count]; // Bucket i counts allocations of [2^i, 2^(i+1)) bytes.
+};
+
 struct Arena
 {
-	Arena(u64 reserve_address_space = GB(1));
+	// With use_large_pages, the arena commits memory in large_page_commit_size granules. On Linux the
+	// reservation is additionally aligned to 2 MB and backed by transparent huge pages, which cuts the
+	// number of page faults and TLB misses for very large arenas. Windows only supports large pages for
+	// memory which is committed at reservation time, so there only the commit granularity changes.
+	Arena(u64 reserve_address_space = GB(1), bool use_large_pages = false);
+	Arena(const char* tag, u64 reserve_address_space = GB(1), bool use_large_pages = false);
 	Arena(const Arena&) = delete;
 	Arena(Arena&& o) noexcept;
 	
@@ -58,8 +96,19 @@ struct Arena
 	void reset();
 	void reset_to(u64 offset);
 
+	// Returns all committed pages above max(current, keep_committed) to the operating system.
+	void trim(u64 keep_committed = 0);
+
+	// Decommits everything above the high water mark once the arena has been reset resets_before_decommit
+	// times in a row with less than high_water_mark bytes in use, but more than that committed.
+	void set_decommit_policy(u64 high_water_mark, u32 resets_before_decommit);
+
+	ArenaStats get_stats() const;
+
 
 
+	// Groups arenas in the statistics report. Must point to a string which outlives the arena, usually a literal.
+	const char* tag = "Untagged";
 
 	u8* memory = 0;
 	u64 current = 0;
@@ -67,8 +116,92 @@ struct Arena
 	u64 committed = 0;
 
 	u64 page_size = 0;
+	u64 commit_size = 0;
+	bool large_pages = false;
+
+	u64 decommit_high_water_mark = UINT64_MAX;
+	u32 decommit_after_resets = 0;
+	u32 resets_below_high_water_mark = 0;
+
+	u64 decommit_count = 0;
+	u64 decommitted_bytes = 0;
+
+#if ARENA_STATISTICS
+	u64 peak = 0;
+	u64 commit_count = 0;
+	u64 allocation_count = 0;
+	u64 allocated_bytes = 0;
+	u64 allocation_size_histogram[arena_histogram_bucket_count] = {};
+#endif
 
 	static constexpr u64 minimum_commit_size = KB(4);
+	static constexpr u64 large_page_commit_size = MB(2);
+};
+
+// Arena which many threads can allocate from at once. The bump pointer advances with an atomic fetch-add, and
+// memory is committed in chunks of at least concurrent_commit_size under a mutex, so the lock is only taken about
+// once per chunk. Allocations are padded by alignment - 1 bytes to stay lock-free, so prefer Arena for many small,
+// highly aligned allocations from a single thread. Resetting must not race with allocations.
+// With ARENA_STATISTICS, the statistics only include the peak and the commit count, since counting allocations
+// would add contended atomics to every allocation.
+struct ConcurrentArena
+{
+	ConcurrentArena(u64 reserve_address_space = GB(1), bool use_large_pages = false);
+	ConcurrentArena(const char* tag, u64 reserve_address_space = GB(1), bool use_large_pages = false);
+	ConcurrentArena(const ConcurrentArena&) = delete;
+
+	void operator=(const ConcurrentArena&) = delete;
+
+	~ConcurrentArena();
+
+
+	void* allocate(u64 size, u64 alignment = 1, bool clear_to_zero = false);
+
+	template <typename T>
+	T* allocate(u64 count = 1, bool clear_to_zero = false)
+	{
+		return (T*)allocate(sizeof(T) * count, alignof(T), clear_to_zero);
+	}
+
+	template <typename T>
+	Range<T> allocate_range(u64 count, bool clear_to_zero = false)
+	{
+		return Range<T>{ allocate<T>(count, clear_to_zero), count };
+	}
+
+	template <typename T, typename... Args>
+	T* construct(Args&& ...args)
+	{
+		T* result = allocate<T>(1, false);
+		result = new(result) T(std::forward<Args>(args)...);
+		return result;
+	}
+
+	void reset();
+
+	ArenaStats get_stats() const;
+
+
+
+	// Groups arenas in the statistics report. Must point to a string which outlives the arena, usually a literal.
+	const char* tag = "Untagged";
+
+	u8* memory = 0;
+	std::atomic<u64> current = 0;
+	std::atomic<u64> committed = 0;
+	u64 reserved = 0;
+
+	u64 commit_size = 0;
+	bool large_pages = false;
+
+	std::mutex commit_mutex;
+
+#if ARENA_STATISTICS
+	u64 peak = 0;
+	u64 commit_count = 0; // Only changed under commit_mutex.
+#endif
+
+	static constexpr u64 concurrent_commit_size = MB(1);
 };
 
 struct ArenaMarker
@@ -86,3 +219,22 @@ struct ArenaMarker
 	u64 current;
 };
 
+// Thread local arenas for temporary allocations. The returned scratch arena resets to its previous
+// position when it goes out of scope, so scratch arenas must be released in reverse order of acquisition.
+// A function which receives an arena from its caller and needs a scratch arena itself must pass the
+// received arena as conflict. Otherwise both may alias the same arena and overwrite each other's data.
+struct ScratchArena
+{
+	ScratchArena(Arena& arena) : arena(arena), marker(arena) {}
+
+	operator Arena&() { return arena; }
+
+	Arena& arena;
+	ArenaMarker marker;
+};
+
+ScratchArena get_thread_scratch(Arena* conflict = nullptr);
+
+// Prints a table of all arenas, live and destroyed, grouped by tag. Statistics of arenas which are in use by other
+// threads are read without synchronization, so they may be slightly off. Does nothing without ARENA_STATISTICS.
+void print_arena_statistics();
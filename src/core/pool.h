@@ -0,0 +1,164 @@
+#pragma once
+
+#include "memory.h"
+#include "lock_free.h"
+
+// Thread safe fixed size block allocator for objects of type T. Blocks are carved out of the given arena and recycled
+// through a LockFreeStack, so allocating and freeing are O(1). The arena is only touched under a mutex when the free
+// list runs dry, and then a whole batch of blocks is carved out at once. The arena must outlive the pool, must not be
+// reset while blocks are still in use and must not be used by anyone else while the pool is alive. Pools only pay
+// off for long-lived owners which free and reallocate blocks. Objects which are all released together, e.g. with a
+// scratch arena, should come straight from the arena.
+template <typename T>
+struct ConcurrentPool
+{
+	ConcurrentPool(Arena& arena, u32 blocks_per_refill = 16) : arena(arena), blocks_per_refill(blocks_per_refill) {}
+	ConcurrentPool(const ConcurrentPool&) = delete;
+
+	void operator=(const ConcurrentPool&) = delete;
+
+
+	T* allocate()
+	{
+		FreeBlock* block = free_blocks.pop();
+		if (!block)
+		{
+			block = refill();
+		}
+		return (T*)block;
+	}
+
+	void free(T* item)
+	{
+		free_blocks.push(new(item) FreeBlock);
+	}
+
+	template <typename... Args>
+	T* construct(Args&& ...args)
+	{
+		return new(allocate()) T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* item)
+	{
+		item->~T();
+		free(item);
+	}
+
+private:
+	struct FreeBlock : LockFreeLink {};
+
+	static constexpr u64 block_size = max(sizeof(T), sizeof(FreeBlock));
+	static constexpr u64 block_alignment = max(alignof(T), alignof(FreeBlock));
+
+	FreeBlock* refill()
+	{
+		u8* blocks;
+		{
+			std::lock_guard<std::mutex> lock(arena_mutex);
+			blocks = (u8*)arena.allocate(block_size * blocks_per_refill, block_alignment);
+		}
+
+		if (!blocks)
+		{
+			return nullptr;
+		}
+
+		// Keep the first block for the caller and publish the rest.
+		if (blocks_per_refill > 1)
+		{
+			FreeBlock* first = new(blocks + block_size) FreeBlock;
+			FreeBlock* last = first;
+			for (u32 i = 2; i < blocks_per_refill; ++i)
+			{
+				FreeBlock* block = new(blocks + i * block_size) FreeBlock;
+				last->next_link.store(block, std::memory_order_relaxed);
+				last = block;
+			}
+			free_blocks.push_chain(first, last, blocks_per_refill - 1);
+		}
+
+		return (FreeBlock*)blocks;
+	}
+
+	Arena& arena;
+	u32 blocks_per_refill;
+
+	LockFreeStack<FreeBlock> free_blocks;
+	std::mutex arena_mutex;
+
+public:
+	// Optional cache, owned by a single thread. Allocations and frees go through a private free list and only
+	// touch the shared stack when the cache runs empty or holds too many blocks.
+	struct Cache
+	{
+		Cache(ConcurrentPool& pool, u32 max_cached_blocks = 64) : pool(pool), max_cached_blocks(max_cached_blocks) {}
+		Cache(const Cache&) = delete;
+		~Cache() { flush(); }
+
+		void operator=(const Cache&) = delete;
+
+
+		T* allocate()
+		{
+			FreeBlock* block = first;
+			if (!block)
+			{
+				return pool.allocate();
+			}
+
+			first = LockFreeStack<FreeBlock>::next(block);
+			if (!first)
+			{
+				last = nullptr;
+			}
+			--count;
+			return (T*)block;
+		}
+
+		void free(T* item)
+		{
+			FreeBlock* block = new(item) FreeBlock;
+			block->next_link.store(first, std::memory_order_relaxed);
+			first = block;
+			if (!last)
+			{
+				last = block;
+			}
+
+			if (++count > max_cached_blocks)
+			{
+				flush();
+			}
+		}
+
+		template <typename... Args>
+		T* construct(Args&& ...args)
+		{
+			return new(allocate()) T(std::forward<Args>(args)...);
+		}
+
+		void destroy(T* item)
+		{
+			item->~T();
+			free(item);
+		}
+
+		void flush()
+		{
+			if (first)
+			{
+				pool.free_blocks.push_chain(first, last, count);
+				first = last = nullptr;
+				count = 0;
+			}
+		}
+
+	private:
+		ConcurrentPool& pool;
+		FreeBlock* first = nullptr;
+		FreeBlock* last = nullptr;
+		u32 count = 0;
+		u32 max_cached_blocks;
+	};
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "wide_math.h"
+
+// Counter-based random numbers. Every value is a pure function of its coordinates (pixel x, pixel y, sample,
+// dimension), so any sample can be regenerated on any thread, in any order and on the GPU (see random_bits in
+// shaders/util.hlsli), without seeds or state to pass around. Each coordinate gives four independent 32 bit values;
+// use a new dimension for every further random decision along a path.
+//
+// The hash is pcg4d from Jarzynski and Olano, "Hash Functions for GPU Rendering" (JCGT 2020), which only uses 32 bit
+// multiplies, adds, xors and shifts. The functions are templates on the integer type and work on u32 as well as on
+// the wide ints, which give the same bits in every lane. random_bits and random_float are therefore bit for bit the
+// same for u32, w4, w8 and w16. The hemisphere samples go through sqrt, sin and cos, and match bit for bit between
+// builds with the same fmadd (fused with FMA, separate without, see simd_scalar.h).
+//
+// Only simd.h and wide_math.h are included, so that the kernels in simd_kernels_impl.h can use these too. The
+// versions on the math.h types are in math.h.
+// See the random case of the Benchmarks project for speeds.
+
+#if defined(SIMD_NAMESPACE)
+namespace SIMD_NAMESPACE {
+#endif
+
+template <typename int_t>
+struct RandomBits
+{
+	int_t x, y, z, w;
+};
+
+template <typename int_t>
+static RandomBits<int_t> random_bits(int_t pixel_x, int_t pixel_y, int_t sample, int_t dimension)
+{
+	int_t x = pixel_x * 1664525 + 1013904223;
+	int_t y = pixel_y * 1664525 + 1013904223;
+	int_t z = sample * 1664525 + 1013904223;
+	int_t w = dimension * 1664525 + 1013904223;
+
+	x += y * w; y += z * x; z += x * y; w += y * z;
+
+	x ^= x >> 16; y ^= y >> 16; z ^= z >> 16; w ^= w >> 16;
+
+	x += y * w; y += z * x; z += x * y; w += y * z;
+
+	return { x, y, z, w };
+}
+
+// Uniform in [0, 1), from the top 24 bits, so that every step is exact.
+static float random_bits_to_float(u32 bits) { return (float)(bits >> 8) * (1.f / 16777216.f); }
+template <typename int_t> static auto random_bits_to_float(int_t bits) { return convert(bits >> 8) * (1.f / 16777216.f); }
+
+template <typename int_t>
+static auto random_float(int_t pixel_x, int_t pixel_y, int_t sample, int_t dimension)
+{
+	return random_bits_to_float(random_bits(pixel_x, pixel_y, sample, dimension).x);
+}
+
+// Two independent uniform floats in [0, 1), e.g. as E for the sample functions below.
+template <typename int_t>
+static auto random_vec2(int_t pixel_x, int_t pixel_y, int_t sample, int_t dimension)
+{
+	RandomBits<int_t> bits = random_bits(pixel_x, pixel_y, sample, dimension);
+	using float_t = decltype(random_bits_to_float(bits.x));
+	return wN_vec2<float_t>(random_bits_to_float(bits.x), random_bits_to_float(bits.y));
+}
+
+// Directions around +z. W = PDF = 1 / 2pi.
+template <typename float_t>
+static wN_vec4<float_t> uniform_sample_hemisphere(const wN_vec2<float_t>& E)
+{
+	float_t phi = E.x * 6.28318531f;
+	float_t cos_theta = E.y;
+	float_t sin_theta = sqrt(maximum(1.f - cos_theta * cos_theta, 0.f));
+
+	return { sin_theta * cos(phi), sin_theta * sin(phi), cos_theta, float_t(0.159154943f) };
+}
+
+// Directions around +z. W = PDF = cos(theta) / pi.
+template <typename float_t>
+static wN_vec4<float_t> cosine_sample_hemisphere(const wN_vec2<float_t>& E)
+{
+	float_t phi = E.x * 6.28318531f;
+	float_t r = sqrt(E.y);
+	float_t cos_theta = sqrt(maximum(1.f - E.y, 0.f));
+
+	return { r * cos(phi), r * sin(phi), cos_theta, cos_theta * 0.318309886f };
+}
+
+#if defined(SIMD_NAMESPACE)
+}
+#endif
@@ -2,6 +2,9 @@
 
 #include "common.h"
 
+#include <vector>
+#include <utility>
+
 template <typename T>
 struct RangeIterator
 {
@@ -2,13 +2,24 @@
 
 #include "common.h"
 
+// The wide types w4_float/w4_int, w8_float/w8_int and w16_float/w16_int map to SSE, AVX2 and AVX-512 registers if
+// the target supports them. Every width without instructions falls back to the scalar implementation in
+// simd_scalar.h, so all widths are always available. Define SIMD_SCALAR (e.g. in the build configuration) to use
+// the scalar implementation for all widths, which is what the SIMD results should be compared against.
+
+#if !defined(SIMD_SCALAR) && !defined(_M_X64) && !defined(__x86_64__)
+#define SIMD_SCALAR
+#endif
+
+#if !defined(SIMD_SCALAR)
+
 #include <emmintrin.h>
 #include <immintrin.h>
 
 #define SIMD_SSE_2 // All x64 processors support SSE2.
 
 #if defined(__AVX__)
-#if defined(__AVX512F__)
+#if defined(__AVX512F__) && defined(__AVX512VL__)
 #define SIMD_AVX_512
 #define SIMD_AVX_2
 #elif defined(__AVX2__)
@@ -18,151 +29,32 @@
 #endif
 #endif
 
+// GCC and Clang only accept intrinsics of enabled instruction sets, so the SSE2 path needs alternatives for
+// everything newer. MSVC does not announce SSE4.1 and FMA on their own, it enables them with /arch:AVX2.
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define SIMD_SSE_4_1
+#endif
 
-#define POLY0(x, c0) (c0)
-#define POLY1(x, c0, c1) fmadd(POLY0(x, c1), x, (c0))
-#define POLY2(x, c0, c1, c2) fmadd(POLY1(x, c1, c2), x, (c0))
-#define POLY3(x, c0, c1, c2, c3) fmadd(POLY2(x, c1, c2, c3), x, (c0))
-#define POLY4(x, c0, c1, c2, c3, c4) fmadd(POLY3(x, c1, c2, c3, c4), x, (c0))
-
-
-template <typename float_t>
-static float_t cos_internal(float_t x)
-{
-	const float_t tp = 1.f / (2.f * 3.14159265359f);
-	const float_t q = 0.25f;
-	const float_t h = 0.5f;
-	const float_t o = 1.f;
-	const float_t s = 16.f;
-	const float_t v = 0.225f;
-
-	x *= tp;
-	x -= q + floor(x + q);
-	x *= s * (abs(x) - h);
-	x += v * x * (abs(x) - o);
-	return x;
-}
-
-template <typename float_t> 
-static float_t sin_internal(float_t x) 
-{ 
-	return cos_internal(x - (3.14159265359f * 0.5f)); 
-}
-
-template <typename float_t, typename int_t>
-static float_t exp2_internal(float_t x)
-{
-	x = minimum(x, 129.00000f);
-	x = maximum(x, -126.99999f);
-
-	int_t ipart = convert(x - 0.5f);
-	float_t fpart = x - convert(ipart);
-	float_t expipart = reinterpret((ipart + 127) << 23);
-	float_t expfpart = POLY3(fpart, 9.9992520e-1f, 6.9583356e-1f, 2.2606716e-1f, 7.8024521e-2f);
-	return expipart * expfpart;
-}
-
-template <typename float_t, typename int_t>
-static float_t log2_internal(float_t x)
-{
-	int_t exp = 0x7F800000;
-	int_t mant = 0x007FFFFF;
-
-	float_t one = 1;
-	int_t i = reinterpret(x);
-
-	float_t e = convert(((i & exp) >> 23) - 127);
-	float_t m = reinterpret(i & mant) | one;
-	float_t p = POLY4(m, 2.8882704548164776201f, -2.52074962577807006663f, 1.48116647521213171641f, -0.465725644288844778798f, 0.0596515482674574969533f);
-
-	return fmadd(p, m - one, e);
-}
-
-template <typename float_t, typename int_t>
-static float_t pow_internal(float_t x, float_t y)
-{
-	return exp2_internal<float_t, int_t>(log2_internal<float_t, int_t>(x) * y);
-}
-
-template <typename float_t, typename int_t>
-static float_t exp_internal(float_t x)
-{
-	float_t a = 12102203.f; // (1 << 23) / log(2).
-	int_t b = 127 * (1 << 23) - 298765;
-	int_t t = convert(a * x) + b;
-	return reinterpret(t);
-}
-
-template <typename float_t>
-static float_t tanh_internal(float_t x)
-{
-	float_t a = exp(x);
-	float_t b = exp(-x);
-	return (a - b) / (a + b);
-}
-
-template <typename float_t, typename int_t>
-static float_t atan_internal(float_t x)
-{
-	const int_t sign_mask = 0x80000000;
-	const float_t b = 0.596227f;
-
-	// Extract the sign bit.
-	int_t ux_s = sign_mask & reinterpret(x);
-
-	// Calculate the arctangent in the first quadrant.
-	float_t bx_a = abs(b * x);
-	float_t num = fmadd(x, x, bx_a);
-	float_t atan_1q = num / (1.f + bx_a + num);
-
-	// Restore the sign bit.
-	int_t atan_2q = ux_s | reinterpret(atan_1q);
-	return reinterpret(atan_2q) * float_t(3.14159265359f * 0.5f);
-}
-
-template <typename float_t, typename int_t>
-static float_t atan2_internal(float_t y, float_t x)
-{
-	const int_t sign_mask = 0x80000000;
-	const float_t b = 0.596227f;
-
-	// Extract the sign bits.
-	int_t ux_s = sign_mask & reinterpret(x);
-	int_t uy_s = sign_mask & reinterpret(y);
-
-	// Determine the quadrant offset.
-	float_t q = convert(((~ux_s & uy_s) >> 29) | (ux_s >> 30));
-
-	// Calculate the arctangent in the first quadrant.
-	float_t bxy_a = abs(b * x * y);
-	float_t num = fmadd(y, y, bxy_a);
-	float_t atan_1q = num / (fmadd(x, x, bxy_a + num));
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMD_FMA
+#endif
 
-	// Translate it to the proper quadrant.
-	int_t uatan_2q = (ux_s ^ uy_s) | reinterpret(atan_1q);
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMD_F16C
+#endif
 
-	float_t result04 = q + reinterpret(uatan_2q); // In the [0, 4) range for the 4 quadrants.
+#endif
 
-	auto negQuadrant = result04 >= 2.f;
-	float_t result = if_then(negQuadrant, result04 - 4.f, result04);
-	return result * float_t(3.14159265359f * 0.5f);
-}
+#include <cmath>
+#include <cstring>
+#include <type_traits>
 
-template <typename float_t>
-static float_t acos_internal(float_t x)
-{
-	// https://developer.download.nvidia.com/cg/acos.html
-
-	float_t negate = if_then(x < 0.f, 1.f, 0.f);
-	x = abs(x);
-	float_t ret = -0.0187293f;
-	ret = fmadd(ret, x, 0.0742610f);
-	ret = fmadd(ret, x, -0.2121144f);
-	ret = fmadd(ret, x, 1.5707288f);
-	ret = ret * sqrt(1.f - x);
-	ret = ret - negate * ret * float_t(2.f);
-	return fmadd(negate, 3.14159265359f, ret);
-}
+// Translation units which are compiled for a specific instruction set (see simd_kernels.h) define SIMD_NAMESPACE.
+// All wide types and functions then live in that namespace, so that their inline functions get distinct symbols
+// per instruction set and the linker can't pick e.g. the AVX2 version of a constructor for the SSE2 code.
+#if defined(SIMD_NAMESPACE)
+namespace SIMD_NAMESPACE {
+#endif
 
 
 #if defined(SIMD_SSE_2)
@@ -171,7 +63,7 @@ struct w4_float
 {
 	__m128 f;
 
-	w4_float() {}
+	w4_float() = default;
 	w4_float(float f_) { f = _mm_set1_ps(f_); }
 	w4_float(__m128 f_) { f = f_; }
 	w4_float(float a, float b, float c, float d) { f = _mm_setr_ps(a, b, c, d); }
@@ -182,11 +74,16 @@ struct w4_float
 	w4_float(const float* base_address, i32 a, i32 b, i32 c, i32 d) : w4_float(base_address, _mm_setr_epi32(a, b, c, d)) {}
 #else
 	w4_float(const float* base_address, i32 a, i32 b, i32 c, i32 d) { f = _mm_setr_ps(base_address[a], base_address[b], base_address[c], base_address[d]);  }
-	w4_float(const float* base_address, __m128i indices) : w4_float(base_address, indices.m128i_i32[0], indices.m128i_i32[1], indices.m128i_i32[2], indices.m128i_i32[3]) {}
+	w4_float(const float* base_address, __m128i indices)
+	{
+		alignas(16) i32 i[4];
+		_mm_store_si128((__m128i*)i, indices);
+		f = _mm_setr_ps(base_address[i[0]], base_address[i[1]], base_address[i[2]], base_address[i[3]]);
+	}
 #endif
 
 	operator __m128() { return f; }
-	float operator[](u32 i) const { return this->f.m128_f32[i]; }
+	float operator[](u32 i) const { alignas(16) float lanes[4]; _mm_store_ps(lanes, f); return lanes[i]; }
 
 	void store(float* f_) const { _mm_storeu_ps(f_, f); }
 
@@ -196,22 +93,24 @@ struct w4_float
 #else
 	void scatter(float* base_address, i32 a, i32 b, i32 c, i32 d) const
 	{
-		base_address[a] = this->f.m128_f32[0];
-		base_address[b] = this->f.m128_f32[1];
-		base_address[c] = this->f.m128_f32[2];
-		base_address[d] = this->f.m128_f32[3];
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, f);
+
+		base_address[a] = lanes[0];
+		base_address[b] = lanes[1];
+		base_address[c] = lanes[2];
+		base_address[d] = lanes[3];
 	}
 
 	void scatter(float* base_address, __m128i indices) const
 	{
-		base_address[indices.m128i_i32[0]] = this->f.m128_f32[0];
-		base_address[indices.m128i_i32[1]] = this->f.m128_f32[1];
-		base_address[indices.m128i_i32[2]] = this->f.m128_f32[2];
-		base_address[indices.m128i_i32[3]] = this->f.m128_f32[3];
+		alignas(16) i32 i[4];
+		_mm_store_si128((__m128i*)i, indices);
+		scatter(base_address, i[0], i[1], i[2], i[3]);
 	}
 #endif
 
-	static w4_float all_ones() { const float nnan = (const float&)0xFFFFFFFF; return nnan; }
+	static w4_float all_ones() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
 	static w4_float zero() { return _mm_setzero_ps(); }
 };
 
@@ -219,22 +118,27 @@ struct w4_int
 {
 	__m128i i;
 
-	w4_int() {}
+	w4_int() = default;
 	w4_int(i32 i_) { i = _mm_set1_epi32(i_); }
 	w4_int(__m128i i_) { i = i_; }
 	w4_int(i32 a, i32 b, i32 c, i32 d) { i = _mm_setr_epi32(a, b, c, d); }
-	w4_int(i32* i_) { i = _mm_loadu_si128((const __m128i*)i_); }
+	w4_int(const i32* i_) { i = _mm_loadu_si128((const __m128i*)i_); }
 
 #if defined(SIMD_AVX_2)
 	w4_int(const i32* base_address, __m128i indices) { i = _mm_i32gather_epi32(base_address, indices, 4); }
 	w4_int(const i32* base_address, i32 a, i32 b, i32 c, i32 d) : w4_int(base_address, _mm_setr_epi32(a, b, c, d)) {}
 #else
 	w4_int(const i32* base_address, i32 a, i32 b, i32 c, i32 d) { i = _mm_setr_epi32(base_address[a], base_address[b], base_address[c], base_address[d]); }
-	w4_int(const i32* base_address, __m128i indices) : w4_int(base_address, indices.m128i_i32[0], indices.m128i_i32[1], indices.m128i_i32[2], indices.m128i_i32[3]) {}
+	w4_int(const i32* base_address, __m128i indices)
+	{
+		alignas(16) i32 lanes[4];
+		_mm_store_si128((__m128i*)lanes, indices);
+		i = _mm_setr_epi32(base_address[lanes[0]], base_address[lanes[1]], base_address[lanes[2]], base_address[lanes[3]]);
+	}
 #endif
 
 	operator __m128i() { return i; }
-	i32 operator[](u32 i) const { return this->i.m128i_i32[i]; }
+	i32 operator[](u32 i) const { alignas(16) i32 lanes[4]; _mm_store_si128((__m128i*)lanes, this->i); return lanes[i]; }
 
 	void store(i32* i_) const { _mm_storeu_si128((__m128i*)i_, i); }
 
@@ -244,18 +148,20 @@ struct w4_int
 #else
 	void scatter(i32* base_address, i32 a, i32 b, i32 c, i32 d) const
 	{
-		base_address[a] = this->i.m128i_i32[0];
-		base_address[b] = this->i.m128i_i32[1];
-		base_address[c] = this->i.m128i_i32[2];
-		base_address[d] = this->i.m128i_i32[3];
+		alignas(16) i32 lanes[4];
+		_mm_store_si128((__m128i*)lanes, i);
+
+		base_address[a] = lanes[0];
+		base_address[b] = lanes[1];
+		base_address[c] = lanes[2];
+		base_address[d] = lanes[3];
 	}
 
 	void scatter(i32* base_address, __m128i indices) const
 	{
-		base_address[indices.m128i_i32[0]] = this->i.m128i_i32[0];
-		base_address[indices.m128i_i32[1]] = this->i.m128i_i32[1];
-		base_address[indices.m128i_i32[2]] = this->i.m128i_i32[2];
-		base_address[indices.m128i_i32[3]] = this->i.m128i_i32[3];
+		alignas(16) i32 lanes[4];
+		_mm_store_si128((__m128i*)lanes, indices);
+		scatter(base_address, lanes[0], lanes[1], lanes[2], lanes[3]);
 	}
 #endif
 
@@ -276,9 +182,27 @@ static w4_int operator+(w4_int a, w4_int b) { return _mm_add_epi32(a, b); }
 static w4_int& operator+=(w4_int& a, w4_int b) { a = a + b; return a; }
 static w4_int operator-(w4_int a, w4_int b) { return _mm_sub_epi32(a, b); }
 static w4_int& operator-=(w4_int& a, w4_int b) { a = a - b; return a; }
-static w4_int operator*(w4_int a, w4_int b) { return _mm_mul_epi32(a, b); }
+#if defined(SIMD_SSE_4_1)
+static w4_int operator*(w4_int a, w4_int b) { return _mm_mullo_epi32(a, b); }
+#else
+static w4_int operator*(w4_int a, w4_int b)
+{
+	// Multiply even and odd lanes separately and keep the low halves.
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
 static w4_int& operator*=(w4_int& a, w4_int b) { a = a * b; return a; }
-static w4_int operator/(w4_int a, w4_int b) { return _mm_div_epi32(a, b); }
+
+// There is no packed integer division. Doubles hold every i32 exactly, and the rounding error of the quotient is
+// smaller than its distance to the next integer, so truncation gives the same result as C++ integer division.
+static w4_int operator/(w4_int a, w4_int b)
+{
+	__m128d low = _mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b));
+	__m128d high = _mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2))), _mm_cvtepi32_pd(_mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+	return _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+}
 static w4_int& operator/=(w4_int& a, w4_int b) { a = a / b; return a; }
 static w4_int operator&(w4_int a, w4_int b) { return _mm_and_si128(a, b); }
 static w4_int& operator&=(w4_int& a, w4_int b) { a = a & b; return a; }
@@ -289,12 +213,40 @@ static w4_int& operator^=(w4_int& a, w4_int b) { a = a ^ b; return a; }
 
 static w4_int operator~(w4_int a) { a = and_not(a, w4_int::all_ones()); return a; }
 
-static w4_int operator>>(w4_int a, i32 b) { return _mm_srli_epi32(a, b); }
+#if defined(SIMD_AVX_2)
 static w4_int operator>>(w4_int a, w4_int b) { return _mm_srlv_epi32(a, b); }
+static w4_int operator<<(w4_int a, w4_int b) { return _mm_sllv_epi32(a, b); }
+#else
+// SSE2 only shifts all lanes by the same count.
+static w4_int operator>>(w4_int a, w4_int b)
+{
+	alignas(16) u32 lanes[4], counts[4];
+	_mm_store_si128((__m128i*)lanes, a);
+	_mm_store_si128((__m128i*)counts, b);
+	for (u32 l = 0; l < 4; ++l)
+	{
+		lanes[l] = (counts[l] < 32) ? (lanes[l] >> counts[l]) : 0;
+	}
+	return _mm_load_si128((const __m128i*)lanes);
+}
+
+static w4_int operator<<(w4_int a, w4_int b)
+{
+	alignas(16) u32 lanes[4], counts[4];
+	_mm_store_si128((__m128i*)lanes, a);
+	_mm_store_si128((__m128i*)counts, b);
+	for (u32 l = 0; l < 4; ++l)
+	{
+		lanes[l] = (counts[l] < 32) ? (lanes[l] << counts[l]) : 0;
+	}
+	return _mm_load_si128((const __m128i*)lanes);
+}
+#endif
+
+static w4_int operator>>(w4_int a, i32 b) { return _mm_srli_epi32(a, b); }
 static w4_int& operator>>=(w4_int& a, i32 b) { a = a >> b; return a; }
 static w4_int& operator>>=(w4_int& a, w4_int b) { a = a >> b; return a; }
 static w4_int operator<<(w4_int a, i32 b) { return _mm_slli_epi32(a, b); }
-static w4_int operator<<(w4_int a, w4_int b) { return _mm_sllv_epi32(a, b); }
 static w4_int& operator<<=(w4_int& a, i32 b) { a = a << b; return a; }
 static w4_int& operator<<=(w4_int& a, w4_int b) { a = a << b; return a; }
 
@@ -347,15 +299,48 @@ static w4_float operator-(w4_float a) { return _mm_xor_ps(a, reinterpret(w4_int(
 
 
 
-static float add_elements(w4_float a) { __m128 aa = _mm_hadd_ps(a, a); aa = _mm_hadd_ps(aa, aa); return aa.m128_f32[0]; }
+// (a0 + a1) + (a2 + a3), like two horizontal adds, but SSE2 only.
+static float add_elements(w4_float a)
+{
+	__m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(a, swapped);
+	return _mm_cvtss_f32(_mm_add_ss(sums, _mm_movehl_ps(swapped, sums)));
+}
 
+#if defined(SIMD_FMA)
 static w4_float fmadd(w4_float a, w4_float b, w4_float c) { return _mm_fmadd_ps(a, b, c); }
 static w4_float fmsub(w4_float a, w4_float b, w4_float c) { return _mm_fmsub_ps(a, b, c); }
+#else
+static w4_float fmadd(w4_float a, w4_float b, w4_float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static w4_float fmsub(w4_float a, w4_float b, w4_float c) { return _mm_sub_ps(_mm_mul_ps(a, b), c); }
+#endif
+
+// Returns a unchanged, but hides it from the optimizer, so that fast math can't reassociate the arithmetic on both
+// sides, e.g. fold (x - j * c1) - j * c2 into x - j * (c1 + c2). MSVC doesn't reassociate across intrinsics.
+static w4_float optimization_barrier(w4_float a)
+{
+#if defined(__GNUC__)
+	__m128 f = a;
+	__asm__("" : "+x"(f));
+	return f;
+#else
+	return a;
+#endif
+}
 
 static w4_float sqrt(w4_float a) { return _mm_sqrt_ps(a); }
 static w4_float rsqrt(w4_float a) { return _mm_rsqrt_ps(a); }
 
+#if defined(SIMD_SSE_4_1)
 static w4_float if_then(w4_float cond, w4_float ifCase, w4_float elseCase) { return _mm_blendv_ps(elseCase, ifCase, cond); }
+#else
+static w4_float if_then(w4_float cond, w4_float ifCase, w4_float elseCase)
+{
+	// Like blendv, only the sign bit of the condition counts.
+	__m128 mask = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(cond), 31));
+	return _mm_or_ps(_mm_and_ps(mask, ifCase), _mm_andnot_ps(mask, elseCase));
+}
+#endif
 static w4_int if_then(w4_int cond, w4_int ifCase, w4_int elseCase) { return reinterpret(if_then(reinterpret(cond), reinterpret(ifCase), reinterpret(elseCase))); }
 
 static i32 to_bit_mask(w4_float a) { return _mm_movemask_ps(a); }
@@ -371,9 +356,99 @@ static bool all_false(w4_int a) { return all_false(reinterpret(a)); }
 static bool any_true(w4_int a) { return any_true(reinterpret(a)); }
 static bool any_false(w4_int a) { return any_false(reinterpret(a)); }
 
+static u32 count_set_bits(u32 bits)
+{
+	bits = bits - ((bits >> 1) & 0x55555555);
+	bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+	return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// Lookup tables for compress_store without AVX-512. For each mask of up to 8 lanes, lane_indices packs the source
+// lane of every output lane into 3 bits each, and byte_shuffles holds the same for 4 lanes as bytes for pshufb.
+struct CompressTables
+{
+	u32 lane_indices[256];
+	u8 byte_shuffles[16][16];
+
+	constexpr CompressTables() : lane_indices(), byte_shuffles()
+	{
+		for (u32 mask = 0; mask < 256; ++mask)
+		{
+			u32 count = 0;
+			for (u32 l = 0; l < 8; ++l)
+			{
+				if (mask & (1 << l))
+				{
+					lane_indices[mask] |= l << (3 * count);
+					if (mask < 16)
+					{
+						for (u32 b = 0; b < 4; ++b)
+						{
+							byte_shuffles[mask][4 * count + b] = (u8)(4 * l + b);
+						}
+					}
+					++count;
+				}
+			}
+		}
+	}
+};
+
+static constexpr CompressTables compress_tables;
+
+// Stores the lanes of value whose bit in bit_mask is set (see to_bit_mask) next to each other at dst, in lane order,
+// and returns their count. This is the building block of stream compaction: dst += compress_store(dst, ...). The
+// lanes after the count may be overwritten with garbage, so dst needs room for a full register.
+// The compress_store case of the Benchmarks project compares it with scalar loops.
+static u32 compress_store(float* dst, w4_float value, i32 bit_mask)
+{
+#if defined(SIMD_AVX_512)
+	_mm_storeu_ps(dst, _mm_maskz_compress_ps((__mmask8)bit_mask, value));
+#elif defined(SIMD_AVX_2)
+	__m128i indices = _mm_srlv_epi32(_mm_set1_epi32(compress_tables.lane_indices[bit_mask & 15]), _mm_setr_epi32(0, 3, 6, 9));
+	_mm_storeu_ps(dst, _mm_permutevar_ps(value, indices));
+#elif defined(SIMD_SSE_4_1)
+	__m128i shuffle = _mm_load_si128((const __m128i*)compress_tables.byte_shuffles[bit_mask & 15]);
+	_mm_storeu_ps(dst, _mm_castsi128_ps(_mm_shuffle_epi8(_mm_castps_si128(value), shuffle)));
+#else
+	// Branchless: every lane is written, but only advances the output if it is set.
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, value);
+	u32 count = 0;
+	for (u32 l = 0; l < 4; ++l)
+	{
+		dst[count] = lanes[l];
+		count += (bit_mask >> l) & 1;
+	}
+	return count;
+#endif
+	return count_set_bits(bit_mask & 15);
+}
+
+static u32 compress_store(i32* dst, w4_int value, i32 bit_mask) { return compress_store((float*)dst, reinterpret(value), bit_mask); }
+
 static w4_float abs(w4_float a) { w4_float result = and_not(-0.f, a); return result; }
+#if defined(SIMD_SSE_4_1)
 static w4_float floor(w4_float a) { return _mm_floor_ps(a); }
 static w4_float round(w4_float a) { return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+#else
+// Floats of magnitude 2^23 and above are integers already, and would overflow the conversion to int.
+static w4_float floor(w4_float a)
+{
+	// floor never changes the sign, so copying it back only matters for -0, which the conversion makes +0.
+	w4_float truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+	w4_float result = (truncated - (w4_float(1.f) & (truncated > a))) | (a & -0.f);
+	return if_then(abs(a) < 8388608.f, result, a);
+}
+
+static w4_float round(w4_float a)
+{
+	// The conversion rounds to nearest even in the default rounding mode. Adding and subtracting 2^23 would do the
+	// same, but fast math folds that away. The sign is copied back so that e.g. -0.25 rounds to -0.
+	w4_float result = _mm_cvtepi32_ps(_mm_cvtps_epi32(a)) | (a & -0.f);
+	return if_then(abs(a) < 8388608.f, result, a);
+}
+#endif
 static w4_float minimum(w4_float a, w4_float b) { return _mm_min_ps(a, b); }
 static w4_float maximum(w4_float a, w4_float b) { return _mm_max_ps(a, b); }
 
@@ -386,16 +461,6 @@ static w4_float clamp01(w4_float v) { return clamp(v, 0.f, 1.f); }
 static w4_float sign_of(w4_float f) { w4_float z = w4_float::zero(); return if_then(f < z, w4_float(-1), if_then(f == z, z, w4_float(1))); }
 static w4_float signbit(w4_float f) { return (f & -0.f) >> 31; }
 
-static w4_float cos(w4_float x) { return cos_internal(x); }
-static w4_float sin(w4_float x) { return sin_internal(x); }
-static w4_float exp2(w4_float x) { return exp2_internal<w4_float, w4_int>(x); }
-static w4_float log2(w4_float x) { return log2_internal<w4_float, w4_int>(x); }
-static w4_float pow(w4_float x, w4_float y) { return pow_internal<w4_float, w4_int>(x, y); }
-static w4_float exp(w4_float x) { return exp_internal<w4_float, w4_int>(x); }
-static w4_float tanh(w4_float x) { return tanh_internal(x); }
-static w4_float atan(w4_float x) { return atan_internal<w4_float, w4_int>(x); }
-static w4_float atan2(w4_float y, w4_float x) { return atan2_internal<w4_float, w4_int>(y, x); }
-static w4_float acos(w4_float x) { return acos_internal(x); }
 
 static w4_int fill_with_first_lane(w4_int a)
 {
@@ -485,7 +550,7 @@ struct w8_float
 {
 	__m256 f;
 
-	w8_float() {}
+	w8_float() = default;
 	w8_float(float f_) { f = _mm256_set1_ps(f_); }
 	w8_float(__m256 f_) { f = f_; }
 	w8_float(float a, float b, float c, float d, float e, float f, float g, float h) { this->f = _mm256_setr_ps(a, b, c, d, e, f, g, h); }
@@ -495,7 +560,7 @@ struct w8_float
 	w8_float(const float* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h) : w8_float(base_address, _mm256_setr_epi32(a, b, c, d, e, f, g, h)) {}
 
 	operator __m256() { return f; }
-	float operator[](u32 i) const { return this->f.m256_f32[i]; }
+	float operator[](u32 i) const { alignas(32) float lanes[8]; _mm256_store_ps(lanes, f); return lanes[i]; }
 
 	void store(float* f_) const { _mm256_storeu_ps(f_, f); }
 
@@ -505,30 +570,28 @@ struct w8_float
 #else
 	void scatter(float* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h) const
 	{
-		base_address[a] = this->f.m256_f32[0];
-		base_address[b] = this->f.m256_f32[1];
-		base_address[c] = this->f.m256_f32[2];
-		base_address[d] = this->f.m256_f32[3];
-		base_address[e] = this->f.m256_f32[4];
-		base_address[f] = this->f.m256_f32[5];
-		base_address[g] = this->f.m256_f32[6];
-		base_address[h] = this->f.m256_f32[7];
+		alignas(32) float lanes[8];
+		_mm256_store_ps(lanes, this->f);
+
+		base_address[a] = lanes[0];
+		base_address[b] = lanes[1];
+		base_address[c] = lanes[2];
+		base_address[d] = lanes[3];
+		base_address[e] = lanes[4];
+		base_address[f] = lanes[5];
+		base_address[g] = lanes[6];
+		base_address[h] = lanes[7];
 	}
 
 	void scatter(float* base_address, __m256i indices) const
 	{
-		base_address[indices.m256i_i32[0]] = this->f.m256_f32[0];
-		base_address[indices.m256i_i32[1]] = this->f.m256_f32[1];
-		base_address[indices.m256i_i32[2]] = this->f.m256_f32[2];
-		base_address[indices.m256i_i32[3]] = this->f.m256_f32[3];
-		base_address[indices.m256i_i32[4]] = this->f.m256_f32[4];
-		base_address[indices.m256i_i32[5]] = this->f.m256_f32[5];
-		base_address[indices.m256i_i32[6]] = this->f.m256_f32[6];
-		base_address[indices.m256i_i32[7]] = this->f.m256_f32[7];
+		alignas(32) i32 i[8];
+		_mm256_store_si256((__m256i*)i, indices);
+		scatter(base_address, i[0], i[1], i[2], i[3], i[4], i[5], i[6], i[7]);
 	}
 #endif
 
-	static w8_float all_ones() { const float nnan = (const float&)0xFFFFFFFF; return nnan; }
+	static w8_float all_ones() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
 	static w8_float zero() { return _mm256_setzero_ps(); }
 };
 
@@ -536,19 +599,19 @@ struct w8_int
 {
 	__m256i i;
 
-	w8_int() {}
+	w8_int() = default;
 	w8_int(i32 i_) { i = _mm256_set1_epi32(i_); }
 	w8_int(__m256i i_) { i = i_; }
 	w8_int(i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h) { this->i = _mm256_setr_epi32(a, b, c, d, e, f, g, h); }
-	w8_int(const i32* i_) { i = _mm256_loadu_epi32(i_); }
+	w8_int(const i32* i_) { i = _mm256_loadu_si256((const __m256i*)i_); }
 
 	w8_int(const i32* base_address, __m256i indices) { i = _mm256_i32gather_epi32(base_address, indices, 4); }
 	w8_int(const i32* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h) : w8_int(base_address, _mm256_setr_epi32(a, b, c, d, e, f, g, h)) {}
 
 	operator __m256i() { return i; }
-	i32 operator[](u32 i) const { return this->i.m256i_i32[i]; }
+	i32 operator[](u32 i) const { alignas(32) i32 lanes[8]; _mm256_store_si256((__m256i*)lanes, this->i); return lanes[i]; }
 
-	void store(i32* i_) const { _mm256_storeu_epi32(i_, i); }
+	void store(i32* i_) const { _mm256_storeu_si256((__m256i*)i_, i); }
 
 #if defined(SIMD_AVX_512)
 	void scatter(i32* base_address, __m256i indices) { _mm256_i32scatter_epi32(base_address, indices, i, 4); }
@@ -556,26 +619,24 @@ struct w8_int
 #else
 	void scatter(i32* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h) const
 	{
-		base_address[a] = this->i.m256i_i32[0];
-		base_address[b] = this->i.m256i_i32[1];
-		base_address[c] = this->i.m256i_i32[2];
-		base_address[d] = this->i.m256i_i32[3];
-		base_address[e] = this->i.m256i_i32[4];
-		base_address[f] = this->i.m256i_i32[5];
-		base_address[g] = this->i.m256i_i32[6];
-		base_address[h] = this->i.m256i_i32[7];
+		alignas(32) i32 lanes[8];
+		_mm256_store_si256((__m256i*)lanes, i);
+
+		base_address[a] = lanes[0];
+		base_address[b] = lanes[1];
+		base_address[c] = lanes[2];
+		base_address[d] = lanes[3];
+		base_address[e] = lanes[4];
+		base_address[f] = lanes[5];
+		base_address[g] = lanes[6];
+		base_address[h] = lanes[7];
 	}
 
 	void scatter(i32* base_address, __m256i indices) const
 	{
-		base_address[indices.m256i_i32[0]] = this->i.m256i_i32[0];
-		base_address[indices.m256i_i32[1]] = this->i.m256i_i32[1];
-		base_address[indices.m256i_i32[2]] = this->i.m256i_i32[2];
-		base_address[indices.m256i_i32[3]] = this->i.m256i_i32[3];
-		base_address[indices.m256i_i32[4]] = this->i.m256i_i32[4];
-		base_address[indices.m256i_i32[5]] = this->i.m256i_i32[5];
-		base_address[indices.m256i_i32[6]] = this->i.m256i_i32[6];
-		base_address[indices.m256i_i32[7]] = this->i.m256i_i32[7];
+		alignas(32) i32 lanes[8];
+		_mm256_store_si256((__m256i*)lanes, indices);
+		scatter(base_address, lanes[0], lanes[1], lanes[2], lanes[3], lanes[4], lanes[5], lanes[6], lanes[7]);
 	}
 #endif
 
@@ -596,9 +657,16 @@ static w8_int operator+(w8_int a, w8_int b) { return _mm256_add_epi32(a, b); }
 static w8_int& operator+=(w8_int& a, w8_int b) { a = a + b; return a; }
 static w8_int operator-(w8_int a, w8_int b) { return _mm256_sub_epi32(a, b); }
 static w8_int& operator-=(w8_int& a, w8_int b) { a = a - b; return a; }
-static w8_int operator*(w8_int a, w8_int b) { return _mm256_mul_epi32(a, b); }
+static w8_int operator*(w8_int a, w8_int b) { return _mm256_mullo_epi32(a, b); }
 static w8_int& operator*=(w8_int& a, w8_int b) { a = a * b; return a; }
-static w8_int operator/(w8_int a, w8_int b) { return _mm256_div_epi32(a, b); }
+
+// Exact via doubles, see w4_int.
+static w8_int operator/(w8_int a, w8_int b)
+{
+	__m256d low = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)), _mm256_cvtepi32_pd(_mm256_castsi256_si128(b)));
+	__m256d high = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(b, 1)));
+	return _mm256_set_m128i(_mm256_cvttpd_epi32(high), _mm256_cvttpd_epi32(low));
+}
 static w8_int& operator/=(w8_int& a, w8_int b) { a = a / b; return a; }
 static w8_int operator&(w8_int a, w8_int b) { return _mm256_and_si256(a, b); }
 static w8_int& operator&=(w8_int& a, w8_int b) { a = a & b; return a; }
@@ -644,12 +712,12 @@ static w8_float operator~(w8_float a) { a = and_not(a, w8_float::all_ones()); re
 
 
 #if defined(SIMD_AVX_512)
-static uint8 operator==(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_EQ); }
-static uint8 operator!=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_NE); }
-static uint8 operator>(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(b, a, _MM_CMPINT_LT); }
-static uint8 operator>=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(b, a, _MM_CMPINT_LE); }
-static uint8 operator<(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_LT); }
-static uint8 operator<=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_LE); }
+static u8 operator==(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_EQ); }
+static u8 operator!=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_NE); }
+static u8 operator>(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(b, a, _MM_CMPINT_LT); }
+static u8 operator>=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(b, a, _MM_CMPINT_LE); }
+static u8 operator<(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_LT); }
+static u8 operator<=(w8_int a, w8_int b) { return _mm256_cmp_epi32_mask(a, b, _MM_CMPINT_LE); }
 #else
 static w8_int operator==(w8_int a, w8_int b) { return _mm256_cmpeq_epi32(a, b); }
 static w8_int operator!=(w8_int a, w8_int b) { return ~(a == b); }
@@ -661,12 +729,12 @@ static w8_int operator<=(w8_int a, w8_int b) { return (a < b) | (a == b); }
 
 
 #if defined(SIMD_AVX_512)
-static uint8 operator==(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
-static uint8 operator!=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_NEQ_OQ); }
-static uint8 operator>(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_GT_OQ); }
-static uint8 operator>=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_GE_OQ); }
-static uint8 operator<(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_LT_OQ); }
-static uint8 operator<=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+static u8 operator==(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+static u8 operator!=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_NEQ_OQ); }
+static u8 operator>(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+static u8 operator>=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+static u8 operator<(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+static u8 operator<=(w8_float a, w8_float b) { return _mm256_cmp_ps_mask(a, b, _CMP_LE_OQ); }
 #else
 static w8_float operator==(w8_float a, w8_float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
 static w8_float operator!=(w8_float a, w8_float b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_OQ); }
@@ -686,10 +754,26 @@ static w8_float operator-(w8_float a) { return _mm256_xor_ps(a, reinterpret(w8_i
 
 
 
-static float add_elements(w8_float a) { __m256 aa = _mm256_hadd_ps(a, a); aa = _mm256_hadd_ps(aa, aa); return aa.m256_f32[0] + aa.m256_f32[4]; }
+static float add_elements(w8_float a) { __m256 aa = _mm256_hadd_ps(a, a); aa = _mm256_hadd_ps(aa, aa); return _mm_cvtss_f32(_mm_add_ss(_mm256_castps256_ps128(aa), _mm256_extractf128_ps(aa, 1))); }
 
+#if defined(SIMD_FMA)
 static w8_float fmadd(w8_float a, w8_float b, w8_float c) { return _mm256_fmadd_ps(a, b, c); }
 static w8_float fmsub(w8_float a, w8_float b, w8_float c) { return _mm256_fmsub_ps(a, b, c); }
+#else
+static w8_float fmadd(w8_float a, w8_float b, w8_float c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+static w8_float fmsub(w8_float a, w8_float b, w8_float c) { return _mm256_sub_ps(_mm256_mul_ps(a, b), c); }
+#endif
+
+static w8_float optimization_barrier(w8_float a)
+{
+#if defined(__GNUC__)
+	__m256 f = a;
+	__asm__("" : "+x"(f));
+	return f;
+#else
+	return a;
+#endif
+}
 
 static w8_float sqrt(w8_float a) { return _mm256_sqrt_ps(a); }
 static w8_float rsqrt(w8_float a) { return _mm256_rsqrt_ps(a); }
@@ -698,15 +782,15 @@ static i32 to_bit_mask(w8_float a) { return _mm256_movemask_ps(a); }
 static i32 to_bit_mask(w8_int a) { return to_bit_mask(reinterpret(a)); }
 
 #if defined(SIMD_AVX_512)
-static w8_float if_then(uint8 cond, w8_float ifCase, w8_float elseCase) { return _mm256_mask_blend_ps(cond, elseCase, ifCase); }
-static w8_int if_then(uint8 cond, w8_int ifCase, w8_int elseCase) { return reinterpret(if_then(cond, reinterpret(ifCase), reinterpret(elseCase))); }
+static w8_float if_then(u8 cond, w8_float ifCase, w8_float elseCase) { return _mm256_mask_blend_ps(cond, elseCase, ifCase); }
+static w8_int if_then(u8 cond, w8_int ifCase, w8_int elseCase) { return reinterpret(if_then(cond, reinterpret(ifCase), reinterpret(elseCase))); }
 
-static i32 to_bit_mask(uint8 a) { return a; }
+static i32 to_bit_mask(u8 a) { return a; }
 
-static bool all_true(uint8 a) { return a == (1 << 8) - 1; }
-static bool all_false(uint8 a) { return a == 0; }
-static bool any_true(uint8 a) { return a > 0; }
-static bool any_false(uint8 a) { return !all_true(a); }
+static bool all_true(u8 a) { return a == (1 << 8) - 1; }
+static bool all_false(u8 a) { return a == 0; }
+static bool any_true(u8 a) { return a > 0; }
+static bool any_false(u8 a) { return !all_true(a); }
 #else
 static w8_float if_then(w8_float cond, w8_float ifCase, w8_float elseCase) { return _mm256_blendv_ps(elseCase, ifCase, cond); }
 static w8_int if_then(w8_int cond, w8_int ifCase, w8_int elseCase) { return reinterpret(if_then(reinterpret(cond), reinterpret(ifCase), reinterpret(elseCase))); }
@@ -723,8 +807,23 @@ static bool any_false(w8_int a) { return any_false(reinterpret(a)); }
 #endif
 
 
+// See compress_store for w4_float.
+static u32 compress_store(float* dst, w8_float value, i32 bit_mask)
+{
+#if defined(SIMD_AVX_512)
+	_mm256_storeu_ps(dst, _mm256_maskz_compress_ps((__mmask8)bit_mask, value));
+#else
+	__m256i indices = _mm256_srlv_epi32(_mm256_set1_epi32(compress_tables.lane_indices[bit_mask & 255]), _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21));
+	_mm256_storeu_ps(dst, _mm256_permutevar8x32_ps(value, indices));
+#endif
+	return count_set_bits(bit_mask & 255);
+}
+
+static u32 compress_store(i32* dst, w8_int value, i32 bit_mask) { return compress_store((float*)dst, reinterpret(value), bit_mask); }
+
 static w8_float abs(w8_float a) { w8_float result = and_not(-0.f, a); return result; }
 static w8_float floor(w8_float a) { return _mm256_floor_ps(a); }
+static w8_float round(w8_float a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
 static w8_float minimum(w8_float a, w8_float b) { return _mm256_min_ps(a, b); }
 static w8_float maximum(w8_float a, w8_float b) { return _mm256_max_ps(a, b); }
 
@@ -737,16 +836,6 @@ static w8_float clamp01(w8_float v) { return clamp(v, 0.f, 1.f); }
 static w8_float sign_of(w8_float f) { w8_float z = w8_float::zero(); return if_then(f < z, w8_float(-1), if_then(f == z, z, w8_float(1))); }
 static w8_float signbit(w8_float f) { return (f & -0.f) >> 31; }
 
-static w8_float cos(w8_float x) { return cos_internal(x); }
-static w8_float sin(w8_float x) { return sin_internal(x); }
-static w8_float exp2(w8_float x) { return exp2_internal<w8_float, w8_int>(x); }
-static w8_float log2(w8_float x) { return log2_internal<w8_float, w8_int>(x); }
-static w8_float pow(w8_float x, w8_float y) { return pow_internal<w8_float, w8_int>(x, y); }
-static w8_float exp(w8_float x) { return exp_internal<w8_float, w8_int>(x); }
-static w8_float tanh(w8_float x) { return tanh_internal(x); }
-static w8_float atan(w8_float x) { return atan_internal<w8_float, w8_int>(x); }
-static w8_float atan2(w8_float y, w8_float x) { return atan2_internal<w8_float, w8_int>(y, x); }
-static w8_float acos(w8_float x) { return acos_internal(x); }
 
 static w8_float concat(w4_float a, w4_float b)
 {
@@ -919,7 +1008,7 @@ struct w16_float
 {
 	__m512 f;
 
-	w16_float() {}
+	w16_float() = default;
 	w16_float(float f_) { f = _mm512_set1_ps(f_); }
 	w16_float(__m512 f_) { f = f_; }
 	w16_float(float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float m, float n, float o, float p) { this->f = _mm512_setr_ps(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p); }
@@ -929,33 +1018,41 @@ struct w16_float
 	w16_float(const float* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h, i32 i, i32 j, i32 k, i32 l, i32 m, i32 n, i32 o, i32 p) : w16_float(base_address, _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)) {}
 
 	operator __m512() { return f; }
+	float operator[](u32 i) const { alignas(64) float lanes[16]; _mm512_store_ps(lanes, f); return lanes[i]; }
 
 	void store(float* f_) const { _mm512_storeu_ps(f_, f); }
 
 	void scatter(float* base_address, __m512i indices) const { _mm512_i32scatter_ps(base_address, indices, f, 4); }
 	void scatter(float* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h, i32 i, i32 j, i32 k, i32 l, i32 m, i32 n, i32 o, i32 p) const { scatter(base_address, _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)); }
+
+	static w16_float all_ones() { return _mm512_castsi512_ps(_mm512_set1_epi32(-1)); }
+	static w16_float zero() { return _mm512_setzero_ps(); }
 };
 
 struct w16_int
 {
 	__m512i i;
 
-	w16_int() {}
+	w16_int() = default;
 	w16_int(i32 i_) { i = _mm512_set1_epi32(i_); }
 	w16_int(__m512i i_) { i = i_; }
 	w16_int(i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h, i32 i, i32 j, i32 k, i32 l, i32 m, i32 n, i32 o, i32 p) { this->i = _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p); }
-	w16_int(const i32* i_) { i = _mm512_loadu_epi32(i_); }
+	w16_int(const i32* i_) { i = _mm512_loadu_si512(i_); }
 
 	w16_int(const i32* base_address, __m512i indices) { i = _mm512_i32gather_epi32(indices, base_address, 4); }
 	w16_int(const i32* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h, i32 i, i32 j, i32 k, i32 l, i32 m, i32 n, i32 o, i32 p) : w16_int(base_address, _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)) {}
 
 	operator __m512i() { return i; }
+	i32 operator[](u32 i) const { alignas(64) i32 lanes[16]; _mm512_store_si512(lanes, this->i); return lanes[i]; }
 
-	void store(i32* i_) const { _mm512_storeu_epi32(i_, i); }
-};
+	void store(i32* i_) const { _mm512_storeu_si512(i_, i); }
 
-static w16_float truex16() { const float nnan = (const float&)0xFFFFFFFF; return nnan; }
-static w16_float zerox16() { return _mm512_setzero_ps(); }
+	void scatter(i32* base_address, __m512i indices) const { _mm512_i32scatter_epi32(base_address, indices, i, 4); }
+	void scatter(i32* base_address, i32 a, i32 b, i32 c, i32 d, i32 e, i32 f, i32 g, i32 h, i32 i, i32 j, i32 k, i32 l, i32 m, i32 n, i32 o, i32 p) const { scatter(base_address, _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)); }
+
+	static w16_int all_ones() { return -1; }
+	static w16_int zero() { return _mm512_setzero_si512(); }
+};
 
 static w16_float convert(w16_int i) { return _mm512_cvtepi32_ps(i); }
 static w16_int convert(w16_float f) { return _mm512_cvtps_epi32(f); }
@@ -970,9 +1067,16 @@ static w16_int operator+(w16_int a, w16_int b) { return _mm512_add_epi32(a, b);
 static w16_int& operator+=(w16_int& a, w16_int b) { a = a + b; return a; }
 static w16_int operator-(w16_int a, w16_int b) { return _mm512_sub_epi32(a, b); }
 static w16_int& operator-=(w16_int& a, w16_int b) { a = a - b; return a; }
-static w16_int operator*(w16_int a, w16_int b) { return _mm512_mul_epi32(a, b); }
+static w16_int operator*(w16_int a, w16_int b) { return _mm512_mullo_epi32(a, b); }
 static w16_int& operator*=(w16_int& a, w16_int b) { a = a * b; return a; }
-static w16_int operator/(w16_int a, w16_int b) { return _mm512_div_epi32(a, b); }
+
+// Exact via doubles, see w4_int.
+static w16_int operator/(w16_int a, w16_int b)
+{
+	__m512d low = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(a)), _mm512_cvtepi32_pd(_mm512_castsi512_si256(b)));
+	__m512d high = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(a, 1)), _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(b, 1)));
+	return _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvttpd_epi32(low)), _mm512_cvttpd_epi32(high), 1);
+}
 static w16_int& operator/=(w16_int& a, w16_int b) { a = a / b; return a; }
 static w16_int operator&(w16_int a, w16_int b) { return _mm512_and_epi32(a, b); }
 static w16_int& operator&=(w16_int& a, w16_int b) { a = a & b; return a; }
@@ -981,7 +1085,7 @@ static w16_int& operator|=(w16_int& a, w16_int b) { a = a | b; return a; }
 static w16_int operator^(w16_int a, w16_int b) { return _mm512_xor_epi32(a, b); }
 static w16_int& operator^=(w16_int& a, w16_int b) { a = a ^ b; return a; }
 
-static w16_int operator~(w16_int a) { a = and_not(a, reinterpret(truex16())); return a; }
+static w16_int operator~(w16_int a) { a = and_not(a, w16_int::all_ones()); return a; }
 
 static u16 operator==(w16_int a, w16_int b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_EQ); }
 static u16 operator!=(w16_int a, w16_int b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_NE); }
@@ -992,16 +1096,20 @@ static u16 operator<=(w16_int a, w16_int b) { return _mm512_cmp_epi32_mask(a, b,
 
 
 static w16_int operator>>(w16_int a, i32 b) { return _mm512_srli_epi32(a, b); }
+static w16_int operator>>(w16_int a, w16_int b) { return _mm512_srlv_epi32(a, b); }
 static w16_int& operator>>=(w16_int& a, i32 b) { a = a >> b; return a; }
+static w16_int& operator>>=(w16_int& a, w16_int b) { a = a >> b; return a; }
 static w16_int operator<<(w16_int a, i32 b) { return _mm512_slli_epi32(a, b); }
+static w16_int operator<<(w16_int a, w16_int b) { return _mm512_sllv_epi32(a, b); }
 static w16_int& operator<<=(w16_int& a, i32 b) { a = a << b; return a; }
+static w16_int& operator<<=(w16_int& a, w16_int b) { a = a << b; return a; }
 
 static w16_int operator-(w16_int a) { return _mm512_sub_epi32(_mm512_setzero_si512(), a); }
 
 
 
-// Float operators.
-static w16_float and_not(w16_float a, w16_float b) { return _mm512_andnot_ps(a, b); }
+// Float operators. The float versions of the bitwise instructions need AVX-512DQ, the integer ones do the same.
+static w16_float and_not(w16_float a, w16_float b) { return reinterpret(and_not(reinterpret(a), reinterpret(b))); }
 
 static w16_float operator+(w16_float a, w16_float b) { return _mm512_add_ps(a, b); }
 static w16_float& operator+=(w16_float& a, w16_float b) { a = a + b; return a; }
@@ -1011,14 +1119,14 @@ static w16_float operator*(w16_float a, w16_float b) { return _mm512_mul_ps(a, b
 static w16_float& operator*=(w16_float& a, w16_float b) { a = a * b; return a; }
 static w16_float operator/(w16_float a, w16_float b) { return _mm512_div_ps(a, b); }
 static w16_float& operator/=(w16_float& a, w16_float b) { a = a / b; return a; }
-static w16_float operator&(w16_float a, w16_float b) { return _mm512_and_ps(a, b); }
+static w16_float operator&(w16_float a, w16_float b) { return reinterpret(reinterpret(a) & reinterpret(b)); }
 static w16_float& operator&=(w16_float& a, w16_float b) { a = a & b; return a; }
-static w16_float operator|(w16_float a, w16_float b) { return _mm512_or_ps(a, b); }
+static w16_float operator|(w16_float a, w16_float b) { return reinterpret(reinterpret(a) | reinterpret(b)); }
 static w16_float& operator|=(w16_float& a, w16_float b) { a = a | b; return a; }
-static w16_float operator^(w16_float a, w16_float b) { return _mm512_xor_ps(a, b); }
+static w16_float operator^(w16_float a, w16_float b) { return reinterpret(reinterpret(a) ^ reinterpret(b)); }
 static w16_float& operator^=(w16_float& a, w16_float b) { a = a ^ b; return a; }
 
-static w16_float operator~(w16_float a) { a = and_not(a, truex16()); return a; }
+static w16_float operator~(w16_float a) { a = and_not(a, w16_float::all_ones()); return a; }
 
 static u16 operator==(w16_float a, w16_float b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
 static u16 operator!=(w16_float a, w16_float b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_OQ); }
@@ -1033,7 +1141,7 @@ static w16_float& operator>>=(w16_float& a, i32 b) { a = a >> b; return a; }
 static w16_float operator<<(w16_float a, i32 b) { return reinterpret(reinterpret(a) << b); }
 static w16_float& operator<<=(w16_float& a, i32 b) { a = a << b; return a; }
 
-static w16_float operator-(w16_float a) { return _mm512_xor_ps(a, reinterpret(w16_int(1 << 31))); }
+static w16_float operator-(w16_float a) { return a ^ reinterpret(w16_int(1 << 31)); }
 
 
 
@@ -1043,20 +1151,44 @@ static float add_elements(w16_float a) { return _mm512_reduce_add_ps(a); }
 static w16_float fmadd(w16_float a, w16_float b, w16_float c) { return _mm512_fmadd_ps(a, b, c); }
 static w16_float fmsub(w16_float a, w16_float b, w16_float c) { return _mm512_fmsub_ps(a, b, c); }
 
+static w16_float optimization_barrier(w16_float a)
+{
+#if defined(__GNUC__)
+	__m512 f = a;
+	__asm__("" : "+v"(f));
+	return f;
+#else
+	return a;
+#endif
+}
+
 static w16_float sqrt(w16_float a) { return _mm512_sqrt_ps(a); }
 static w16_float rsqrt(w16_float a) { return 1.f / _mm512_sqrt_ps(a); }
 
 static w16_float if_then(u16 cond, w16_float ifCase, w16_float elseCase) { return _mm512_mask_blend_ps(cond, elseCase, ifCase); }
 static w16_int if_then(u16 cond, w16_int ifCase, w16_int elseCase) { return reinterpret(if_then(cond, reinterpret(ifCase), reinterpret(elseCase))); }
 
+static i32 to_bit_mask(u16 a) { return a; }
+
 static bool all_true(u16 a) { return a == (1 << 16) - 1; }
 static bool all_false(u16 a) { return a == 0; }
 static bool any_true(u16 a) { return a > 0; }
 static bool any_false(u16 a) { return !all_true(a); }
 
+// See compress_store for w4_float. Compressing in a register and storing all lanes is twice as fast as
+// vcompressps to memory.
+static u32 compress_store(float* dst, w16_float value, i32 bit_mask)
+{
+	_mm512_storeu_ps(dst, _mm512_maskz_compress_ps((__mmask16)bit_mask, value));
+	return count_set_bits(bit_mask & 65535);
+}
+
+static u32 compress_store(i32* dst, w16_int value, i32 bit_mask) { return compress_store((float*)dst, reinterpret(value), bit_mask); }
+
 
 static w16_float abs(w16_float a) { w16_float result = and_not(-0.f, a); return result; }
-static w16_float floor(w16_float a) { return _mm512_floor_ps(a); }
+static w16_float floor(w16_float a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+static w16_float round(w16_float a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
 static w16_float minimum(w16_float a, w16_float b) { return _mm512_min_ps(a, b); }
 static w16_float maximum(w16_float a, w16_float b) { return _mm512_max_ps(a, b); }
 
@@ -1066,19 +1198,16 @@ static w16_float remap(w16_float v, w16_float oldL, w16_float oldU, w16_float ne
 static w16_float clamp(w16_float v, w16_float l, w16_float u) { return minimum(u, maximum(l, v)); }
 static w16_float clamp01(w16_float v) { return clamp(v, 0.f, 1.f); }
 
-static w16_float sign_of(w16_float f) { return if_then(f < 0.f, w16_float(-1), if_then(f == 0.f, zerox16(), w16_float(1))); }
+static w16_float sign_of(w16_float f) { w16_float z = w16_float::zero(); return if_then(f < z, w16_float(-1), if_then(f == z, z, w16_float(1))); }
 static w16_float signbit(w16_float f) { return (f & -0.f) >> 31; }
 
-static w16_float cos(w16_float x) { return cos_internal(x); }
-static w16_float sin(w16_float x) { return sin_internal(x); }
-static w16_float exp2(w16_float x) { return exp2_internal<w16_float, w16_int>(x); }
-static w16_float log2(w16_float x) { return log2_internal<w16_float, w16_int>(x); }
-static w16_float pow(w16_float x, w16_float y) { return pow_internal<w16_float, w16_int>(x, y); }
-static w16_float exp(w16_float x) { return exp_internal<w16_float, w16_int>(x); }
-static w16_float tanh(w16_float x) { return tanh_internal(x); }
-static w16_float atan(w16_float x) { return atan_internal<w16_float, w16_int>(x); }
-static w16_float atan2(w16_float y, w16_float x) { return atan2_internal<w16_float, w16_int>(y, x); }
-static w16_float acos(w16_float x) { return acos_internal(x); }
+static w16_int popcount(w16_int i)
+{
+	i = i - ((i >> 1) & 0x55555555);
+	i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
+	return (((i + (i >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
 
 
 #endif
@@ -1087,6 +1216,637 @@ static bool any_true(i32 mask) { return mask > 0; }
 static bool any_true(u32 mask) { return mask > 0; }
 
 
+// Approximations of transcendental functions, shared by all widths. They come after all types, so that the calls
+// to if_then with AVX-512 bit masks resolve.
+//
+// Every function comes in three precision tiers, selected per call site, e.g. cos<Precision::Accurate>(x). Fast,
+// the default, is the cheapest approximation. Balanced and Accurate reduce the argument properly and evaluate
+// minimax polynomials, Balanced with fewer terms and without special value handling. Accurate uses the
+// polynomials of the Cephes single precision library, and handles 0 and denormals like libm, unless noted
+// otherwise. No tier promises anything for infinity or NaN arguments: the project is compiled with fast math,
+// which lets the compiler assume that they don't occur (-ffinite-math-only on GCC and Clang).
+//
+// Errors below are against double precision libm. The bounds hold at every level and are checked by the SimdTests
+// project. The widths may differ in the last bit, depending on which multiplies and adds the compiler fuses. See
+// the simd_math case of the Benchmarks project for speeds.
+enum class Precision
+{
+	Fast,
+	Balanced,
+	Accurate,
+};
+
+#define POLY0(x, c0) (c0)
+#define POLY1(x, c0, c1) fmadd(POLY0(x, c1), x, (c0))
+#define POLY2(x, c0, c1, c2) fmadd(POLY1(x, c1, c2), x, (c0))
+#define POLY3(x, c0, c1, c2, c3) fmadd(POLY2(x, c1, c2, c3), x, (c0))
+#define POLY4(x, c0, c1, c2, c3, c4) fmadd(POLY3(x, c1, c2, c3, c4), x, (c0))
+#define POLY5(x, c0, c1, c2, c3, c4, c5) fmadd(POLY4(x, c1, c2, c3, c4, c5), x, (c0))
+#define POLY6(x, c0, c1, c2, c3, c4, c5, c6) fmadd(POLY5(x, c1, c2, c3, c4, c5, c6), x, (c0))
+#define POLY7(x, c0, c1, c2, c3, c4, c5, c6, c7) fmadd(POLY6(x, c1, c2, c3, c4, c5, c6, c7), x, (c0))
+#define POLY8(x, c0, c1, c2, c3, c4, c5, c6, c7, c8) fmadd(POLY7(x, c1, c2, c3, c4, c5, c6, c7, c8), x, (c0))
+
+// Magnitude of a (which must not be negative) with the sign of b.
+template <typename float_t>
+static float_t with_sign_of(float_t a, float_t b)
+{
+	return a | (b & -0.f);
+}
+
+// Mask of the lanes whose sign bit is set, including -0.
+template <typename float_t>
+static auto is_sign_bit_set(float_t a)
+{
+	return (with_sign_of(float_t(1.f), a) < 0.f);
+}
+
+// value * 2^n for integral n in [-190, 128]. Results below 2^-126 are denormals, 2^128 and above are infinity.
+template <typename float_t, typename int_t>
+static float_t scale_by_power_of_two(float_t value, float_t n)
+{
+	// 2^n itself is only representable in [-126, 127], so scale in two steps outside.
+	auto tiny = n < -63.f;
+	auto huge = n > 127.f;
+	float_t bias = if_then(tiny, float_t(64.f), if_then(huge, float_t(-1.f), float_t(0.f)));
+	float_t correction = if_then(tiny, float_t(5.42101086e-20f), if_then(huge, float_t(2.f), float_t(1.f))); // 2^-bias.
+	float_t scale = reinterpret((convert(n + bias) + 127) << 23);
+	return optimization_barrier(value * scale) * correction; // scale * correction may overflow.
+}
+
+// Evaluates sin (quadrant_offset = 0) or cos (quadrant_offset = 1) after reducing x to r in [-pi/4, pi/4], with
+// x = r + j * pi/2.
+template <Precision precision, typename float_t, typename int_t>
+static float_t sin_cos_reduced(float_t x, i32 quadrant_offset)
+{
+	float_t j = round(x * 0.636619772f); // 2/pi.
+
+	// Cody-Waite reduction: pi/2 is split into parts whose products with j are exact.
+	float_t r = optimization_barrier(fmadd(j, -1.5703125f, x));
+	if constexpr (precision == Precision::Accurate)
+	{
+		r = optimization_barrier(fmadd(j, -4.837512969970703125e-4f, r));
+		r = fmadd(j, -7.54978995489188216e-8f, r);
+	}
+	else
+	{
+		r = fmadd(j, -4.83826794897e-4f, r);
+	}
+
+	float_t z = r * r;
+	float_t sin_r, cos_r;
+	if constexpr (precision == Precision::Accurate)
+	{
+		sin_r = fmadd(r * z, POLY2(z, -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f), r);
+		cos_r = fmadd(z * z, POLY2(z, 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f), fmadd(z, -0.5f, 1.f));
+	}
+	else
+	{
+		sin_r = r * POLY2(z, 9.999949932e-1f, -1.666016132e-1f, 8.121557534e-3f);
+		cos_r = POLY3(z, 1.f, -4.999985695e-1f, 4.165502638e-2f, -1.358590904e-3f);
+	}
+
+	// Odd quadrants swap sine and cosine, quadrants 2 and 3 negate.
+	int_t quadrant = convert(j) + quadrant_offset;
+	float_t result = if_then(convert(quadrant & 1) > 0.f, cos_r, sin_r);
+	return result ^ reinterpret((quadrant & 2) << 30);
+}
+
+// Fast: parabola with one correction term. Max absolute error 1.2e-3, mean 5.1e-4, for any |x| < 1000. Exactly 1,
+// 0 and -1 at multiples of pi/2. Precision of the argument decreases for larger |x|, e.g. the error is 1.2e-2 at
+// 1e6.
+// Balanced: quadrant reduction with pi/2 in two parts, degree 5 and 6 polynomials. Max absolute error 6.5e-7 for
+// |x| < 1e5, 8.6e-6 at 1e6.
+// Accurate: pi/2 in three parts. Max error 1.6 ulp on [-pi, pi], absolute 9.3e-8 for |x| < 1e6, 9.6e-5 at 1e7.
+// In all tiers the result is garbage above about 1e8.
+template <Precision precision, typename float_t, typename int_t>
+static float_t cos_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		const float_t tp = 1.f / (2.f * 3.14159265359f);
+		const float_t q = 0.25f;
+		const float_t h = 0.5f;
+		const float_t o = 1.f;
+		const float_t s = 16.f;
+		const float_t v = 0.225f;
+
+		x *= tp;
+		x -= q + floor(x + q);
+		x *= s * (abs(x) - h);
+		x += v * x * (abs(x) - o);
+		return x;
+	}
+	else
+	{
+		return sin_cos_reduced<precision, float_t, int_t>(x, 1);
+	}
+}
+
+// Same errors as cos_internal, except that sin(-0) is +0.
+template <Precision precision, typename float_t, typename int_t>
+static float_t sin_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		return cos_internal<precision, float_t, int_t>(x - (3.14159265359f * 0.5f));
+	}
+	else
+	{
+		return sin_cos_reduced<precision, float_t, int_t>(x, 0);
+	}
+}
+
+// Fast: cubic on the fraction. Max relative error 7.5e-5 (1250 ulp), mean 570 ulp, on [-126, 128). Results below
+// 2^-126 flush to 0, 2^128 and above give infinity.
+// Balanced: quartic on [-0.5, 0.5]. Max relative error 2.8e-6 (40 ulp), mean 20 ulp, on [-126, 128).
+// Accurate: degree 6. Max error 0.93 ulp with FMA, 1.2 ulp without, mean 0.26 ulp, also for denormal results.
+template <Precision precision, typename float_t, typename int_t>
+static float_t exp2_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		x = minimum(x, 129.00000f);
+		x = maximum(x, -126.99999f);
+
+		int_t ipart = convert(x - 0.5f);
+		float_t fpart = x - convert(ipart);
+		float_t expipart = reinterpret((ipart + 127) << 23);
+		float_t expfpart = POLY3(fpart, 9.9992520e-1f, 6.9583356e-1f, 2.2606716e-1f, 7.8024521e-2f);
+		return expipart * expfpart;
+	}
+	else if constexpr (precision == Precision::Balanced)
+	{
+		x = maximum(minimum(x, 128.f), -150.f);
+
+		float_t n = round(x);
+		float_t f = x - n;
+		float_t p = POLY4(f, 9.999992847e-1f, 6.931217909e-1f, 2.402474433e-1f, 5.591785908e-2f, 9.570101276e-3f);
+		return scale_by_power_of_two<float_t, int_t>(p, n);
+	}
+	else
+	{
+		x = maximum(minimum(x, 128.f), -160.f);
+
+		float_t n = round(x);
+		float_t f = x - n;
+		float_t p = POLY6(f, 1.f, 6.931472028550421e-1f, 2.402264791363012e-1f, 5.550332471162809e-2f, 9.618437357674640e-3f, 1.339887440266574e-3f, 1.535336188319500e-4f);
+		return scale_by_power_of_two<float_t, int_t>(p, n);
+	}
+}
+
+// Fast: quartic on the mantissa. Max absolute error 6.1e-5, mean 1.8e-5, for all positive normal floats. Denormals
+// and 0 give about -127, negative numbers the log2 of their magnitude.
+// Balanced: degree 7 on [sqrt(1/2), sqrt(2)]. Max absolute error 6.2e-7 around 1, relative 1.3e-6 (20 ulp)
+// elsewhere, for positive normal floats.
+// Accurate: max error 1.9 ulp for all positive floats, including denormals.
+template <Precision precision, typename float_t, typename int_t>
+static float_t log2_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		int_t exp = 0x7F800000;
+		int_t mant = 0x007FFFFF;
+
+		float_t one = 1;
+		int_t i = reinterpret(x);
+
+		float_t e = convert(((i & exp) >> 23) - 127);
+		float_t m = reinterpret(i & mant) | one;
+		float_t p = POLY4(m, 2.8882704548164776201f, -2.52074962577807006663f, 1.48116647521213171641f, -0.465725644288844778798f, 0.0596515482674574969533f);
+
+		return fmadd(p, m - one, e);
+	}
+	else
+	{
+		float_t scaled_x = x;
+		float_t e_offset = -127.f;
+		if constexpr (precision == Precision::Accurate)
+		{
+			// Scale denormals into the normal range.
+			auto denormal = x < 1.17549435e-38f;
+			scaled_x = if_then(denormal, x * 8388608.f, x);
+			e_offset = if_then(denormal, float_t(-150.f), float_t(-127.f));
+		}
+
+		// x = 2^e * m, with m in [sqrt(1/2), sqrt(2)).
+		int_t i = reinterpret(scaled_x);
+		float_t e = convert((i >> 23) & 0xFF) + e_offset;
+		float_t m = reinterpret((i & 0x007FFFFF) | 0x3F800000);
+
+		auto above_sqrt2 = m > 1.41421356f;
+		m = if_then(above_sqrt2, m * 0.5f, m);
+		e = if_then(above_sqrt2, e + 1.f, e);
+
+		float_t f = m - 1.f;
+
+		if constexpr (precision == Precision::Balanced)
+		{
+			return fmadd(f, POLY6(f, 1.442696452e+0f, -7.213636041e-1f, 4.806267619e-1f, -3.593716621e-1f, 2.956995368e-1f, -2.693201900e-1f, 1.716244668e-1f), e);
+		}
+		else
+		{
+			// ln(1 + f), then converted to log2.
+			float_t z = f * f;
+			float_t y = f * z * POLY8(f, 3.3333331174e-1f, -2.4999993993e-1f, 2.0000714765e-1f, -1.6668057665e-1f, 1.4249322787e-1f, -1.2420140846e-1f, 1.1676998740e-1f, -1.1514610310e-1f, 7.0376836292e-2f);
+			float_t ln = f + fmadd(z, -0.5f, y);
+			float_t result = fmadd(ln, 1.44269504f, e);
+
+			result = if_then(x == 0.f, float_t(-INFINITY), result);
+			return if_then(x >= 0.f, result, float_t(NAN));
+		}
+	}
+}
+
+// exp2(log2(x) * y), so the relative error grows with |log2(x) * y|.
+// Fast: max relative error 2.3e-4 for x in [0.01, 100] and y in [-4, 4]. The sign of x is ignored.
+// Balanced: max relative error 5.3e-6 (78 ulp) on the same range.
+// Accurate: max relative error 1.5e-6 (24 ulp), mean 1.7 ulp.
+template <Precision precision, typename float_t, typename int_t>
+static float_t pow_internal(float_t x, float_t y)
+{
+	return exp2_internal<precision, float_t, int_t>(log2_internal<precision, float_t, int_t>(x) * y);
+}
+
+// Fast: writes the scaled argument directly into the exponent bits (Schraudolph). Max relative error 3.6%. The
+// argument is clamped to [-87, 88].
+// Balanced: exp2 of x * log2(e), with the Balanced exp2. Max relative error 6.4e-6 (96 ulp) on [-87, 88].
+// Accurate: reduction by ln(2) in two parts. Max error 1.1 ulp with FMA, 1.3 ulp without, mean 0.27 ulp, down to
+// denormal results at -103.
+template <Precision precision, typename float_t, typename int_t>
+static float_t exp_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		// Outside of this range the exponent would wrap around.
+		x = maximum(minimum(x, 88.f), -87.f);
+
+		float_t a = 12102203.f; // (1 << 23) / log(2).
+		int_t b = 127 * (1 << 23) - 298765;
+		int_t t = convert(a * x) + b;
+		return reinterpret(t);
+	}
+	else if constexpr (precision == Precision::Balanced)
+	{
+		return exp2_internal<precision, float_t, int_t>(x * 1.44269504f);
+	}
+	else
+	{
+		x = maximum(float_t(-104.f), minimum(float_t(89.f), x));
+
+		// Cody-Waite reduction to r in [-ln(2)/2, ln(2)/2], x = r + n * ln(2).
+		float_t n = round(x * 1.44269504f);
+		float_t r = optimization_barrier(fmadd(n, -0.693359375f, x));
+		r = fmadd(n, 2.12194440e-4f, r);
+
+		float_t p = POLY5(r, 5.0000001201e-1f, 1.6666665459e-1f, 4.1665795894e-2f, 8.3334519073e-3f, 1.3981999507e-3f, 1.9875691500e-4f);
+		float_t exp_r = fmadd(r * r, p, r) + 1.f;
+		return scale_by_power_of_two<float_t, int_t>(exp_r, n);
+	}
+}
+
+// Fast: built on the Fast exp. Max absolute error 6.6e-3, mean 1.6e-4.
+// Balanced and Accurate: odd polynomial for |x| < 0.625, 1 - 2 / (exp(2|x|) + 1) with the exp of the same tier
+// above. Balanced: max absolute error 1.1e-6, relative 1.9e-6 (17 ulp). Accurate: max error 2.0 ulp. Both are
+// exactly +-1 for large |x|, tanh(-0) is +0.
+template <Precision precision, typename float_t, typename int_t>
+static float_t tanh_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		float_t a = exp_internal<precision, float_t, int_t>(x);
+		float_t b = exp_internal<precision, float_t, int_t>(-x);
+		return (a - b) / (a + b);
+	}
+	else
+	{
+		float_t z = x * x;
+		float_t small = fmadd(x * z, POLY4(z, -3.33332819422e-1f, 1.33314422036e-1f, -5.37397155531e-2f, 2.06390887954e-2f, -5.70498872745e-3f), x);
+
+		float_t ax = abs(x);
+		float_t e = exp_internal<precision, float_t, int_t>(ax + ax);
+		float_t large = with_sign_of(1.f - 2.f / (e + 1.f), x);
+
+		return if_then(ax < 0.625f, small, large);
+	}
+}
+
+// atan on [0, 1], for the Balanced and Accurate tiers.
+template <Precision precision, typename float_t>
+static float_t atan_01(float_t t)
+{
+	if constexpr (precision == Precision::Balanced)
+	{
+		float_t z = t * t;
+		return t * POLY5(z, 9.999772310e-1f, -3.326228261e-1f, 1.935403645e-1f, -1.164264679e-1f, 5.264733359e-2f, -1.171912998e-2f);
+	}
+	else
+	{
+		// atan(t) = pi/4 + atan((t - 1) / (t + 1)) above tan(pi/8).
+		auto reduce = t > 0.414213562f;
+		float_t u = if_then(reduce, (t - 1.f) / (t + 1.f), t);
+		float_t base = if_then(reduce, float_t(0.785398163f), float_t(0.f));
+
+		float_t z = u * u;
+		return base + fmadd(u * z, POLY3(z, -3.33329491539e-1f, 1.99777106478e-1f, -1.38776856032e-1f, 8.05374449538e-2f), u);
+	}
+}
+
+// Fast: rational approximation. Max absolute error 2.9e-3 (0.17 degrees), mean 1.8e-3, on the whole real line.
+// Balanced: degree 11 odd polynomial on [0, 1]. Max absolute error 1.9e-6, relative 2.3e-5 near 0.
+// Accurate: reduction by pi/4 above tan(pi/8). Max error 4.1 ulp.
+template <Precision precision, typename float_t, typename int_t>
+static float_t atan_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		const int_t sign_mask = 0x80000000;
+		const float_t b = 0.596227f;
+
+		// Extract the sign bit.
+		int_t ux_s = sign_mask & reinterpret(x);
+
+		// Calculate the arctangent in the first quadrant.
+		float_t bx_a = abs(b * x);
+		float_t num = fmadd(x, x, bx_a);
+		float_t atan_1q = num / (1.f + bx_a + num);
+
+		// Restore the sign bit.
+		int_t atan_2q = ux_s | reinterpret(atan_1q);
+		return reinterpret(atan_2q) * float_t(3.14159265359f * 0.5f);
+	}
+	else
+	{
+		// atan(x) = pi/2 - atan(1/x) above 1.
+		float_t ax = abs(x);
+		auto above_one = ax > 1.f;
+		float_t a = atan_01<precision>(if_then(above_one, 1.f / ax, ax));
+		a = if_then(above_one, 1.57079633f - a, a);
+		return with_sign_of(a, x);
+	}
+}
+
+// Fast: same error as the Fast atan, for all angles and radii from 1e-3 to 1e3. atan2(0, 0) is undefined, and
+// atan2(+0, x < 0) is -pi instead of pi.
+// Balanced: max absolute error 2.0e-6. Zeros of either sign are handled like in libm.
+// Accurate: max error 4.7 ulp. Zeros of either sign are handled like in libm.
+template <Precision precision, typename float_t, typename int_t>
+static float_t atan2_internal(float_t y, float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		const int_t sign_mask = 0x80000000;
+		const float_t b = 0.596227f;
+
+		// Extract the sign bits.
+		int_t ux_s = sign_mask & reinterpret(x);
+		int_t uy_s = sign_mask & reinterpret(y);
+
+		// Determine the quadrant offset.
+		float_t q = convert(((~ux_s & uy_s) >> 29) | (ux_s >> 30));
+
+		// Calculate the arctangent in the first quadrant.
+		float_t bxy_a = abs(b * x * y);
+		float_t num = fmadd(y, y, bxy_a);
+		float_t atan_1q = num / (fmadd(x, x, bxy_a + num));
+
+		// Translate it to the proper quadrant.
+		int_t uatan_2q = (ux_s ^ uy_s) | reinterpret(atan_1q);
+
+		float_t result04 = q + reinterpret(uatan_2q); // In the [0, 4) range for the 4 quadrants.
+
+		auto negQuadrant = result04 >= 2.f;
+		float_t result = if_then(negQuadrant, result04 - 4.f, result04);
+		return result * float_t(3.14159265359f * 0.5f);
+	}
+	else
+	{
+		float_t ax = abs(x);
+		float_t ay = abs(y);
+
+		// atan of the smaller over the larger magnitude, then mirrored into the right octant.
+		float_t t;
+		if constexpr (precision == Precision::Balanced)
+		{
+			t = minimum(ax, ay) / maximum(maximum(ax, ay), 1.17549435e-38f);
+		}
+		else
+		{
+			// Unlike above, denormals keep their full precision.
+			t = minimum(ax, ay) / maximum(ax, ay);
+			t = if_then(maximum(ax, ay) == 0.f, float_t(0.f), t);
+		}
+
+		float_t a = atan_01<precision>(t);
+		a = if_then(ay > ax, 1.57079633f - a, a);
+		a = if_then(is_sign_bit_set(x), 3.14159265f - a, a);
+		return with_sign_of(a, y);
+	}
+}
+
+// Fast: Abramowitz and Stegun 4.4.45 (https://developer.download.nvidia.com/cg/acos.html). Max absolute error
+// 6.9e-5, mean 2.8e-5, on [-1, 1]. Undefined outside.
+// Balanced: Abramowitz and Stegun 4.4.46. Max absolute error 4.4e-7, 2.9 ulp.
+// Accurate: via asin with the half angle formula. Max error 1.3 ulp.
+template <Precision precision, typename float_t, typename int_t>
+static float_t acos_internal(float_t x)
+{
+	if constexpr (precision == Precision::Fast)
+	{
+		float_t negate = if_then(x < 0.f, float_t(1.f), float_t(0.f));
+		x = abs(x);
+		float_t ret = -0.0187293f;
+		ret = fmadd(ret, x, 0.0742610f);
+		ret = fmadd(ret, x, -0.2121144f);
+		ret = fmadd(ret, x, 1.5707288f);
+		ret = ret * sqrt(1.f - x);
+		ret = ret - negate * ret * float_t(2.f);
+		return fmadd(negate, 3.14159265359f, ret);
+	}
+	else if constexpr (precision == Precision::Balanced)
+	{
+		float_t ax = abs(x);
+		float_t result = sqrt(1.f - ax) * POLY7(ax, 1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f, 0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f);
+		return if_then(x < 0.f, 3.14159265f - result, result);
+	}
+	else
+	{
+		// Via asin(s), with s = |x| below 0.5 and s = sqrt((1 - |x|) / 2) above, so that s <= 0.5.
+		float_t ax = abs(x);
+		auto above_half = ax > 0.5f;
+		float_t z = if_then(above_half, (1.f - ax) * 0.5f, ax * ax);
+		float_t s = if_then(above_half, sqrt(z), ax);
+		float_t asin_s = fmadd(s * z, POLY4(z, 1.6666752422e-1f, 7.4953002686e-2f, 4.5470025998e-2f, 2.4181311049e-2f, 4.2163199048e-2f), s);
+
+		float_t result = if_then(above_half, asin_s + asin_s, 1.57079633f - asin_s);
+		return if_then(x < 0.f, 3.14159265f - result, result);
+	}
+}
+
+
+// Conversion to IEEE half precision with round to nearest even, bit for bit like F16C. The half is returned in the low
+// 16 bits of each lane. Values below the smallest normal half round to subnormals, values from 65520 up become
+// infinity, and NaNs stay quiet NaNs with the top 10 bits of their payload.
+template <typename float_t, typename int_t>
+static int_t float_to_half_internal(float_t f)
+{
+	int_t bits = reinterpret(f);
+	int_t sign = (bits >> 16) & 0x8000;
+	int_t abs_bits = bits & 0x7FFFFFFF;
+
+	// Below 2^-14, adding 0.5 moves the 10 mantissa bits of the half to the bottom and rounds them with the FPU.
+	int_t subnormal = reinterpret(reinterpret(abs_bits) + 0.5f) - reinterpret(float_t(0.5f));
+
+	// Otherwise rebias the exponent and round the 13 dropped bits to nearest even. Rounding up may carry into the
+	// exponent, which gives infinity just above the largest half.
+	int_t normal = (abs_bits + (0xFFF - ((127 - 15) << 23)) + ((abs_bits >> 13) & 1)) >> 13;
+
+	int_t inf_nan = if_then(abs_bits > int_t(0x7F800000), ((abs_bits >> 13) & 0x3FF) | 0x7E00, int_t(0x7C00));
+
+	int_t result = if_then(abs_bits < int_t(113 << 23), subnormal, normal);
+	result = if_then(abs_bits >= int_t(143 << 23), inf_nan, result);
+	return result | sign;
+}
+
+// Inverse of float_to_half_internal, exact for all halves. Takes the half in the low 16 bits of each lane.
+template <typename float_t, typename int_t>
+static float_t half_to_float_internal(int_t half_bits)
+{
+	int_t shifted = (half_bits & 0x7FFF) << 13;
+	int_t exponent = shifted & (0x7C00 << 13);
+	int_t bits = shifted + ((127 - 15) << 23);
+
+	// Infinity and NaN get the maximum exponent, NaNs get quiet.
+	bits = if_then(exponent == int_t(0x7C00 << 13), bits + ((128 - 16) << 23), bits);
+	bits = if_then(shifted > int_t(0x7C00 << 13), bits | 0x400000, bits);
+
+	// Subnormals (and zero) have an implicit exponent of -14. Adding that as a float normalizes them.
+	int_t subnormal = reinterpret(reinterpret(bits + (1 << 23)) - reinterpret(int_t(113 << 23)));
+	bits = if_then(exponent == int_t(0), subnormal, bits);
+
+	return reinterpret(bits | ((half_bits & 0x8000) << 16));
+}
+
+// Loads lane_count halves (as raw bits). Use as load_half<w8_float>(h).
+template <typename float_t>
+static float_t load_half(const u16* h)
+{
+	using int_t = decltype(reinterpret(float_t()));
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	alignas(64) i32 bits[lane_count];
+	for (u32 l = 0; l < lane_count; ++l)
+	{
+		bits[l] = h[l];
+	}
+	return half_to_float_internal<float_t, int_t>(int_t(bits));
+}
+
+// Stores the lanes of f as lane_count halves, rounded to nearest even.
+template <typename float_t>
+static void store_half(u16* h, float_t f)
+{
+	using int_t = decltype(reinterpret(float_t()));
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	alignas(64) i32 bits[lane_count];
+	float_to_half_internal<float_t, int_t>(f).store(bits);
+	for (u32 l = 0; l < lane_count; ++l)
+	{
+		h[l] = (u16)bits[l];
+	}
+}
+
+#if defined(SIMD_SSE_2)
+#if defined(SIMD_F16C)
+template <> w4_float load_half<w4_float>(const u16* h) { return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)h)); }
+template <> void store_half<w4_float>(u16* h, w4_float f) { _mm_storel_epi64((__m128i*)h, _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT)); }
+#else
+template <> w4_float load_half<w4_float>(const u16* h)
+{
+	w4_int half_bits = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)h), _mm_setzero_si128());
+	return half_to_float_internal<w4_float, w4_int>(half_bits);
+}
+template <> void store_half<w4_float>(u16* h, w4_float f)
+{
+	// Sign extend, so that the signed saturating pack of SSE2 keeps the 16 bits.
+	w4_int half_bits = _mm_srai_epi32(_mm_slli_epi32(float_to_half_internal<w4_float, w4_int>(f), 16), 16);
+	_mm_storel_epi64((__m128i*)h, _mm_packs_epi32(half_bits, half_bits));
+}
+#endif
+#endif
+
+#if defined(SIMD_AVX_2) && defined(SIMD_F16C)
+template <> w8_float load_half<w8_float>(const u16* h) { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)h)); }
+template <> void store_half<w8_float>(u16* h, w8_float f) { _mm_storeu_si128((__m128i*)h, _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT)); }
+#endif
+
+#if defined(SIMD_AVX_512)
+template <> w16_float load_half<w16_float>(const u16* h) { return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)h)); }
+template <> void store_half<w16_float>(u16* h, w16_float f) { _mm256_storeu_si256((__m256i*)h, _mm512_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT)); }
+#endif
+
+#if defined(SIMD_SSE_2)
+template <Precision precision = Precision::Fast> static w4_float cos(w4_float x) { return cos_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float sin(w4_float x) { return sin_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float exp2(w4_float x) { return exp2_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float log2(w4_float x) { return log2_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float pow(w4_float x, w4_float y) { return pow_internal<precision, w4_float, w4_int>(x, y); }
+template <Precision precision = Precision::Fast> static w4_float exp(w4_float x) { return exp_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float tanh(w4_float x) { return tanh_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float atan(w4_float x) { return atan_internal<precision, w4_float, w4_int>(x); }
+template <Precision precision = Precision::Fast> static w4_float atan2(w4_float y, w4_float x) { return atan2_internal<precision, w4_float, w4_int>(y, x); }
+template <Precision precision = Precision::Fast> static w4_float acos(w4_float x) { return acos_internal<precision, w4_float, w4_int>(x); }
+#endif
+
+#if defined(SIMD_AVX_2)
+template <Precision precision = Precision::Fast> static w8_float cos(w8_float x) { return cos_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float sin(w8_float x) { return sin_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float exp2(w8_float x) { return exp2_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float log2(w8_float x) { return log2_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float pow(w8_float x, w8_float y) { return pow_internal<precision, w8_float, w8_int>(x, y); }
+template <Precision precision = Precision::Fast> static w8_float exp(w8_float x) { return exp_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float tanh(w8_float x) { return tanh_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float atan(w8_float x) { return atan_internal<precision, w8_float, w8_int>(x); }
+template <Precision precision = Precision::Fast> static w8_float atan2(w8_float y, w8_float x) { return atan2_internal<precision, w8_float, w8_int>(y, x); }
+template <Precision precision = Precision::Fast> static w8_float acos(w8_float x) { return acos_internal<precision, w8_float, w8_int>(x); }
+#endif
+
+#if defined(SIMD_AVX_512)
+template <Precision precision = Precision::Fast> static w16_float cos(w16_float x) { return cos_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float sin(w16_float x) { return sin_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float exp2(w16_float x) { return exp2_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float log2(w16_float x) { return log2_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float pow(w16_float x, w16_float y) { return pow_internal<precision, w16_float, w16_int>(x, y); }
+template <Precision precision = Precision::Fast> static w16_float exp(w16_float x) { return exp_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float tanh(w16_float x) { return tanh_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float atan(w16_float x) { return atan_internal<precision, w16_float, w16_int>(x); }
+template <Precision precision = Precision::Fast> static w16_float atan2(w16_float y, w16_float x) { return atan2_internal<precision, w16_float, w16_int>(y, x); }
+template <Precision precision = Precision::Fast> static w16_float acos(w16_float x) { return acos_internal<precision, w16_float, w16_int>(x); }
+#endif
+
+
+#include "simd_scalar.h"
+
+#if !defined(SIMD_SSE_2)
+using w4_float = scalar_w_float<4>;
+using w4_int = scalar_w_int<4>;
+#endif
+
+#if !defined(SIMD_AVX_2)
+using w8_float = scalar_w_float<8>;
+using w8_int = scalar_w_int<8>;
+#endif
+
+#if !defined(SIMD_AVX_512)
+using w16_float = scalar_w_float<16>;
+using w16_int = scalar_w_int<16>;
+#endif
+
+#if defined(SIMD_NAMESPACE)
+}
+#endif
+
+
 
 
 
@@ -0,0 +1,42 @@
+#include "simd_kernels.h"
+
+#include <atomic>
+
+static std::atomic<const SimdKernels*> active_kernels = nullptr;
+
+static const SimdKernels* get_simd_kernels(SimdLevel level)
+{
+	switch (level)
+	{
+		case SimdLevel::SSE2: return get_simd_kernels_sse2();
+		case SimdLevel::SSE4_1: return get_simd_kernels_sse4_1();
+		case SimdLevel::AVX2: return get_simd_kernels_avx2();
+		case SimdLevel::AVX512: return get_simd_kernels_avx512();
+		default: return nullptr;
+	}
+}
+
+const SimdKernels& get_simd_kernels()
+{
+	const SimdKernels* kernels = active_kernels.load(std::memory_order_acquire);
+	if (!kernels)
+	{
+		// Racing threads all pick the same table.
+		set_simd_level(get_cpu_simd_level());
+		kernels = active_kernels.load(std::memory_order_acquire);
+	}
+	return *kernels;
+}
+
+SimdLevel set_simd_level(SimdLevel level)
+{
+	const SimdKernels* kernels = nullptr;
+	for (i32 i = (i32)min(level, get_cpu_simd_level()); i >= 0 && !kernels; --i)
+	{
+		kernels = get_simd_kernels((SimdLevel)i);
+	}
+	ASSERT(kernels); // SSE2 is always available.
+
+	active_kernels.store(kernels, std::memory_order_release);
+	return kernels->level;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.h"
+#include "cpu_features.h"
+
+// Table of the hot SIMD kernels. The kernels are written once in simd_kernels_impl.h and compiled once per
+// instruction set level, each in its own translation unit (simd_kernels_<level>.cpp) with the matching compiler
+// flags. The table of the best level the CPU supports is picked at startup, so that one binary uses the widest
+// vectors available.
+//
+// The kernels work on plain float arrays, since the per-level translation units must not include math.h (see
+// SIMD_NAMESPACE in simd.h). The typed, batched entry points are in math.h.
+struct SimdKernels
+{
+	SimdLevel level;
+	u32 lane_count;
+
+	// matrix is an affine transform as 3x4 row-major floats. positions and result are count xyz triplets and may
+	// be the same array.
+	void (*transform_positions)(const float* matrix, const float* positions, float* result, u64 count);
+
+	// Matrices are 16 floats, column-major like mat4. result is count tightly packed matrices, and may be the same
+	// array as the input. With a stride of 0, the same matrix is used for all products.
+	void (*multiply_matrices)(const float* a, u64 a_stride, const float* b, u64 b_stride, float* result, u64 count);
+	void (*invert_matrices)(const float* matrices, float* result, u64 count);
+	void (*invert_affine_matrices)(const float* matrices, float* result, u64 count);
+
+	// Transforms are 10 floats (rotation, position, scale), transform_stride floats apart. transforms_to_matrices
+	// writes column-major matrices like transform_to_mat4. transforms_to_rows_3x4 writes the top three rows of these
+	// as 12 row-major floats, result_stride floats apart, and leaves the floats in between alone.
+	void (*transforms_to_matrices)(const float* transforms, u64 transform_stride, float* result, u64 count);
+	void (*transforms_to_rows_3x4)(const float* transforms, u64 transform_stride, float* result, u64 result_stride, u64 count);
+
+	// Smallest box around count xyz triplets. NaN coordinates are skipped. Without any points, the min corner is
+	// FLT_MAX and the max corner -FLT_MAX.
+	void (*bounding_box)(const float* positions, u64 count, float* min_corner, float* max_corner);
+
+	// Element i of aos starts at aos + i * stride, and its first component_count floats are copied to (or from)
+	// soa[0][i], soa[1][i], ... stride is in floats and at least component_count.
+	void (*aos_to_soa)(const float* aos, u64 stride, u32 component_count, float* const* soa, u64 count);
+	void (*soa_to_aos)(const float* const* soa, u32 component_count, float* aos, u64 stride, u64 count);
+
+	// Conversion between floats and IEEE halves (as raw bits), rounding to nearest even. All levels give the same
+	// bits, with F16C or without.
+	void (*float_to_half)(const float* in, u16* out, u64 count);
+	void (*half_to_float)(const u16* in, float* out, u64 count);
+};
+
+// Kernels of the best level the CPU supports, or of the level set with set_simd_level.
+const SimdKernels& get_simd_kernels();
+
+// Uses the kernels of the given level from now on, e.g. to compare the widths against each other. Falls back to
+// lower levels if the CPU or the build doesn't support it. Returns the level which is actually used.
+SimdLevel set_simd_level(SimdLevel level);
+
+// Defined by the per-level translation units. Returns nullptr if the unit was not compiled for its instruction set.
+const SimdKernels* get_simd_kernels_sse2();
+const SimdKernels* get_simd_kernels_sse4_1();
+const SimdKernels* get_simd_kernels_avx2();
+const SimdKernels* get_simd_kernels_avx512();
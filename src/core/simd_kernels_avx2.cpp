@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx2
+#include "simd_kernels_impl.h"
+
+const SimdKernels* get_simd_kernels_avx2()
+{
+#if defined(SIMD_AVX_2) && defined(SIMD_FMA)
+	static const SimdKernels kernels = avx2::create_simd_kernels(SimdLevel::AVX2);
+	return &kernels;
+#else
+	return nullptr;
+#endif
+}
@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx512
+#include "simd_kernels_impl.h"
+
+const SimdKernels* get_simd_kernels_avx512()
+{
+#if defined(SIMD_AVX_512) && defined(SIMD_FMA)
+	static const SimdKernels kernels = avx512::create_simd_kernels(SimdLevel::AVX512);
+	return &kernels;
+#else
+	return nullptr;
+#endif
+}
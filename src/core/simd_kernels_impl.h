@@ -0,0 +1,611 @@
+// Implementation of the kernels in simd_kernels.h, included once by every simd_kernels_<level>.cpp. These define
+// SIMD_NAMESPACE first, and are compiled with the instruction set flags of their level. The wide types then map to
+// the widest registers of that level.
+
+#if !defined(SIMD_NAMESPACE)
+#error Define SIMD_NAMESPACE before including simd_kernels_impl.h.
+#endif
+
+#include "simd.h"
+#include "wide_math.h"
+#include "simd_kernels.h"
+
+namespace SIMD_NAMESPACE {
+
+#if defined(SIMD_AVX_512)
+using kernel_float = w16_float;
+using kernel_int = w16_int;
+#elif defined(SIMD_AVX_2)
+using kernel_float = w8_float;
+using kernel_int = w8_int;
+#else
+using kernel_float = w4_float;
+using kernel_int = w4_int;
+#endif
+
+static constexpr u32 kernel_lane_count = sizeof(kernel_float) / sizeof(float);
+
+// Offsets of the first component of each lane's element, for elements which are stride floats apart.
+static kernel_int strided_offsets(u32 stride)
+{
+	alignas(64) i32 offsets[kernel_lane_count];
+	for (u32 l = 0; l < kernel_lane_count; ++l)
+	{
+		offsets[l] = stride * l;
+	}
+	return kernel_int(offsets);
+}
+
+// Loads four triplets as x, y and z. The fourth float of every row is read too, so the element after the four
+// triplets must exist.
+static void load_triplets(const float* in, w4_float& x, w4_float& y, w4_float& z)
+{
+	x = w4_float(in);
+	y = w4_float(in + 3);
+	z = w4_float(in + 6);
+	w4_float w(in + 9);
+	transpose(x, y, z, w);
+}
+
+// Calls block_function(x, y, z) for every four triplets, which returns the transformed x, y and z. in and out may be
+// the same array. Like load_triplets, the loads and stores cover a fourth float per triplet. The stores write the
+// element after the four triplets with its original x, and the next four triplets are loaded before the stores of
+// the current ones: that makes in-place use safe, and avoids stalls on loads which partially overlap a store.
+template <typename F>
+static void for_each_four_triplets(const float* in, float* out, u64 count, const F& block_function)
+{
+	u64 block_count = count > 0 ? (count - 1) / 4 : 0;
+
+	w4_float x, y, z;
+	if (block_count > 0)
+	{
+		load_triplets(in, x, y, z);
+	}
+
+	for (u64 b = 0; b < block_count; ++b)
+	{
+		const float* block_in = in + 12 * b;
+		float* block_out = out + 12 * b;
+
+		w4_float rx, ry, rz;
+		block_function(x, y, z, rx, ry, rz);
+
+		w4_float next_x(block_in[12]);
+		if (b + 1 < block_count)
+		{
+			load_triplets(block_in + 12, x, y, z);
+		}
+
+		transpose(rx, ry, rz, next_x);
+		rx.store(block_out);
+		ry.store(block_out + 3);
+		rz.store(block_out + 6);
+		next_x.store(block_out + 9);
+	}
+
+	// The last triplets go through the same block function, from and to a padded block.
+	u64 done = 4 * block_count;
+	if (done < count)
+	{
+		alignas(16) float tail[16] = {};
+		u64 tail_size = 3 * (count - done) * sizeof(float);
+		memcpy(tail, in + 3 * done, tail_size);
+
+		load_triplets(tail, x, y, z);
+		w4_float rx, ry, rz, rw;
+		block_function(x, y, z, rx, ry, rz);
+		transpose(rx, ry, rz, rw);
+		rx.store(tail);
+		ry.store(tail + 3);
+		rz.store(tail + 6);
+		rw.store(tail + 9);
+
+		memcpy(out + 3 * done, tail, tail_size);
+	}
+}
+
+static void transform_positions(const float* matrix, const float* positions, float* result, u64 count)
+{
+	w4_float m00(matrix[0]), m01(matrix[1]), m02(matrix[2]), m03(matrix[3]);
+	w4_float m10(matrix[4]), m11(matrix[5]), m12(matrix[6]), m13(matrix[7]);
+	w4_float m20(matrix[8]), m21(matrix[9]), m22(matrix[10]), m23(matrix[11]);
+
+	for_each_four_triplets(positions, result, count, [&](w4_float x, w4_float y, w4_float z, w4_float& rx, w4_float& ry, w4_float& rz)
+	{
+		rx = fmadd(m00, x, fmadd(m01, y, fmadd(m02, z, m03)));
+		ry = fmadd(m10, x, fmadd(m11, y, fmadd(m12, z, m13)));
+		rz = fmadd(m20, x, fmadd(m21, y, fmadd(m22, z, m23)));
+	});
+}
+
+// Three registers hold kernel_lane_count triplets, and lane l of register r always holds component
+// (r * kernel_lane_count + l) % 3. So the minima and maxima are taken straight on the loaded registers, and only
+// sorted into components at the end. NaNs are skipped, since minimum and maximum then return their second operand.
+static void bounding_box(const float* positions, u64 count, float* min_corner, float* max_corner)
+{
+	kernel_float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	kernel_float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	u64 full_count = count - count % kernel_lane_count;
+	for (u64 i = 0; i < full_count; i += kernel_lane_count)
+	{
+		const float* block = positions + 3 * i;
+		for (u32 r = 0; r < 3; ++r)
+		{
+			kernel_float v(block + r * kernel_lane_count);
+			lo[r] = minimum(v, lo[r]);
+			hi[r] = maximum(v, hi[r]);
+		}
+	}
+
+	alignas(64) float lo_lanes[3 * kernel_lane_count];
+	alignas(64) float hi_lanes[3 * kernel_lane_count];
+	for (u32 r = 0; r < 3; ++r)
+	{
+		lo[r].store(lo_lanes + r * kernel_lane_count);
+		hi[r].store(hi_lanes + r * kernel_lane_count);
+	}
+
+	float result_lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float result_hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (u32 k = 0; k < 3 * kernel_lane_count; ++k)
+	{
+		result_lo[k % 3] = lo_lanes[k] < result_lo[k % 3] ? lo_lanes[k] : result_lo[k % 3];
+		result_hi[k % 3] = hi_lanes[k] > result_hi[k % 3] ? hi_lanes[k] : result_hi[k % 3];
+	}
+	for (u64 k = 3 * full_count; k < 3 * count; ++k)
+	{
+		result_lo[k % 3] = positions[k] < result_lo[k % 3] ? positions[k] : result_lo[k % 3];
+		result_hi[k % 3] = positions[k] > result_hi[k % 3] ? positions[k] : result_hi[k % 3];
+	}
+
+	memcpy(min_corner, result_lo, sizeof(result_lo));
+	memcpy(max_corner, result_hi, sizeof(result_hi));
+}
+
+// Matrices are column-major like mat4, so element mRC is at 4 * C + R. The kernels which do enough math per matrix
+// work on several matrices at once, as the SoA types of wide_math.h: four at a time, or eight with AVX2 and up, where
+// 8x8 transposes are available. There is no 16x16 transpose, so AVX-512 stays at eight.
+#if defined(SIMD_AVX_2)
+using matrix_float = w8_float;
+#else
+using matrix_float = w4_float;
+#endif
+
+using matrix_mat4 = wN_mat4<matrix_float>;
+
+static constexpr u32 matrix_lane_count = sizeof(matrix_float) / sizeof(float);
+
+// c holds the components of the matrices in memory order.
+static matrix_mat4 components_to_matrices(const matrix_float (&c)[16])
+{
+	return
+	{
+		c[0], c[4], c[8], c[12],
+		c[1], c[5], c[9], c[13],
+		c[2], c[6], c[10], c[14],
+		c[3], c[7], c[11], c[15],
+	};
+}
+
+// Matrix l is at in + l * stride.
+static matrix_mat4 load_matrices(const float* in, u64 stride)
+{
+	matrix_float c[16];
+	for (u32 first = 0; first < 16; first += matrix_lane_count)
+	{
+		matrix_float* r = c + first;
+		for (u32 l = 0; l < matrix_lane_count; ++l)
+		{
+			r[l] = matrix_float(in + l * stride + first);
+		}
+#if defined(SIMD_AVX_2)
+		transpose(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]);
+#else
+		transpose(r[0], r[1], r[2], r[3]);
+#endif
+	}
+	return components_to_matrices(c);
+}
+
+static void store_matrices(float* out, u64 stride, const matrix_mat4& m)
+{
+	matrix_float c[16] =
+	{
+		m.m00, m.m10, m.m20, m.m30,
+		m.m01, m.m11, m.m21, m.m31,
+		m.m02, m.m12, m.m22, m.m32,
+		m.m03, m.m13, m.m23, m.m33,
+	};
+	for (u32 first = 0; first < 16; first += matrix_lane_count)
+	{
+		matrix_float* r = c + first;
+#if defined(SIMD_AVX_2)
+		transpose(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]);
+#else
+		transpose(r[0], r[1], r[2], r[3]);
+#endif
+		for (u32 l = 0; l < matrix_lane_count; ++l)
+		{
+			r[l].store(out + l * stride + first);
+		}
+	}
+}
+
+// Calls block_function(in, in_stride, out, out_stride) for every lane_count elements. Elements of in are in_size
+// floats and in_stride floats apart, likewise for out. The tail is copied to a zero padded block, and goes through
+// the same function.
+template <u32 lane_count, typename F>
+static void for_each_element_block(const float* in, u64 in_stride, u32 in_size, float* out, u64 out_stride, u32 out_size,
+	u64 count, const F& block_function)
+{
+	u64 full_count = count - count % lane_count;
+	for (u64 i = 0; i < full_count; i += lane_count)
+	{
+		block_function(in + i * in_stride, in_stride, out + i * out_stride, out_stride);
+	}
+
+	if (full_count < count)
+	{
+		alignas(64) float tail_in[16 * lane_count] = {};
+		alignas(64) float tail_out[16 * lane_count];
+		u64 tail_count = count - full_count;
+
+		for (u64 i = 0; i < tail_count; ++i)
+		{
+			memcpy(tail_in + i * in_size, in + (full_count + i) * in_stride, in_size * sizeof(float));
+		}
+		block_function(tail_in, in_size, tail_out, out_size);
+		for (u64 i = 0; i < tail_count; ++i)
+		{
+			memcpy(out + (full_count + i) * out_stride, tail_out + i * out_size, out_size * sizeof(float));
+		}
+	}
+}
+
+// A product is only 16 fmadds, so the matrices are not transposed: every column of the result is a sum of the
+// columns of a, times broadcast elements of b.
+static void multiply_matrices(const float* a, u64 a_stride, const float* b, u64 b_stride, float* result, u64 count)
+{
+	for (u64 i = 0; i < count; ++i)
+	{
+		const float* ma = a + i * a_stride;
+		const float* mb = b + i * b_stride;
+		float* r = result + 16 * i;
+
+		w4_float a0(ma), a1(ma + 4), a2(ma + 8), a3(ma + 12);
+		for (u32 c = 0; c < 16; c += 4)
+		{
+			w4_float column = fmadd(a0, w4_float(mb[c]), fmadd(a1, w4_float(mb[c + 1]), fmadd(a2, w4_float(mb[c + 2]), a3 * w4_float(mb[c + 3]))));
+			column.store(r + c);
+		}
+	}
+}
+
+// Cofactors from the 2x2 determinants of the top and bottom two rows (Eberly, "The Laplace Expansion Theorem").
+// Singular matrices give zero matrices.
+static void invert_matrices(const float* matrices, float* result, u64 count)
+{
+	for_each_element_block<matrix_lane_count>(matrices, 16, 16, result, 16, 16, count, [](const float* in, u64 in_stride, float* out, u64 out_stride)
+	{
+		matrix_mat4 m = load_matrices(in, in_stride);
+
+		matrix_float s0 = fmsub(m.m00, m.m11, m.m10 * m.m01);
+		matrix_float s1 = fmsub(m.m00, m.m12, m.m10 * m.m02);
+		matrix_float s2 = fmsub(m.m00, m.m13, m.m10 * m.m03);
+		matrix_float s3 = fmsub(m.m01, m.m12, m.m11 * m.m02);
+		matrix_float s4 = fmsub(m.m01, m.m13, m.m11 * m.m03);
+		matrix_float s5 = fmsub(m.m02, m.m13, m.m12 * m.m03);
+
+		matrix_float c5 = fmsub(m.m22, m.m33, m.m32 * m.m23);
+		matrix_float c4 = fmsub(m.m21, m.m33, m.m31 * m.m23);
+		matrix_float c3 = fmsub(m.m21, m.m32, m.m31 * m.m22);
+		matrix_float c2 = fmsub(m.m20, m.m33, m.m30 * m.m23);
+		matrix_float c1 = fmsub(m.m20, m.m32, m.m30 * m.m22);
+		matrix_float c0 = fmsub(m.m20, m.m31, m.m30 * m.m21);
+
+		matrix_float det = fmadd(s0, c5, fmsub(s2, c3, s1 * c4)) + fmadd(s3, c2, fmsub(s5, c0, s4 * c1));
+		matrix_float zero = matrix_float::zero();
+		matrix_float inv_det = if_then(det == zero, zero, matrix_float(1.f) / det);
+
+		matrix_mat4 r;
+		r.m00 = fmadd(m.m11, c5, fmsub(m.m13, c3, m.m12 * c4)) * inv_det;
+		r.m01 = fmsub(m.m02, c4, fmadd(m.m01, c5, m.m03 * c3)) * inv_det;
+		r.m02 = fmadd(m.m31, s5, fmsub(m.m33, s3, m.m32 * s4)) * inv_det;
+		r.m03 = fmsub(m.m22, s4, fmadd(m.m21, s5, m.m23 * s3)) * inv_det;
+
+		r.m10 = fmsub(m.m12, c2, fmadd(m.m10, c5, m.m13 * c1)) * inv_det;
+		r.m11 = fmadd(m.m00, c5, fmsub(m.m03, c1, m.m02 * c2)) * inv_det;
+		r.m12 = fmsub(m.m32, s2, fmadd(m.m30, s5, m.m33 * s1)) * inv_det;
+		r.m13 = fmadd(m.m20, s5, fmsub(m.m23, s1, m.m22 * s2)) * inv_det;
+
+		r.m20 = fmadd(m.m10, c4, fmsub(m.m13, c0, m.m11 * c2)) * inv_det;
+		r.m21 = fmsub(m.m01, c2, fmadd(m.m00, c4, m.m03 * c0)) * inv_det;
+		r.m22 = fmadd(m.m30, s4, fmsub(m.m33, s0, m.m31 * s2)) * inv_det;
+		r.m23 = fmsub(m.m21, s2, fmadd(m.m20, s4, m.m23 * s0)) * inv_det;
+
+		r.m30 = fmsub(m.m11, c1, fmadd(m.m10, c3, m.m12 * c0)) * inv_det;
+		r.m31 = fmadd(m.m00, c3, fmsub(m.m02, c0, m.m01 * c1)) * inv_det;
+		r.m32 = fmsub(m.m31, s1, fmadd(m.m30, s3, m.m32 * s0)) * inv_det;
+		r.m33 = fmadd(m.m20, s3, fmsub(m.m22, s0, m.m21 * s1)) * inv_det;
+
+		store_matrices(out, out_stride, r);
+	});
+}
+
+// Same as invert_affine_matrix: the axes must be orthogonal, but may be scaled. This is little enough math that one
+// matrix at a time, with a single transpose, beats transposing several into and out of SoA form.
+static void invert_affine_matrices(const float* matrices, float* result, u64 count)
+{
+	w4_float xyz_mask = reinterpret(w4_int(-1, -1, -1, 0));
+	w4_float w_one(0.f, 0.f, 0.f, 1.f);
+
+	for (u64 i = 0; i < count; ++i)
+	{
+		const float* m = matrices + 16 * i;
+		float* r = result + 16 * i;
+
+		// After the transpose, lanes 0 - 2 of the rows are the x, y and z axes.
+		w4_float row0(m), row1(m + 4), row2(m + 8), row3(m + 12);
+		transpose(row0, row1, row2, row3);
+
+		w4_float inv_squared_lengths = w4_float(1.f) / fmadd(row0, row0, fmadd(row1, row1, row2 * row2));
+		w4_float column0 = (row0 * inv_squared_lengths) & xyz_mask;
+		w4_float column1 = (row1 * inv_squared_lengths) & xyz_mask;
+		w4_float column2 = (row2 * inv_squared_lengths) & xyz_mask;
+		w4_float column3 = w_one - fmadd(column0, w4_float(m[12]), fmadd(column1, w4_float(m[13]), column2 * w4_float(m[14])));
+
+		column0.store(r);
+		column1.store(r + 4);
+		column2.store(r + 8);
+		column3.store(r + 12);
+	}
+}
+
+// Transforms are rotation, position and scale: 10 floats, loaded as three overlapping groups of four. There are only
+// a few multiplies per transform, so this stays at four lanes on all levels, like the AoS/SoA conversions below. The
+// result is either column-major matrices, or the top three rows of these, row-major.
+template <bool rows_3x4>
+static void convert_transforms(const float* transforms, u64 transform_stride, float* result, u64 result_stride, u64 count)
+{
+	for_each_element_block<4>(transforms, transform_stride, 10, result, result_stride, rows_3x4 ? 12 : 16, count,
+		[](const float* in, u64 in_stride, float* out, u64 out_stride)
+	{
+		w4_float c[12];
+		for (u32 group = 0; group < 3; ++group)
+		{
+			u32 first = group < 2 ? 4 * group : 6;
+			w4_float* r = c + 4 * group;
+			for (u32 l = 0; l < 4; ++l)
+			{
+				r[l] = w4_float(in + l * in_stride + first);
+			}
+			transpose(r[0], r[1], r[2], r[3]);
+		}
+
+		wN_quat<w4_float> rotation(c[0], c[1], c[2], c[3]);
+		wN_vec3<w4_float> position(c[4], c[5], c[6]);
+		wN_vec3<w4_float> scale(c[9], c[10], c[11]);
+
+		// Same as create_model_matrix.
+		wN_vec3<w4_float> r2 = rotation.v() + rotation.v();
+		w4_float xx2 = rotation.x * r2.x, yy2 = rotation.y * r2.y, zz2 = rotation.z * r2.z;
+		w4_float yz2 = rotation.y * r2.z, wx2 = rotation.w * r2.x;
+		w4_float xy2 = rotation.x * r2.y, wz2 = rotation.w * r2.z;
+		w4_float xz2 = rotation.x * r2.z, wy2 = rotation.w * r2.y;
+
+		w4_float one(1.f), zero = w4_float::zero();
+		w4_float m[4][4] =
+		{
+			{ (one - (yy2 + zz2)) * scale.x, (xy2 - wz2) * scale.y, (xz2 + wy2) * scale.z, position.x },
+			{ (xy2 + wz2) * scale.x, (one - (xx2 + zz2)) * scale.y, (yz2 - wx2) * scale.z, position.y },
+			{ (xz2 - wy2) * scale.x, (yz2 + wx2) * scale.y, (one - (xx2 + yy2)) * scale.z, position.z },
+			{ zero, zero, zero, one },
+		};
+
+		// Rows of m are transposed into the rows of the results, or columns into the columns.
+		if (!rows_3x4)
+		{
+			transpose(m[0][0], m[1][0], m[2][0], m[3][0]);
+			transpose(m[0][1], m[1][1], m[2][1], m[3][1]);
+			transpose(m[0][2], m[1][2], m[2][2], m[3][2]);
+			transpose(m[0][3], m[1][3], m[2][3], m[3][3]);
+			for (u32 l = 0; l < 4; ++l)
+			{
+				for (u32 column = 0; column < 4; ++column)
+				{
+					m[l][column].store(out + l * out_stride + 4 * column);
+				}
+			}
+		}
+		else
+		{
+			for (u32 row = 0; row < 3; ++row)
+			{
+				w4_float* r = m[row];
+				transpose(r[0], r[1], r[2], r[3]);
+				for (u32 l = 0; l < 4; ++l)
+				{
+					r[l].store(out + l * out_stride + 4 * row);
+				}
+			}
+		}
+	});
+}
+
+static void transforms_to_matrices(const float* transforms, u64 transform_stride, float* result, u64 count)
+{
+	convert_transforms<false>(transforms, transform_stride, result, 16, count);
+}
+
+static void transforms_to_rows_3x4(const float* transforms, u64 transform_stride, float* result, u64 result_stride, u64 count)
+{
+	convert_transforms<true>(transforms, transform_stride, result, result_stride, count);
+}
+
+// Components are moved four at a time, by loading four elements into w4_floats and transposing them. Where the
+// component count is not a multiple of four, the last group of four overlaps the previous one. With fewer than four
+// components, the loads and stores reach up to 4 - component_count floats past the element. These stay inside the
+// stream as long as the stride is at least that, since the last element always goes through the scalar tail. The
+// stores are only allowed if the elements are tightly packed, so that what they overwrite belongs to later elements,
+// which are written afterwards.
+static bool can_transpose(u64 stride, u32 component_count)
+{
+	return component_count >= 4 || stride + component_count >= 4;
+}
+
+static u32 component_group_start(u32 group, u32 component_count)
+{
+	return (group + 4 <= component_count || component_count < 4) ? group : component_count - 4;
+}
+
+static void aos_to_soa(const float* aos, u64 stride, u32 component_count, float* const* soa, u64 count)
+{
+	u64 i = 0;
+	if (can_transpose(stride, component_count))
+	{
+		for (; i + 4 < count; i += 4)
+		{
+			const float* block = aos + i * stride;
+			for (u32 group = 0; group < component_count; group += 4)
+			{
+				u32 c = component_group_start(group, component_count);
+
+				w4_float x(block + c);
+				w4_float y(block + stride + c);
+				w4_float z(block + 2 * stride + c);
+				w4_float w(block + 3 * stride + c);
+				transpose(x, y, z, w);
+
+				x.store(soa[c] + i);
+				if (c + 1 < component_count) { y.store(soa[c + 1] + i); }
+				if (c + 2 < component_count) { z.store(soa[c + 2] + i); }
+				if (c + 3 < component_count) { w.store(soa[c + 3] + i); }
+			}
+		}
+	}
+	else
+	{
+		kernel_int offsets = strided_offsets((u32)stride);
+		for (; i + kernel_lane_count <= count; i += kernel_lane_count)
+		{
+			const float* block = aos + i * stride;
+			for (u32 c = 0; c < component_count; ++c)
+			{
+				kernel_float(block + c, offsets).store(soa[c] + i);
+			}
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		for (u32 c = 0; c < component_count; ++c)
+		{
+			soa[c][i] = aos[i * stride + c];
+		}
+	}
+}
+
+static void soa_to_aos(const float* const* soa, u32 component_count, float* aos, u64 stride, u64 count)
+{
+	u64 i = 0;
+	if (can_transpose(stride, component_count) && (component_count >= 4 || stride == component_count))
+	{
+		for (; i + 4 < count; i += 4)
+		{
+			float* block = aos + i * stride;
+			for (u32 group = 0; group < component_count; group += 4)
+			{
+				u32 c = component_group_start(group, component_count);
+
+				w4_float x(soa[c] + i);
+				w4_float y = (c + 1 < component_count) ? w4_float(soa[c + 1] + i) : x;
+				w4_float z = (c + 2 < component_count) ? w4_float(soa[c + 2] + i) : x;
+				w4_float w = (c + 3 < component_count) ? w4_float(soa[c + 3] + i) : x;
+				transpose(x, y, z, w);
+
+				x.store(block + c);
+				y.store(block + stride + c);
+				z.store(block + 2 * stride + c);
+				w.store(block + 3 * stride + c);
+			}
+		}
+	}
+	else
+	{
+		kernel_int offsets = strided_offsets((u32)stride);
+		for (; i + kernel_lane_count <= count; i += kernel_lane_count)
+		{
+			float* block = aos + i * stride;
+			for (u32 c = 0; c < component_count; ++c)
+			{
+				kernel_float(soa[c] + i).scatter(block + c, offsets);
+			}
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		for (u32 c = 0; c < component_count; ++c)
+		{
+			aos[i * stride + c] = soa[c][i];
+		}
+	}
+}
+
+static void float_to_half(const float* in, u16* out, u64 count)
+{
+	u64 full_count = count - count % kernel_lane_count;
+	for (u64 i = 0; i < full_count; i += kernel_lane_count)
+	{
+		store_half(out + i, kernel_float(in + i));
+	}
+
+	if (full_count < count)
+	{
+		alignas(64) float tail[kernel_lane_count] = {};
+		alignas(64) u16 tail_out[kernel_lane_count];
+		memcpy(tail, in + full_count, (count - full_count) * sizeof(float));
+		store_half(tail_out, kernel_float(tail));
+		memcpy(out + full_count, tail_out, (count - full_count) * sizeof(u16));
+	}
+}
+
+static void half_to_float(const u16* in, float* out, u64 count)
+{
+	u64 full_count = count - count % kernel_lane_count;
+	for (u64 i = 0; i < full_count; i += kernel_lane_count)
+	{
+		load_half<kernel_float>(in + i).store(out + i);
+	}
+
+	if (full_count < count)
+	{
+		alignas(64) u16 tail[kernel_lane_count] = {};
+		alignas(64) float tail_out[kernel_lane_count];
+		memcpy(tail, in + full_count, (count - full_count) * sizeof(u16));
+		load_half<kernel_float>(tail).store(tail_out);
+		memcpy(out + full_count, tail_out, (count - full_count) * sizeof(float));
+	}
+}
+
+static SimdKernels create_simd_kernels(SimdLevel level)
+{
+	SimdKernels kernels;
+	kernels.level = level;
+	kernels.lane_count = kernel_lane_count;
+	kernels.transform_positions = transform_positions;
+	kernels.multiply_matrices = multiply_matrices;
+	kernels.invert_matrices = invert_matrices;
+	kernels.invert_affine_matrices = invert_affine_matrices;
+	kernels.transforms_to_matrices = transforms_to_matrices;
+	kernels.transforms_to_rows_3x4 = transforms_to_rows_3x4;
+	kernels.bounding_box = bounding_box;
+	kernels.aos_to_soa = aos_to_soa;
+	kernels.soa_to_aos = soa_to_aos;
+	kernels.float_to_half = float_to_half;
+	kernels.half_to_float = half_to_float;
+	return kernels;
+}
+
+}
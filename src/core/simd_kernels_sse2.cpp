@@ -0,0 +1,8 @@
+#define SIMD_NAMESPACE sse2
+#include "simd_kernels_impl.h"
+
+const SimdKernels* get_simd_kernels_sse2()
+{
+	static const SimdKernels kernels = sse2::create_simd_kernels(SimdLevel::SSE2);
+	return &kernels;
+}
@@ -0,0 +1,17 @@
+// MSVC has no compiler switch for SSE4.1, but always accepts its intrinsics.
+#if defined(_MSC_VER) && defined(_M_X64)
+#define SIMD_SSE_4_1
+#endif
+
+#define SIMD_NAMESPACE sse4_1
+#include "simd_kernels_impl.h"
+
+const SimdKernels* get_simd_kernels_sse4_1()
+{
+#if defined(SIMD_SSE_4_1)
+	static const SimdKernels kernels = sse4_1::create_simd_kernels(SimdLevel::SSE4_1);
+	return &kernels;
+#else
+	return nullptr;
+#endif
+}
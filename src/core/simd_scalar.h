@@ -0,0 +1,293 @@
+#pragma once
+
+// Scalar reference implementation of the wide types. Included by simd.h, which uses it for every width the
+// target has no instructions for, and for all widths if SIMD_SCALAR is defined.
+//
+// Every lane is computed with plain C++, but following the semantics of the SSE/AVX instructions where these
+// differ from the C++ operators: integer arithmetic wraps around, right shifts are logical, shift counts of 32 or
+// more give zero, minimum and maximum return the second operand if either one is NaN, and float to int conversion
+// rounds to nearest even and gives 0x80000000 when out of range. Comparisons return all-ones lanes, like SSE and
+// AVX2 (not bit masks like AVX-512). The types have the size and alignment of the corresponding registers.
+//
+// fmadd is fused here, without FMA instructions the wide types multiply and add separately. To compare them bit
+// for bit against this path, build with FMA and -ffp-contract=off, so that GCC and Clang don't fuse the scalar
+// code on their own.
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+template <u32 lane_count> struct scalar_w_float;
+template <u32 lane_count> struct scalar_w_int;
+
+static u32 scalar_float_bits(float f) { u32 u; memcpy(&u, &f, sizeof(u)); return u; }
+static float scalar_bits_float(u32 u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+// With fast math, GCC computes vectorized float square roots from the reciprocal square root estimate, which is off
+// by a few ulp. The empty asm keeps the loops which call this from being vectorized, so that the result is exact,
+// like that of sqrtps.
+static float scalar_sqrt(float f)
+{
+#if defined(__GNUC__)
+	__asm__("" : "+g"(f));
+#endif
+	return std::sqrt(f);
+}
+
+template <u32 lane_count>
+struct alignas(lane_count * sizeof(i32)) scalar_w_int
+{
+	i32 i[lane_count];
+
+	scalar_w_int() = default;
+	scalar_w_int(i32 i_) { for (u32 l = 0; l < lane_count; ++l) { i[l] = i_; } }
+	template <typename... T, typename = std::enable_if_t<(lane_count > 1) && sizeof...(T) == lane_count - 1>>
+	scalar_w_int(i32 a, T... rest) : i{ a, (i32)rest... } {}
+	scalar_w_int(const i32* i_) { memcpy(i, i_, sizeof(i)); }
+
+	scalar_w_int(const i32* base_address, scalar_w_int indices) { for (u32 l = 0; l < lane_count; ++l) { i[l] = base_address[indices.i[l]]; } }
+	template <typename... T, typename = std::enable_if_t<sizeof...(T) == lane_count>>
+	scalar_w_int(const i32* base_address, T... indices) : scalar_w_int(base_address, scalar_w_int((i32)indices...)) {}
+
+	i32 operator[](u32 l) const { return i[l]; }
+
+	void store(i32* i_) const { memcpy(i_, i, sizeof(i)); }
+
+	void scatter(i32* base_address, scalar_w_int indices) const { for (u32 l = 0; l < lane_count; ++l) { base_address[indices.i[l]] = i[l]; } }
+	template <typename... T, typename = std::enable_if_t<sizeof...(T) == lane_count>>
+	void scatter(i32* base_address, T... indices) const { scatter(base_address, scalar_w_int((i32)indices...)); }
+
+	static scalar_w_int all_ones() { return -1; }
+	static scalar_w_int zero() { return 0; }
+
+
+	template <typename F>
+	static scalar_w_int per_lane(const F& lane_function) { scalar_w_int r; for (u32 l = 0; l < lane_count; ++l) { r.i[l] = (i32)lane_function(l); } return r; }
+
+	static i32 mask_lane(bool b) { return b ? -1 : 0; }
+
+
+	friend scalar_w_float<lane_count> convert(scalar_w_int a) { return scalar_w_float<lane_count>::per_lane([&](u32 l) { return (float)a.i[l]; }); }
+	friend scalar_w_float<lane_count> reinterpret(scalar_w_int a) { return scalar_w_float<lane_count>::per_lane([&](u32 l) { return scalar_bits_float((u32)a.i[l]); }); }
+
+	friend scalar_w_int and_not(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return ~a.i[l] & b.i[l]; }); }
+
+	// Unsigned arithmetic, so that overflow wraps around like in the registers.
+	friend scalar_w_int operator+(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return (u32)a.i[l] + (u32)b.i[l]; }); }
+	friend scalar_w_int& operator+=(scalar_w_int& a, scalar_w_int b) { a = a + b; return a; }
+	friend scalar_w_int operator-(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return (u32)a.i[l] - (u32)b.i[l]; }); }
+	friend scalar_w_int& operator-=(scalar_w_int& a, scalar_w_int b) { a = a - b; return a; }
+	friend scalar_w_int operator*(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return (u32)a.i[l] * (u32)b.i[l]; }); }
+	friend scalar_w_int& operator*=(scalar_w_int& a, scalar_w_int b) { a = a * b; return a; }
+	friend scalar_w_int operator/(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return a.i[l] / b.i[l]; }); }
+	friend scalar_w_int& operator/=(scalar_w_int& a, scalar_w_int b) { a = a / b; return a; }
+	friend scalar_w_int operator&(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return a.i[l] & b.i[l]; }); }
+	friend scalar_w_int& operator&=(scalar_w_int& a, scalar_w_int b) { a = a & b; return a; }
+	friend scalar_w_int operator|(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return a.i[l] | b.i[l]; }); }
+	friend scalar_w_int& operator|=(scalar_w_int& a, scalar_w_int b) { a = a | b; return a; }
+	friend scalar_w_int operator^(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return a.i[l] ^ b.i[l]; }); }
+	friend scalar_w_int& operator^=(scalar_w_int& a, scalar_w_int b) { a = a ^ b; return a; }
+
+	friend scalar_w_int operator~(scalar_w_int a) { return per_lane([&](u32 l) { return ~a.i[l]; }); }
+
+	friend scalar_w_int operator>>(scalar_w_int a, i32 b) { return per_lane([&](u32 l) { return ((u32)b < 32) ? ((u32)a.i[l] >> b) : 0u; }); }
+	friend scalar_w_int operator>>(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return ((u32)b.i[l] < 32) ? ((u32)a.i[l] >> b.i[l]) : 0u; }); }
+	friend scalar_w_int& operator>>=(scalar_w_int& a, i32 b) { a = a >> b; return a; }
+	friend scalar_w_int& operator>>=(scalar_w_int& a, scalar_w_int b) { a = a >> b; return a; }
+	friend scalar_w_int operator<<(scalar_w_int a, i32 b) { return per_lane([&](u32 l) { return ((u32)b < 32) ? ((u32)a.i[l] << b) : 0u; }); }
+	friend scalar_w_int operator<<(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return ((u32)b.i[l] < 32) ? ((u32)a.i[l] << b.i[l]) : 0u; }); }
+	friend scalar_w_int& operator<<=(scalar_w_int& a, i32 b) { a = a << b; return a; }
+	friend scalar_w_int& operator<<=(scalar_w_int& a, scalar_w_int b) { a = a << b; return a; }
+
+	friend scalar_w_int operator-(scalar_w_int a) { return zero() - a; }
+
+	friend scalar_w_int operator==(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] == b.i[l]); }); }
+	friend scalar_w_int operator!=(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] != b.i[l]); }); }
+	friend scalar_w_int operator>(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] > b.i[l]); }); }
+	friend scalar_w_int operator>=(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] >= b.i[l]); }); }
+	friend scalar_w_int operator<(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] < b.i[l]); }); }
+	friend scalar_w_int operator<=(scalar_w_int a, scalar_w_int b) { return per_lane([&](u32 l) { return mask_lane(a.i[l] <= b.i[l]); }); }
+
+	// Like blendv, only the sign bit of the condition counts.
+	friend scalar_w_int if_then(scalar_w_int cond, scalar_w_int if_case, scalar_w_int else_case) { return per_lane([&](u32 l) { return (cond.i[l] < 0) ? if_case.i[l] : else_case.i[l]; }); }
+
+	friend i32 to_bit_mask(scalar_w_int a) { i32 mask = 0; for (u32 l = 0; l < lane_count; ++l) { mask |= (a.i[l] < 0) << l; } return mask; }
+
+	friend u32 compress_store(i32* dst, scalar_w_int value, i32 bit_mask) { u32 count = 0; for (u32 l = 0; l < lane_count; ++l) { if ((bit_mask >> l) & 1) { dst[count++] = value.i[l]; } } return count; }
+
+	friend bool all_true(scalar_w_int a) { return to_bit_mask(a) == (i32)((1ull << lane_count) - 1); }
+	friend bool all_false(scalar_w_int a) { return to_bit_mask(a) == 0; }
+	friend bool any_true(scalar_w_int a) { return to_bit_mask(a) != 0; }
+	friend bool any_false(scalar_w_int a) { return !all_true(a); }
+
+	friend scalar_w_int fill_with_first_lane(scalar_w_int a) { return a.i[0]; }
+
+	friend scalar_w_int popcount(scalar_w_int i)
+	{
+		i = i - ((i >> 1) & 0x55555555);
+		i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
+		return (((i + (i >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+	}
+};
+
+template <u32 lane_count>
+struct alignas(lane_count * sizeof(float)) scalar_w_float
+{
+	float f[lane_count];
+
+	scalar_w_float() = default;
+	scalar_w_float(float f_) { for (u32 l = 0; l < lane_count; ++l) { f[l] = f_; } }
+	template <typename... T, typename = std::enable_if_t<(lane_count > 1) && sizeof...(T) == lane_count - 1>>
+	scalar_w_float(float a, T... rest) : f{ a, (float)rest... } {}
+	scalar_w_float(const float* f_) { memcpy(f, f_, sizeof(f)); }
+
+	scalar_w_float(const float* base_address, scalar_w_int<lane_count> indices) { for (u32 l = 0; l < lane_count; ++l) { f[l] = base_address[indices.i[l]]; } }
+	template <typename... T, typename = std::enable_if_t<sizeof...(T) == lane_count>>
+	scalar_w_float(const float* base_address, T... indices) : scalar_w_float(base_address, scalar_w_int<lane_count>((i32)indices...)) {}
+
+	float operator[](u32 l) const { return f[l]; }
+
+	void store(float* f_) const { memcpy(f_, f, sizeof(f)); }
+
+	void scatter(float* base_address, scalar_w_int<lane_count> indices) const { for (u32 l = 0; l < lane_count; ++l) { base_address[indices.i[l]] = f[l]; } }
+	template <typename... T, typename = std::enable_if_t<sizeof...(T) == lane_count>>
+	void scatter(float* base_address, T... indices) const { scatter(base_address, scalar_w_int<lane_count>((i32)indices...)); }
+
+	static scalar_w_float all_ones() { return scalar_bits_float(0xFFFFFFFF); }
+	static scalar_w_float zero() { return 0.f; }
+
+
+	template <typename F>
+	static scalar_w_float per_lane(const F& lane_function) { scalar_w_float r; for (u32 l = 0; l < lane_count; ++l) { r.f[l] = lane_function(l); } return r; }
+
+	template <typename F>
+	static scalar_w_float per_lane_bits(const F& lane_function) { scalar_w_float r; for (u32 l = 0; l < lane_count; ++l) { r.f[l] = scalar_bits_float(lane_function(l)); } return r; }
+
+	u32 bits(u32 l) const { return scalar_float_bits(f[l]); }
+
+	static u32 mask_lane(bool b) { return b ? 0xFFFFFFFF : 0; }
+
+
+	friend scalar_w_int<lane_count> convert(scalar_w_float a)
+	{
+		return scalar_w_int<lane_count>::per_lane([&](u32 l)
+		{
+			float r = std::nearbyint(a.f[l]);
+			return (r >= -2147483648.f && r < 2147483648.f) ? (i32)r : INT32_MIN;
+		});
+	}
+	friend scalar_w_int<lane_count> reinterpret(scalar_w_float a) { return scalar_w_int<lane_count>::per_lane([&](u32 l) { return (i32)a.bits(l); }); }
+
+	friend scalar_w_float and_not(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return ~a.bits(l) & b.bits(l); }); }
+
+	friend scalar_w_float operator+(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return a.f[l] + b.f[l]; }); }
+	friend scalar_w_float& operator+=(scalar_w_float& a, scalar_w_float b) { a = a + b; return a; }
+	friend scalar_w_float operator-(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return a.f[l] - b.f[l]; }); }
+	friend scalar_w_float& operator-=(scalar_w_float& a, scalar_w_float b) { a = a - b; return a; }
+	friend scalar_w_float operator*(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return a.f[l] * b.f[l]; }); }
+	friend scalar_w_float& operator*=(scalar_w_float& a, scalar_w_float b) { a = a * b; return a; }
+	friend scalar_w_float operator/(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return a.f[l] / b.f[l]; }); }
+	friend scalar_w_float& operator/=(scalar_w_float& a, scalar_w_float b) { a = a / b; return a; }
+	friend scalar_w_float operator&(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return a.bits(l) & b.bits(l); }); }
+	friend scalar_w_float& operator&=(scalar_w_float& a, scalar_w_float b) { a = a & b; return a; }
+	friend scalar_w_float operator|(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return a.bits(l) | b.bits(l); }); }
+	friend scalar_w_float& operator|=(scalar_w_float& a, scalar_w_float b) { a = a | b; return a; }
+	friend scalar_w_float operator^(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return a.bits(l) ^ b.bits(l); }); }
+	friend scalar_w_float& operator^=(scalar_w_float& a, scalar_w_float b) { a = a ^ b; return a; }
+
+	friend scalar_w_float operator~(scalar_w_float a) { return per_lane_bits([&](u32 l) { return ~a.bits(l); }); }
+
+	friend scalar_w_float operator==(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] == b.f[l]); }); }
+	friend scalar_w_float operator!=(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] != b.f[l]); }); }
+	friend scalar_w_float operator>(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] > b.f[l]); }); }
+	friend scalar_w_float operator>=(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] >= b.f[l]); }); }
+	friend scalar_w_float operator<(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] < b.f[l]); }); }
+	friend scalar_w_float operator<=(scalar_w_float a, scalar_w_float b) { return per_lane_bits([&](u32 l) { return mask_lane(a.f[l] <= b.f[l]); }); }
+
+	friend scalar_w_float operator>>(scalar_w_float a, i32 b) { return reinterpret(reinterpret(a) >> b); }
+	friend scalar_w_float& operator>>=(scalar_w_float& a, i32 b) { a = a >> b; return a; }
+	friend scalar_w_float operator<<(scalar_w_float a, i32 b) { return reinterpret(reinterpret(a) << b); }
+	friend scalar_w_float& operator<<=(scalar_w_float& a, i32 b) { a = a << b; return a; }
+
+	friend scalar_w_float operator-(scalar_w_float a) { return per_lane_bits([&](u32 l) { return a.bits(l) ^ 0x80000000; }); }
+
+	// Pairwise, in the same order as the horizontal adds of the SSE and AVX versions.
+	friend float add_elements(scalar_w_float a)
+	{
+		for (u32 width = lane_count; width > 1; width /= 2)
+		{
+			for (u32 l = 0; l < width / 2; ++l)
+			{
+				a.f[l] = a.f[2 * l] + a.f[2 * l + 1];
+			}
+		}
+		return a.f[0];
+	}
+
+	friend scalar_w_float fmadd(scalar_w_float a, scalar_w_float b, scalar_w_float c) { return per_lane([&](u32 l) { return std::fma(a.f[l], b.f[l], c.f[l]); }); }
+	friend scalar_w_float fmsub(scalar_w_float a, scalar_w_float b, scalar_w_float c) { return per_lane([&](u32 l) { return std::fma(a.f[l], b.f[l], -c.f[l]); }); }
+
+	friend scalar_w_float optimization_barrier(scalar_w_float a)
+	{
+#if defined(__GNUC__)
+		__asm__("" : "+m"(a));
+#endif
+		return a;
+	}
+
+	friend scalar_w_float sqrt(scalar_w_float a) { return per_lane([&](u32 l) { return scalar_sqrt(a.f[l]); }); }
+	friend scalar_w_float rsqrt(scalar_w_float a) { return per_lane([&](u32 l) { return 1.f / std::sqrt(a.f[l]); }); }
+
+	friend scalar_w_float if_then(scalar_w_float cond, scalar_w_float if_case, scalar_w_float else_case) { return per_lane([&](u32 l) { return (cond.bits(l) >> 31) ? if_case.f[l] : else_case.f[l]; }); }
+
+	friend i32 to_bit_mask(scalar_w_float a) { return to_bit_mask(reinterpret(a)); }
+
+	friend u32 compress_store(float* dst, scalar_w_float value, i32 bit_mask) { u32 count = 0; for (u32 l = 0; l < lane_count; ++l) { if ((bit_mask >> l) & 1) { dst[count++] = value.f[l]; } } return count; }
+
+	friend bool all_true(scalar_w_float a) { return all_true(reinterpret(a)); }
+	friend bool all_false(scalar_w_float a) { return all_false(reinterpret(a)); }
+	friend bool any_true(scalar_w_float a) { return any_true(reinterpret(a)); }
+	friend bool any_false(scalar_w_float a) { return any_false(reinterpret(a)); }
+
+	friend scalar_w_float abs(scalar_w_float a) { return per_lane_bits([&](u32 l) { return a.bits(l) & 0x7FFFFFFF; }); }
+	// With fast math, GCC's vectorized floor without SSE4.1 turns -0 into +0. floor never changes the sign.
+	friend scalar_w_float floor(scalar_w_float a) { return per_lane([&](u32 l) { return std::copysign(std::floor(a.f[l]), a.f[l]); }); }
+	friend scalar_w_float round(scalar_w_float a) { return per_lane([&](u32 l) { return std::nearbyint(a.f[l]); }); }
+	friend scalar_w_float minimum(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return (a.f[l] < b.f[l]) ? a.f[l] : b.f[l]; }); }
+	friend scalar_w_float maximum(scalar_w_float a, scalar_w_float b) { return per_lane([&](u32 l) { return (a.f[l] > b.f[l]) ? a.f[l] : b.f[l]; }); }
+
+	friend scalar_w_float lerp(scalar_w_float l, scalar_w_float u, scalar_w_float t) { return fmadd(t, u - l, l); }
+	friend scalar_w_float inverse_lerp(scalar_w_float l, scalar_w_float u, scalar_w_float v) { return (v - l) / (u - l); }
+	friend scalar_w_float remap(scalar_w_float v, scalar_w_float oldL, scalar_w_float oldU, scalar_w_float newL, scalar_w_float newU) { return lerp(newL, newU, inverse_lerp(oldL, oldU, v)); }
+	friend scalar_w_float clamp(scalar_w_float v, scalar_w_float l, scalar_w_float u) { return minimum(u, maximum(l, v)); }
+	friend scalar_w_float clamp01(scalar_w_float v) { return clamp(v, 0.f, 1.f); }
+
+	friend scalar_w_float sign_of(scalar_w_float f) { scalar_w_float z = zero(); return if_then(f < z, scalar_w_float(-1), if_then(f == z, z, scalar_w_float(1))); }
+	friend scalar_w_float signbit(scalar_w_float f) { return (f & -0.f) >> 31; }
+};
+
+// Transposes the square matrix whose rows are the arguments.
+template <u32 lane_count, typename... T, typename = std::enable_if_t<sizeof...(T) + 1 == lane_count>>
+static void transpose(scalar_w_float<lane_count>& row0, T&... rows)
+{
+	scalar_w_float<lane_count>* r[] = { &row0, &rows... };
+	for (u32 i = 0; i < lane_count; ++i)
+	{
+		for (u32 j = i + 1; j < lane_count; ++j)
+		{
+			std::swap(r[i]->f[j], r[j]->f[i]);
+		}
+	}
+}
+
+// Not hidden friends, so that the precision can be given explicitly, e.g. cos<Precision::Accurate>(x).
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> cos(scalar_w_float<lane_count> x) { return cos_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> sin(scalar_w_float<lane_count> x) { return sin_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> exp2(scalar_w_float<lane_count> x) { return exp2_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> log2(scalar_w_float<lane_count> x) { return log2_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> pow(scalar_w_float<lane_count> x, scalar_w_float<lane_count> y) { return pow_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x, y); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> exp(scalar_w_float<lane_count> x) { return exp_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> tanh(scalar_w_float<lane_count> x) { return tanh_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> atan(scalar_w_float<lane_count> x) { return atan_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> atan2(scalar_w_float<lane_count> y, scalar_w_float<lane_count> x) { return atan2_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(y, x); }
+template <Precision precision = Precision::Fast, u32 lane_count> static scalar_w_float<lane_count> acos(scalar_w_float<lane_count> x) { return acos_internal<precision, scalar_w_float<lane_count>, scalar_w_int<lane_count>>(x); }
@@ -0,0 +1,173 @@
+#include "task_graph.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+using TaskGraphClock = std::chrono::high_resolution_clock;
+
+static bool intersects(const std::vector<const void*>& a, const std::vector<const void*>& b)
+{
+	for (const void* x : a)
+	{
+		if (std::find(b.begin(), b.end(), x) != b.end())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskGraph::resolve_dependencies()
+{
+	// Graphs are small, so the quadratic scan is fine.
+	for (u32 i = 0; i < (u32)tasks.size(); ++i)
+	{
+		Task& task = tasks[i];
+		task.dependencies.clear();
+		task.dependents.clear();
+
+		for (u32 j = 0; j < i; ++j)
+		{
+			Task& earlier = tasks[j];
+
+			bool read_after_write = intersects(task.inputs, earlier.outputs);
+			bool write_after_write = intersects(task.outputs, earlier.outputs);
+			bool write_after_read = intersects(task.outputs, earlier.inputs);
+
+			if (read_after_write || write_after_write || write_after_read)
+			{
+				task.dependencies.push_back(j);
+				earlier.dependents.push_back(i);
+			}
+		}
+	}
+}
+
+void TaskGraph::execute()
+{
+	resolve_dependencies();
+
+	u32 task_count = (u32)tasks.size();
+	std::unique_ptr<std::atomic<u32>[]> remaining_dependencies(new std::atomic<u32>[task_count]);
+	for (u32 i = 0; i < task_count; ++i)
+	{
+		remaining_dependencies[i] = (u32)tasks[i].dependencies.size();
+	}
+
+	TaskGraphClock::time_point start = TaskGraphClock::now();
+	JobCounter counter;
+
+	// A finished stage starts its dependents before its own job completes, so the counter can't reach zero early.
+	struct Scheduler
+	{
+		void run(u32 index)
+		{
+			run_job([this, index]()
+			{
+				Task& task = graph->tasks[index];
+
+				task.start_milliseconds = std::chrono::duration<double, std::milli>(TaskGraphClock::now() - start).count();
+				task.function();
+				task.end_milliseconds = std::chrono::duration<double, std::milli>(TaskGraphClock::now() - start).count();
+
+				for (u32 dependent : task.dependents)
+				{
+					if (remaining_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						run(dependent);
+					}
+				}
+			}, counter);
+		}
+
+		TaskGraph* graph;
+		std::atomic<u32>* remaining_dependencies;
+		JobCounter* counter;
+		TaskGraphClock::time_point start;
+	};
+
+	Scheduler scheduler = { this, remaining_dependencies.get(), &counter, start };
+	for (u32 i = 0; i < task_count; ++i)
+	{
+		if (tasks[i].dependencies.empty())
+		{
+			scheduler.run(i);
+		}
+	}
+
+	wait_for_counter(counter);
+
+	total_milliseconds = std::chrono::duration<double, std::milli>(TaskGraphClock::now() - start).count();
+
+	compute_critical_path();
+}
+
+void TaskGraph::compute_critical_path()
+{
+	// Dependencies always point to earlier stages, so insertion order is a topological order.
+	critical_path_end = -1;
+	for (u32 i = 0; i < (u32)tasks.size(); ++i)
+	{
+		Task& task = tasks[i];
+		task.path_milliseconds = 0.0;
+		task.critical_dependency = -1;
+
+		for (u32 dependency : task.dependencies)
+		{
+			if (tasks[dependency].path_milliseconds > task.path_milliseconds)
+			{
+				task.path_milliseconds = tasks[dependency].path_milliseconds;
+				task.critical_dependency = (i32)dependency;
+			}
+		}
+		task.path_milliseconds += task.end_milliseconds - task.start_milliseconds;
+
+		if (critical_path_end < 0 || task.path_milliseconds > tasks[critical_path_end].path_milliseconds)
+		{
+			critical_path_end = (i32)i;
+		}
+	}
+}
+
+double TaskGraph::get_critical_path_milliseconds()
+{
+	return (critical_path_end >= 0) ? tasks[critical_path_end].path_milliseconds : 0.0;
+}
+
+void TaskGraph::print_critical_path()
+{
+	double serial_milliseconds = 0.0;
+	for (const Task& task : tasks)
+	{
+		serial_milliseconds += task.end_milliseconds - task.start_milliseconds;
+	}
+
+	// Formatted separately, so that the precision does not stick to std::cout.
+	std::ostringstream report;
+	report << name << ": " << tasks.size() << " stages, " << std::fixed << std::setprecision(3)
+		<< total_milliseconds << " ms total, " << serial_milliseconds << " ms serial, "
+		<< get_critical_path_milliseconds() << " ms critical path\n";
+
+	// Walk the path backwards, print it forwards.
+	std::vector<u32> path;
+	for (i32 i = critical_path_end; i >= 0; i = tasks[i].critical_dependency)
+	{
+		path.push_back((u32)i);
+	}
+
+	for (auto it = path.rbegin(); it != path.rend(); ++it)
+	{
+		const Task& task = tasks[*it];
+		report << "  " << std::left << std::setw(32) << task.name << std::right
+			<< std::setw(10) << task.start_milliseconds << " ms"
+			<< std::setw(10) << (task.end_milliseconds - task.start_milliseconds) << " ms\n";
+	}
+
+	std::cout << report.str();
+}
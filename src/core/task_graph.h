@@ -0,0 +1,69 @@
+#pragma once
+
+#include "common.h"
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+// A set of stages which declare the data they read (inputs) and write (outputs), identified by address. Stages
+// are ordered like in a single threaded program: a stage runs after every earlier stage which writes one of its
+// inputs or outputs, or which reads one of its outputs. All other stages are independent and run concurrently on
+// the job system.
+//
+// Every stage is timed, so that after execution the graph can report its critical path, i.e. the chain of
+// dependent stages which bounds the total run time no matter how many workers there are.
+struct TaskGraph
+{
+	TaskGraph(const char* name = "Task graph") : name(name) {}
+	TaskGraph(const TaskGraph&) = delete;
+
+	void operator=(const TaskGraph&) = delete;
+
+
+	template <typename F>
+	u32 add_task(const char* task_name, std::initializer_list<const void*> inputs, std::initializer_list<const void*> outputs, F&& f)
+	{
+		Task& task = tasks.emplace_back();
+		task.name = task_name;
+		task.function = std::forward<F>(f);
+		task.inputs = inputs;
+		task.outputs = outputs;
+		return (u32)(tasks.size() - 1);
+	}
+
+	// Runs all stages and returns once the last one has finished. The graph can be executed again.
+	void execute();
+
+	// Valid after execute.
+	double get_critical_path_milliseconds();
+	void print_critical_path();
+
+private:
+	struct Task
+	{
+		const char* name;
+		std::function<void()> function;
+
+		std::vector<const void*> inputs;
+		std::vector<const void*> outputs;
+
+		std::vector<u32> dependencies;
+		std::vector<u32> dependents;
+
+		double start_milliseconds;
+		double end_milliseconds;
+
+		double path_milliseconds;    // Longest chain of dependent stages ending with this one.
+		i32 critical_dependency;     // Dependency on that chain, -1 if none.
+	};
+
+	void resolve_dependencies();
+	void compute_critical_path();
+
+	const char* name;
+	std::vector<Task> tasks;
+
+	double total_milliseconds = 0.0;
+	i32 critical_path_end = -1;
+};
@@ -0,0 +1,376 @@
+#include "tlsf.h"
+
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Every block starts with this header. The free list links overlap the first bytes of the payload, so they are
+// only valid while the block is free. Blocks are laid out back to back in each pool, and each pool ends with a
+// zero sized sentinel block which is never free, so merging stops at pool boundaries.
+struct TLSFAllocator::Block
+{
+	Block* prev_physical;
+	u64 size_and_flags;
+
+	Block* next_free;
+	Block* prev_free;
+
+	static constexpr u64 free_flag = 1;
+	static constexpr u64 header_size = 16;
+	static constexpr u64 min_size = 16; // Room for the free list links.
+
+	u64 size() const { return size_and_flags & ~free_flag; }
+	bool is_free() const { return size_and_flags & free_flag; }
+
+	void set_size(u64 size) { size_and_flags = size | (size_and_flags & free_flag); }
+	void set_free(bool free) { size_and_flags = free ? (size_and_flags | free_flag) : (size_and_flags & ~free_flag); }
+
+	u8* payload() { return (u8*)this + header_size; }
+	Block* next_physical() { return (Block*)(payload() + size()); }
+
+	static Block* from_payload(void* memory) { return (Block*)((u8*)memory - header_size); }
+};
+
+static_assert(TLSFAllocator::alignment >= 16 && (TLSFAllocator::alignment & (TLSFAllocator::alignment - 1)) == 0);
+static_assert(TLSFAllocator::size_bits < 64);
+
+static u32 find_first_set(u32 mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static u32 find_last_set(u64 value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+TLSFAllocator::TLSFAllocator(const char* tag, u64 reserve_address_space, u64 pool_chunk_size)
+	: arena(tag, reserve_address_space), pool_chunk_size(pool_chunk_size)
+{
+}
+
+void TLSFAllocator::get_bin(u64 size, u32& first_level, u32& second_level)
+{
+	if (size < small_block_size)
+	{
+		first_level = 0;
+		second_level = (u32)(size / (small_block_size >> second_level_count_log2));
+	}
+	else
+	{
+		u32 msb = find_last_set(size);
+		second_level = (u32)(size >> (msb - second_level_count_log2)) ^ (1 << second_level_count_log2);
+		first_level = msb - (first_level_shift - 1);
+	}
+}
+
+void TLSFAllocator::add_pool(u8* memory, u64 size)
+{
+	ASSERT((u64)memory % alignment == 0 && size % alignment == 0);
+	ASSERT(size >= 2 * Block::header_size + Block::min_size);
+
+	Block* block = (Block*)memory;
+	block->prev_physical = nullptr;
+	block->size_and_flags = size - 2 * Block::header_size;
+	block->set_free(true);
+
+	Block* sentinel = block->next_physical();
+	sentinel->prev_physical = block;
+	sentinel->size_and_flags = 0;
+
+	insert_free_block(block);
+}
+
+void TLSFAllocator::insert_free_block(Block* block)
+{
+	u32 first_level, second_level;
+	get_bin(block->size(), first_level, second_level);
+	ASSERT(first_level < first_level_count);
+
+	Block* head = free_blocks[first_level][second_level];
+	block->next_free = head;
+	block->prev_free = nullptr;
+	if (head)
+	{
+		head->prev_free = block;
+	}
+	free_blocks[first_level][second_level] = block;
+
+	first_level_bitmap |= 1u << first_level;
+	second_level_bitmaps[first_level] |= 1u << second_level;
+}
+
+void TLSFAllocator::remove_free_block(Block* block)
+{
+	u32 first_level, second_level;
+	get_bin(block->size(), first_level, second_level);
+
+	if (block->prev_free)
+	{
+		block->prev_free->next_free = block->next_free;
+	}
+	else
+	{
+		free_blocks[first_level][second_level] = block->next_free;
+	}
+	if (block->next_free)
+	{
+		block->next_free->prev_free = block->prev_free;
+	}
+
+	if (!free_blocks[first_level][second_level])
+	{
+		second_level_bitmaps[first_level] &= ~(1u << second_level);
+		if (!second_level_bitmaps[first_level])
+		{
+			first_level_bitmap &= ~(1u << first_level);
+		}
+	}
+}
+
+TLSFAllocator::Block* TLSFAllocator::find_free_block(u64 size)
+{
+	// Round the request up to the next bin boundary, so that every block in the bin we find is large enough.
+	if (size >= small_block_size)
+	{
+		size += (1ull << (find_last_set(size) - second_level_count_log2)) - 1;
+	}
+
+	u32 first_level, second_level;
+	get_bin(size, first_level, second_level);
+	if (first_level >= first_level_count)
+	{
+		return nullptr;
+	}
+
+	u32 second_level_map = second_level_bitmaps[first_level] & (~0u << second_level);
+	if (!second_level_map)
+	{
+		u32 first_level_map = (first_level + 1 < 32) ? (first_level_bitmap & (~0u << (first_level + 1))) : 0;
+		if (!first_level_map)
+		{
+			return nullptr;
+		}
+
+		first_level = find_first_set(first_level_map);
+		second_level_map = second_level_bitmaps[first_level];
+	}
+
+	second_level = find_first_set(second_level_map);
+	return free_blocks[first_level][second_level];
+}
+
+void* TLSFAllocator::allocate(u64 size, u64 alignment)
+{
+	ASSERT(alignment <= TLSFAllocator::alignment);
+
+	// The bin lookup rounds sizes up by up to one second level step.
+	if (size >= (1ull << size_bits) - (1ull << (size_bits - 1 - second_level_count_log2)))
+	{
+		return nullptr;
+	}
+
+	size = max(align_to(size, TLSFAllocator::alignment), Block::min_size);
+
+	if (!remote_frees.empty())
+	{
+		free_remote_blocks();
+	}
+
+	Block* block = find_free_block(size);
+	if (!block)
+	{
+		u64 pool_size = max(pool_chunk_size, align_to(size + 2 * Block::header_size + (size >> second_level_count_log2), TLSFAllocator::alignment));
+		u8* memory = (u8*)arena.allocate(pool_size, TLSFAllocator::alignment);
+		if (!memory)
+		{
+			return nullptr;
+		}
+
+		add_pool(memory, pool_size);
+		block = find_free_block(size);
+		ASSERT(block);
+	}
+
+	remove_free_block(block);
+
+	// Split off the remainder if it can hold a block of its own.
+	if (block->size() >= size + Block::header_size + Block::min_size)
+	{
+		Block* remainder = (Block*)(block->payload() + size);
+		remainder->prev_physical = block;
+		remainder->size_and_flags = block->size() - size - Block::header_size;
+		remainder->set_free(true);
+		remainder->next_physical()->prev_physical = remainder;
+
+		block->set_size(size);
+		insert_free_block(remainder);
+	}
+
+	block->set_free(false);
+
+	used_bytes += block->size();
+	++allocation_count;
+
+	return block->payload();
+}
+
+void TLSFAllocator::free(void* memory)
+{
+	if (!memory)
+	{
+		return;
+	}
+
+	Block* block = Block::from_payload(memory);
+	ASSERT(!block->is_free());
+
+	used_bytes -= block->size();
+	--allocation_count;
+
+	Block* prev = block->prev_physical;
+	if (prev && prev->is_free())
+	{
+		remove_free_block(prev);
+		prev->set_size(prev->size() + Block::header_size + block->size());
+		block = prev;
+	}
+
+	Block* next = block->next_physical();
+	if (next->is_free())
+	{
+		remove_free_block(next);
+		block->set_size(block->size() + Block::header_size + next->size());
+	}
+
+	block->set_free(true);
+	block->next_physical()->prev_physical = block;
+
+	insert_free_block(block);
+}
+
+void TLSFAllocator::free_remote(void* memory)
+{
+	if (memory)
+	{
+		// The payload is at least Block::min_size bytes, enough for the link.
+		remote_frees.push(new(memory) RemoteFree);
+	}
+}
+
+void TLSFAllocator::free_remote_blocks()
+{
+	RemoteFree* item = remote_frees.pop_all();
+	while (item)
+	{
+		// Merging may overwrite the link, so read it first.
+		RemoteFree* next = LockFreeStack<RemoteFree>::next(item);
+		free(item);
+		item = next;
+	}
+}
+
+TLSFStats TLSFAllocator::get_stats()
+{
+	free_remote_blocks();
+
+	TLSFStats stats = {};
+	stats.used_bytes = used_bytes;
+	stats.pool_bytes = arena.current;
+	stats.allocation_count = allocation_count;
+
+	for (u32 first_level = 0; first_level < first_level_count; ++first_level)
+	{
+		for (u32 second_level = 0; second_level < second_level_count; ++second_level)
+		{
+			for (Block* block = free_blocks[first_level][second_level]; block; block = block->next_free)
+			{
+				stats.free_bytes += block->size();
+				stats.largest_free_block = max(stats.largest_free_block, block->size());
+			}
+		}
+	}
+
+	return stats;
+}
+
+// Object allocators are never destroyed, since other threads may still free their blocks, and objects with static
+// storage duration may be freed during shutdown. Once its thread exits, an allocator waits here for a new thread.
+struct ObjectAllocatorPool
+{
+	std::mutex mutex;
+	std::vector<TLSFAllocator*> unused;
+};
+
+static ObjectAllocatorPool& get_object_allocator_pool()
+{
+	// Intentionally leaked, so that thread local allocators can still return during shutdown.
+	static ObjectAllocatorPool* pool = new ObjectAllocatorPool;
+	return *pool;
+}
+
+// The object allocator which the current thread owns, if it has one.
+static thread_local TLSFAllocator* owned_object_allocator = nullptr;
+
+struct ThreadObjectAllocator
+{
+	ThreadObjectAllocator()
+	{
+		ObjectAllocatorPool& pool = get_object_allocator_pool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+
+		if (pool.unused.empty())
+		{
+			allocator = new TLSFAllocator("Object allocator");
+		}
+		else
+		{
+			allocator = pool.unused.back();
+			pool.unused.pop_back();
+		}
+		owned_object_allocator = allocator;
+	}
+
+	~ThreadObjectAllocator()
+	{
+		owned_object_allocator = nullptr;
+
+		ObjectAllocatorPool& pool = get_object_allocator_pool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.unused.push_back(allocator);
+	}
+
+	TLSFAllocator* allocator;
+};
+
+TLSFAllocator& get_object_allocator()
+{
+	thread_local ThreadObjectAllocator thread_allocator;
+	return *thread_allocator.allocator;
+}
+
+void free_object_memory(TLSFAllocator& allocator, void* memory)
+{
+	if (&allocator == owned_object_allocator)
+	{
+		allocator.free(memory);
+	}
+	else
+	{
+		allocator.free_remote(memory);
+	}
+}
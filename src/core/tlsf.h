@@ -0,0 +1,118 @@
+#pragma once
+
+#include "memory.h"
+#include "lock_free.h"
+
+#include <memory>
+
+struct TLSFStats
+{
+	u64 used_bytes;       // Payload bytes of all allocated blocks.
+	u64 free_bytes;       // Payload bytes of all free blocks.
+	u64 largest_free_block;
+	u64 pool_bytes;       // Memory taken from the arena.
+	u64 allocation_count;
+};
+
+// Two-level segregated fit allocator (Masmano et al., "TLSF: a new dynamic memory allocator for real-time
+// systems"). Free blocks are binned by size into first_level_count power of two classes, each split linearly into
+// second_level_count subclasses, and two levels of bitmaps find a fitting non-empty bin in constant time. Freeing
+// merges with both physical neighbours immediately, so malloc and free are O(1) and fragmentation is bounded.
+//
+// Memory is carved out of an owned Arena reservation in chunks of at least pool_chunk_size. An allocator belongs to
+// one thread at a time, which calls allocate, free and get_stats without any locking. Other threads return memory
+// with free_remote, which pushes it onto a lock-free stack. The owner merges those blocks on its next allocate.
+struct TLSFAllocator
+{
+	TLSFAllocator(const char* tag = "TLSF", u64 reserve_address_space = GB(4), u64 pool_chunk_size = MB(1));
+	TLSFAllocator(const TLSFAllocator&) = delete;
+
+	void operator=(const TLSFAllocator&) = delete;
+
+
+	// Alignment must not exceed TLSFAllocator::alignment. Returns null for sizes of 2^size_bits and above.
+	void* allocate(u64 size, u64 alignment = TLSFAllocator::alignment);
+	void free(void* memory);
+
+	// Safe on any thread, for memory which another thread allocated.
+	void free_remote(void* memory);
+
+	TLSFStats get_stats();
+
+	static constexpr u64 alignment = 16;
+	static constexpr u32 size_bits = 40; // Blocks are smaller than 2^size_bits bytes.
+
+private:
+	struct Block;
+	struct RemoteFree : LockFreeLink {};
+
+	static void get_bin(u64 size, u32& first_level, u32& second_level);
+
+	void add_pool(u8* memory, u64 size);
+	void free_remote_blocks();
+	void insert_free_block(Block* block);
+	void remove_free_block(Block* block);
+	Block* find_free_block(u64 size);
+
+	static constexpr u32 second_level_count_log2 = 5;
+	static constexpr u32 second_level_count = 1 << second_level_count_log2;
+	static constexpr u32 first_level_shift = second_level_count_log2 + 4; // log2(alignment)
+	static constexpr u32 first_level_count = size_bits - first_level_shift + 1; // Bin 0 holds all small blocks.
+	static constexpr u64 small_block_size = 1ull << first_level_shift;
+
+	Arena arena;
+	u64 pool_chunk_size;
+
+	u32 first_level_bitmap = 0;
+	u32 second_level_bitmaps[first_level_count] = {};
+	Block* free_blocks[first_level_count][second_level_count] = {};
+
+	u64 used_bytes = 0;
+	u64 allocation_count = 0;
+
+	LockFreeStack<RemoteFree> remote_frees;
+};
+
+// Allocator for objects with individual lifetimes, such as the control blocks of shared GPU resources. Every thread
+// gets its own allocator, so allocating never waits for another thread. The allocator of a thread which exits is
+// handed to the next new thread, so its free memory is not lost.
+TLSFAllocator& get_object_allocator();
+
+// Frees memory of any thread's object allocator. On the owning thread, this is a plain free, otherwise a free_remote.
+void free_object_memory(TLSFAllocator& allocator, void* memory);
+
+// Standard library adapter, e.g. for std::allocate_shared.
+template <typename T>
+struct TLSFStdAllocator
+{
+	using value_type = T;
+
+	TLSFStdAllocator(TLSFAllocator& allocator) : allocator(&allocator) {}
+
+	template <typename U>
+	TLSFStdAllocator(const TLSFStdAllocator<U>& o) : allocator(o.allocator) {}
+
+	T* allocate(size_t count)
+	{
+		static_assert(alignof(T) <= TLSFAllocator::alignment);
+		return (T*)allocator->allocate(sizeof(T) * count, alignof(T));
+	}
+
+	void deallocate(T* memory, size_t count)
+	{
+		free_object_memory(*allocator, memory);
+	}
+
+	TLSFAllocator* allocator;
+};
+
+template <typename T, typename U> inline bool operator==(const TLSFStdAllocator<T>& a, const TLSFStdAllocator<U>& b) { return a.allocator == b.allocator; }
+template <typename T, typename U> inline bool operator!=(const TLSFStdAllocator<T>& a, const TLSFStdAllocator<U>& b) { return a.allocator != b.allocator; }
+
+// Like std::make_shared, but object and control block come from the object allocator of the calling thread. The
+// control block remembers the allocator, so the object may be released on any thread.
+template <typename T, typename... Args>
+std::shared_ptr<T> make_object_shared(Args&& ...args)
+{
+	return std::allocate_shared<T>(TLSFStdAllocator<T>(get_object_allocator()), std::forward<Args>(args)...);
+}
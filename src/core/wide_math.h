@@ -0,0 +1,502 @@
+#pragma once
+
+#include <cfloat>
+
+#include "simd.h"
+
+// Structure-of-arrays versions of the vector, quaternion and matrix types in math.h. Every component is a wide float,
+// so e.g. a w8_vec3 holds 8 vectors and every operation works on all of them at once, without shuffling lanes. The
+// types are templated on the lane type (w4_float, w8_float, w16_float); the wN aliases are at the bottom.
+//
+// Comparisons of components give the masks of the lane type, which if_then takes to select whole vectors per lane.
+//
+// Only simd.h is included, so that the kernels in simd_kernels_impl.h can use these types too.
+
+#if defined(SIMD_NAMESPACE)
+namespace SIMD_NAMESPACE {
+#endif
+
+template <typename float_t>
+struct wN_vec2
+{
+	using lane_t = float_t;
+
+	float_t x, y;
+
+	wN_vec2() = default;
+	wN_vec2(float_t v) : x(v), y(v) {}
+	wN_vec2(float_t x, float_t y) : x(x), y(y) {}
+};
+
+template <typename float_t>
+struct wN_vec3
+{
+	using lane_t = float_t;
+
+	float_t x, y, z;
+
+	wN_vec3() = default;
+	wN_vec3(float_t v) : x(v), y(v), z(v) {}
+	wN_vec3(float_t x, float_t y, float_t z) : x(x), y(y), z(z) {}
+	wN_vec3(wN_vec2<float_t> xy, float_t z) : x(xy.x), y(xy.y), z(z) {}
+};
+
+template <typename float_t>
+struct wN_vec4
+{
+	using lane_t = float_t;
+
+	float_t x, y, z, w;
+
+	wN_vec4() = default;
+	wN_vec4(float_t v) : x(v), y(v), z(v), w(v) {}
+	wN_vec4(float_t x, float_t y, float_t z, float_t w) : x(x), y(y), z(z), w(w) {}
+	wN_vec4(wN_vec3<float_t> xyz, float_t w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
+
+	wN_vec3<float_t> xyz() const { return { x, y, z }; }
+};
+
+template <typename float_t>
+struct wN_quat
+{
+	using lane_t = float_t;
+
+	float_t x, y, z, w;
+
+	wN_quat() = default;
+	wN_quat(float_t x, float_t y, float_t z, float_t w) : x(x), y(y), z(z), w(w) {}
+	wN_quat(wN_vec3<float_t> v, float_t w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+	wN_vec3<float_t> v() const { return { x, y, z }; }
+
+	static wN_quat identity() { return { 0.f, 0.f, 0.f, 1.f }; }
+};
+
+// Element mRC is in row R and column C, like in math.h. The member order is irrelevant, since every element is its
+// own register.
+template <typename float_t>
+struct wN_mat3
+{
+	using lane_t = float_t;
+
+	float_t
+		m00, m01, m02,
+		m10, m11, m12,
+		m20, m21, m22;
+
+	wN_mat3() = default;
+	wN_mat3(
+		float_t m00, float_t m01, float_t m02,
+		float_t m10, float_t m11, float_t m12,
+		float_t m20, float_t m21, float_t m22)
+		:
+		m00(m00), m01(m01), m02(m02),
+		m10(m10), m11(m11), m12(m12),
+		m20(m20), m21(m21), m22(m22) {}
+
+	static wN_mat3 identity() { return { 1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f }; }
+};
+
+template <typename float_t>
+struct wN_mat4
+{
+	using lane_t = float_t;
+
+	float_t
+		m00, m01, m02, m03,
+		m10, m11, m12, m13,
+		m20, m21, m22, m23,
+		m30, m31, m32, m33;
+
+	wN_mat4() = default;
+	wN_mat4(
+		float_t m00, float_t m01, float_t m02, float_t m03,
+		float_t m10, float_t m11, float_t m12, float_t m13,
+		float_t m20, float_t m21, float_t m22, float_t m23,
+		float_t m30, float_t m31, float_t m32, float_t m33)
+		:
+		m00(m00), m01(m01), m02(m02), m03(m03),
+		m10(m10), m11(m11), m12(m12), m13(m13),
+		m20(m20), m21(m21), m22(m22), m23(m23),
+		m30(m30), m31(m31), m32(m32), m33(m33) {}
+
+	static wN_mat4 identity() { return { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f }; }
+};
+
+// Axis-aligned boxes, like AABB in math.h. Boxes with a min corner above the max corner are empty.
+template <typename float_t>
+struct wN_AABB
+{
+	using lane_t = float_t;
+
+	wN_vec3<float_t> min_corner, max_corner;
+
+	wN_AABB() = default;
+	wN_AABB(wN_vec3<float_t> min_corner, wN_vec3<float_t> max_corner) : min_corner(min_corner), max_corner(max_corner) {}
+
+	static wN_AABB empty() { return { wN_vec3<float_t>(FLT_MAX), wN_vec3<float_t>(-FLT_MAX) }; }
+};
+
+// Scalar arguments are taken as lane_t, which is not deduced, so that plain floats convert.
+#define WN_LANE(vec_t) typename vec_t<float_t>::lane_t
+
+
+
+// Vec2 operators.
+template <typename float_t> static wN_vec2<float_t> operator+(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { a.x + b.x, a.y + b.y }; }
+template <typename float_t> static wN_vec2<float_t>& operator+=(wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { a = a + b; return a; }
+template <typename float_t> static wN_vec2<float_t> operator-(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { a.x - b.x, a.y - b.y }; }
+template <typename float_t> static wN_vec2<float_t>& operator-=(wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { a = a - b; return a; }
+template <typename float_t> static wN_vec2<float_t> operator*(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { a.x * b.x, a.y * b.y }; }
+template <typename float_t> static wN_vec2<float_t>& operator*=(wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { a = a * b; return a; }
+template <typename float_t> static wN_vec2<float_t> operator/(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { a.x / b.x, a.y / b.y }; }
+template <typename float_t> static wN_vec2<float_t>& operator/=(wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec2<float_t> operator*(const wN_vec2<float_t>& a, WN_LANE(wN_vec2) b) { return { a.x * b, a.y * b }; }
+template <typename float_t> static wN_vec2<float_t> operator*(WN_LANE(wN_vec2) a, const wN_vec2<float_t>& b) { return b * a; }
+template <typename float_t> static wN_vec2<float_t>& operator*=(wN_vec2<float_t>& a, WN_LANE(wN_vec2) b) { a = a * b; return a; }
+template <typename float_t> static wN_vec2<float_t> operator/(const wN_vec2<float_t>& a, WN_LANE(wN_vec2) b) { return { a.x / b, a.y / b }; }
+template <typename float_t> static wN_vec2<float_t>& operator/=(wN_vec2<float_t>& a, WN_LANE(wN_vec2) b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec2<float_t> operator-(const wN_vec2<float_t>& a) { return { -a.x, -a.y }; }
+
+
+// Vec3 operators.
+template <typename float_t> static wN_vec3<float_t> operator+(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+template <typename float_t> static wN_vec3<float_t>& operator+=(wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { a = a + b; return a; }
+template <typename float_t> static wN_vec3<float_t> operator-(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+template <typename float_t> static wN_vec3<float_t>& operator-=(wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { a = a - b; return a; }
+template <typename float_t> static wN_vec3<float_t> operator*(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+template <typename float_t> static wN_vec3<float_t>& operator*=(wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { a = a * b; return a; }
+template <typename float_t> static wN_vec3<float_t> operator/(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { a.x / b.x, a.y / b.y, a.z / b.z }; }
+template <typename float_t> static wN_vec3<float_t>& operator/=(wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec3<float_t> operator*(const wN_vec3<float_t>& a, WN_LANE(wN_vec3) b) { return { a.x * b, a.y * b, a.z * b }; }
+template <typename float_t> static wN_vec3<float_t> operator*(WN_LANE(wN_vec3) a, const wN_vec3<float_t>& b) { return b * a; }
+template <typename float_t> static wN_vec3<float_t>& operator*=(wN_vec3<float_t>& a, WN_LANE(wN_vec3) b) { a = a * b; return a; }
+template <typename float_t> static wN_vec3<float_t> operator/(const wN_vec3<float_t>& a, WN_LANE(wN_vec3) b) { return { a.x / b, a.y / b, a.z / b }; }
+template <typename float_t> static wN_vec3<float_t>& operator/=(wN_vec3<float_t>& a, WN_LANE(wN_vec3) b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec3<float_t> operator-(const wN_vec3<float_t>& a) { return { -a.x, -a.y, -a.z }; }
+
+
+// Vec4 operators.
+template <typename float_t> static wN_vec4<float_t> operator+(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+template <typename float_t> static wN_vec4<float_t>& operator+=(wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { a = a + b; return a; }
+template <typename float_t> static wN_vec4<float_t> operator-(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+template <typename float_t> static wN_vec4<float_t>& operator-=(wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { a = a - b; return a; }
+template <typename float_t> static wN_vec4<float_t> operator*(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+template <typename float_t> static wN_vec4<float_t>& operator*=(wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { a = a * b; return a; }
+template <typename float_t> static wN_vec4<float_t> operator/(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w }; }
+template <typename float_t> static wN_vec4<float_t>& operator/=(wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec4<float_t> operator*(const wN_vec4<float_t>& a, WN_LANE(wN_vec4) b) { return { a.x * b, a.y * b, a.z * b, a.w * b }; }
+template <typename float_t> static wN_vec4<float_t> operator*(WN_LANE(wN_vec4) a, const wN_vec4<float_t>& b) { return b * a; }
+template <typename float_t> static wN_vec4<float_t>& operator*=(wN_vec4<float_t>& a, WN_LANE(wN_vec4) b) { a = a * b; return a; }
+template <typename float_t> static wN_vec4<float_t> operator/(const wN_vec4<float_t>& a, WN_LANE(wN_vec4) b) { return { a.x / b, a.y / b, a.z / b, a.w / b }; }
+template <typename float_t> static wN_vec4<float_t>& operator/=(wN_vec4<float_t>& a, WN_LANE(wN_vec4) b) { a = a / b; return a; }
+
+template <typename float_t> static wN_vec4<float_t> operator-(const wN_vec4<float_t>& a) { return { -a.x, -a.y, -a.z, -a.w }; }
+
+
+template <typename float_t> static float_t dot(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return fmadd(a.x, b.x, a.y * b.y); }
+template <typename float_t> static float_t dot(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return fmadd(a.x, b.x, fmadd(a.y, b.y, a.z * b.z)); }
+template <typename float_t> static float_t dot(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return fmadd(a.x, b.x, fmadd(a.y, b.y, fmadd(a.z, b.z, a.w * b.w))); }
+
+template <typename float_t> static float_t cross(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return fmsub(a.x, b.y, a.y * b.x); }
+template <typename float_t> static wN_vec3<float_t> cross(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { fmsub(a.y, b.z, a.z * b.y), fmsub(a.z, b.x, a.x * b.z), fmsub(a.x, b.y, a.y * b.x) }; }
+
+template <typename float_t> static float_t squared_length(const wN_vec2<float_t>& a) { return dot(a, a); }
+template <typename float_t> static float_t squared_length(const wN_vec3<float_t>& a) { return dot(a, a); }
+template <typename float_t> static float_t squared_length(const wN_vec4<float_t>& a) { return dot(a, a); }
+
+template <typename float_t> static float_t length(const wN_vec2<float_t>& a) { return sqrt(squared_length(a)); }
+template <typename float_t> static float_t length(const wN_vec3<float_t>& a) { return sqrt(squared_length(a)); }
+template <typename float_t> static float_t length(const wN_vec4<float_t>& a) { return sqrt(squared_length(a)); }
+
+template <typename float_t> static wN_vec2<float_t> normalize(const wN_vec2<float_t>& a) { return a * (1.f / length(a)); }
+template <typename float_t> static wN_vec3<float_t> normalize(const wN_vec3<float_t>& a) { return a * (1.f / length(a)); }
+template <typename float_t> static wN_vec4<float_t> normalize(const wN_vec4<float_t>& a) { return a * (1.f / length(a)); }
+
+// Masked select of whole vectors: lanes where cond is set come from if_case. cond is a comparison result of the lane
+// type, like for if_then on the lane type itself.
+template <typename mask_t, typename float_t>
+static wN_vec2<float_t> if_then(mask_t cond, const wN_vec2<float_t>& if_case, const wN_vec2<float_t>& else_case)
+{
+	return { if_then(cond, if_case.x, else_case.x), if_then(cond, if_case.y, else_case.y) };
+}
+
+template <typename mask_t, typename float_t>
+static wN_vec3<float_t> if_then(mask_t cond, const wN_vec3<float_t>& if_case, const wN_vec3<float_t>& else_case)
+{
+	return { if_then(cond, if_case.x, else_case.x), if_then(cond, if_case.y, else_case.y), if_then(cond, if_case.z, else_case.z) };
+}
+
+template <typename mask_t, typename float_t>
+static wN_vec4<float_t> if_then(mask_t cond, const wN_vec4<float_t>& if_case, const wN_vec4<float_t>& else_case)
+{
+	return { if_then(cond, if_case.x, else_case.x), if_then(cond, if_case.y, else_case.y), if_then(cond, if_case.z, else_case.z), if_then(cond, if_case.w, else_case.w) };
+}
+
+template <typename mask_t, typename float_t>
+static wN_quat<float_t> if_then(mask_t cond, const wN_quat<float_t>& if_case, const wN_quat<float_t>& else_case)
+{
+	return { if_then(cond, if_case.x, else_case.x), if_then(cond, if_case.y, else_case.y), if_then(cond, if_case.z, else_case.z), if_then(cond, if_case.w, else_case.w) };
+}
+
+template <typename mask_t, typename float_t>
+static wN_mat3<float_t> if_then(mask_t cond, const wN_mat3<float_t>& if_case, const wN_mat3<float_t>& else_case)
+{
+	wN_mat3<float_t> result;
+	const float_t* a = &if_case.m00;
+	const float_t* b = &else_case.m00;
+	float_t* r = &result.m00;
+	for (u32 i = 0; i < 9; ++i)
+	{
+		r[i] = if_then(cond, a[i], b[i]);
+	}
+	return result;
+}
+
+template <typename mask_t, typename float_t>
+static wN_mat4<float_t> if_then(mask_t cond, const wN_mat4<float_t>& if_case, const wN_mat4<float_t>& else_case)
+{
+	wN_mat4<float_t> result;
+	const float_t* a = &if_case.m00;
+	const float_t* b = &else_case.m00;
+	float_t* r = &result.m00;
+	for (u32 i = 0; i < 16; ++i)
+	{
+		r[i] = if_then(cond, a[i], b[i]);
+	}
+	return result;
+}
+
+// Normalize or zero: lanes shorter than 1e-4 become 0.
+template <typename float_t> static wN_vec2<float_t> noz(const wN_vec2<float_t>& a) { float_t sl = squared_length(a); return if_then(sl < 1e-8f, wN_vec2<float_t>(0.f), a * (1.f / sqrt(sl))); }
+template <typename float_t> static wN_vec3<float_t> noz(const wN_vec3<float_t>& a) { float_t sl = squared_length(a); return if_then(sl < 1e-8f, wN_vec3<float_t>(0.f), a * (1.f / sqrt(sl))); }
+template <typename float_t> static wN_vec4<float_t> noz(const wN_vec4<float_t>& a) { float_t sl = squared_length(a); return if_then(sl < 1e-8f, wN_vec4<float_t>(0.f), a * (1.f / sqrt(sl))); }
+
+template <typename float_t> static wN_vec2<float_t> abs(const wN_vec2<float_t>& a) { return { abs(a.x), abs(a.y) }; }
+template <typename float_t> static wN_vec3<float_t> abs(const wN_vec3<float_t>& a) { return { abs(a.x), abs(a.y), abs(a.z) }; }
+template <typename float_t> static wN_vec4<float_t> abs(const wN_vec4<float_t>& a) { return { abs(a.x), abs(a.y), abs(a.z), abs(a.w) }; }
+
+template <typename float_t> static wN_vec2<float_t> min(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { minimum(a.x, b.x), minimum(a.y, b.y) }; }
+template <typename float_t> static wN_vec3<float_t> min(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { minimum(a.x, b.x), minimum(a.y, b.y), minimum(a.z, b.z) }; }
+template <typename float_t> static wN_vec4<float_t> min(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { minimum(a.x, b.x), minimum(a.y, b.y), minimum(a.z, b.z), minimum(a.w, b.w) }; }
+
+template <typename float_t> static wN_vec2<float_t> max(const wN_vec2<float_t>& a, const wN_vec2<float_t>& b) { return { maximum(a.x, b.x), maximum(a.y, b.y) }; }
+template <typename float_t> static wN_vec3<float_t> max(const wN_vec3<float_t>& a, const wN_vec3<float_t>& b) { return { maximum(a.x, b.x), maximum(a.y, b.y), maximum(a.z, b.z) }; }
+template <typename float_t> static wN_vec4<float_t> max(const wN_vec4<float_t>& a, const wN_vec4<float_t>& b) { return { maximum(a.x, b.x), maximum(a.y, b.y), maximum(a.z, b.z), maximum(a.w, b.w) }; }
+
+template <typename float_t> static wN_vec2<float_t> lerp(const wN_vec2<float_t>& l, const wN_vec2<float_t>& u, WN_LANE(wN_vec2) t) { return l + t * (u - l); }
+template <typename float_t> static wN_vec3<float_t> lerp(const wN_vec3<float_t>& l, const wN_vec3<float_t>& u, WN_LANE(wN_vec3) t) { return l + t * (u - l); }
+template <typename float_t> static wN_vec4<float_t> lerp(const wN_vec4<float_t>& l, const wN_vec4<float_t>& u, WN_LANE(wN_vec4) t) { return l + t * (u - l); }
+
+
+// Quaternion operators.
+template <typename float_t> static float_t dot(const wN_quat<float_t>& a, const wN_quat<float_t>& b) { return fmadd(a.x, b.x, fmadd(a.y, b.y, fmadd(a.z, b.z, a.w * b.w))); }
+template <typename float_t> static wN_quat<float_t> conjugate(const wN_quat<float_t>& q) { return { -q.x, -q.y, -q.z, q.w }; }
+template <typename float_t> static wN_quat<float_t> normalize(const wN_quat<float_t>& q) { float_t s = 1.f / sqrt(dot(q, q)); return { q.x * s, q.y * s, q.z * s, q.w * s }; }
+
+template <typename float_t>
+static wN_quat<float_t> operator*(const wN_quat<float_t>& a, const wN_quat<float_t>& b)
+{
+	wN_vec3<float_t> av = a.v();
+	wN_vec3<float_t> bv = b.v();
+	float_t w = fmsub(a.w, b.w, dot(av, bv));
+	wN_vec3<float_t> v = av * b.w + bv * a.w + cross(av, bv);
+	return { v, w };
+}
+
+// Rotates v by q, which must be normalized. Same result as q * (v, 0) * conjugate(q), with two cross products instead
+// of two quaternion products.
+template <typename float_t>
+static wN_vec3<float_t> operator*(const wN_quat<float_t>& q, const wN_vec3<float_t>& v)
+{
+	wN_vec3<float_t> qv = q.v();
+	wN_vec3<float_t> t = cross(qv, v);
+	t += t;
+	return v + t * q.w + cross(qv, t);
+}
+
+
+// Matrix operators.
+template <typename float_t>
+static wN_vec3<float_t> operator*(const wN_mat3<float_t>& m, const wN_vec3<float_t>& v)
+{
+	return
+	{
+		fmadd(m.m00, v.x, fmadd(m.m01, v.y, m.m02 * v.z)),
+		fmadd(m.m10, v.x, fmadd(m.m11, v.y, m.m12 * v.z)),
+		fmadd(m.m20, v.x, fmadd(m.m21, v.y, m.m22 * v.z)),
+	};
+}
+
+template <typename float_t>
+static wN_vec4<float_t> operator*(const wN_mat4<float_t>& m, const wN_vec4<float_t>& v)
+{
+	return
+	{
+		fmadd(m.m00, v.x, fmadd(m.m01, v.y, fmadd(m.m02, v.z, m.m03 * v.w))),
+		fmadd(m.m10, v.x, fmadd(m.m11, v.y, fmadd(m.m12, v.z, m.m13 * v.w))),
+		fmadd(m.m20, v.x, fmadd(m.m21, v.y, fmadd(m.m22, v.z, m.m23 * v.w))),
+		fmadd(m.m30, v.x, fmadd(m.m31, v.y, fmadd(m.m32, v.z, m.m33 * v.w))),
+	};
+}
+
+template <typename float_t>
+static wN_mat3<float_t> transpose(const wN_mat3<float_t>& m)
+{
+	return
+	{
+		m.m00, m.m10, m.m20,
+		m.m01, m.m11, m.m21,
+		m.m02, m.m12, m.m22,
+	};
+}
+
+template <typename float_t>
+static wN_mat4<float_t> transpose(const wN_mat4<float_t>& m)
+{
+	return
+	{
+		m.m00, m.m10, m.m20, m.m30,
+		m.m01, m.m11, m.m21, m.m31,
+		m.m02, m.m12, m.m22, m.m32,
+		m.m03, m.m13, m.m23, m.m33,
+	};
+}
+
+template <typename float_t>
+static wN_mat3<float_t> quaternion_to_mat3(const wN_quat<float_t>& q)
+{
+	float_t xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float_t xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float_t wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	// The constant is the second operand, since float * w4_float would also match the vec4 operators in math.h.
+	return
+	{
+		1.f - (yy + zz) * 2.f, (xy - wz) * 2.f, (xz + wy) * 2.f,
+		(xy + wz) * 2.f, 1.f - (xx + zz) * 2.f, (yz - wx) * 2.f,
+		(xz - wy) * 2.f, (yz + wx) * 2.f, 1.f - (xx + yy) * 2.f,
+	};
+}
+
+
+// AABB operators. They treat empty boxes like the scalar ones in math.h.
+template <typename float_t> static wN_AABB<float_t> grow(const wN_AABB<float_t>& box, const wN_vec3<float_t>& point) { return { min(point, box.min_corner), max(point, box.max_corner) }; }
+template <typename float_t> static wN_AABB<float_t> box_union(const wN_AABB<float_t>& a, const wN_AABB<float_t>& b) { return { min(a.min_corner, b.min_corner), max(a.max_corner, b.max_corner) }; }
+
+template <typename float_t>
+static float_t surface_area(const wN_AABB<float_t>& box)
+{
+	wN_vec3<float_t> e = max(box.max_corner - box.min_corner, wN_vec3<float_t>(0.f));
+	return fmadd(e.x, e.y, fmadd(e.y, e.z, e.z * e.x)) * 2.f;
+}
+
+template <typename mask_t, typename float_t>
+static wN_AABB<float_t> if_then(mask_t cond, const wN_AABB<float_t>& if_case, const wN_AABB<float_t>& else_case)
+{
+	return { if_then(cond, if_case.min_corner, else_case.min_corner), if_then(cond, if_case.max_corner, else_case.max_corner) };
+}
+
+// Box around the transformed box (Arvo, "Transforming Axis-Aligned Bounding Boxes"), in the center and extent form:
+// the extent goes through the absolute values of the matrix. The halves are taken before subtracting, so that empty
+// boxes keep a finite, negative extent and stay empty.
+template <typename float_t>
+static wN_AABB<float_t> transform_aabb(const wN_mat4<float_t>& m, const wN_AABB<float_t>& box)
+{
+	wN_vec3<float_t> c = box.max_corner * 0.5f + box.min_corner * 0.5f;
+	wN_vec3<float_t> e = box.max_corner * 0.5f - box.min_corner * 0.5f;
+
+	wN_vec3<float_t> center =
+	{
+		fmadd(m.m00, c.x, fmadd(m.m01, c.y, fmadd(m.m02, c.z, m.m03))),
+		fmadd(m.m10, c.x, fmadd(m.m11, c.y, fmadd(m.m12, c.z, m.m13))),
+		fmadd(m.m20, c.x, fmadd(m.m21, c.y, fmadd(m.m22, c.z, m.m23))),
+	};
+	wN_vec3<float_t> extent =
+	{
+		fmadd(abs(m.m00), e.x, fmadd(abs(m.m01), e.y, abs(m.m02) * e.z)),
+		fmadd(abs(m.m10), e.x, fmadd(abs(m.m11), e.y, abs(m.m12) * e.z)),
+		fmadd(abs(m.m20), e.x, fmadd(abs(m.m21), e.y, abs(m.m22) * e.z)),
+	};
+	return { center - extent, center + extent };
+}
+
+// Slab test of one ray against all boxes (Kay and Kajiya), with the ray broadcast to all lanes. inv_direction is
+// 1 / direction, with infinities for zero components. Returns the bit mask of the boxes which the ray overlaps
+// between t_min and t_max, and writes the distances where it enters them to t_entry, which are at least t_min.
+// A slab which gives NaN (0 * infinity, for a ray in the plane of a face) is skipped, since minimum and maximum
+// return their second operand then. Lanes holding wN_AABB::empty(), e.g. to pad a group, are never hit.
+// See the intersect_ray case of the Benchmarks project for speeds.
+template <typename float_t>
+static i32 intersect_ray(const wN_vec3<float_t>& origin, const wN_vec3<float_t>& inv_direction, const wN_AABB<float_t>& boxes,
+	float_t t_min, float_t t_max, float_t& t_entry)
+{
+	wN_vec3<float_t> t0 = (boxes.min_corner - origin) * inv_direction;
+	wN_vec3<float_t> t1 = (boxes.max_corner - origin) * inv_direction;
+
+	float_t near_x = minimum(t0.x, t1.x), near_y = minimum(t0.y, t1.y), near_z = minimum(t0.z, t1.z);
+	float_t far_x = maximum(t0.x, t1.x), far_y = maximum(t0.y, t1.y), far_z = maximum(t0.z, t1.z);
+
+	float_t entry = maximum(near_x, maximum(near_y, maximum(near_z, t_min)));
+	float_t exit = minimum(far_x, minimum(far_y, minimum(far_z, t_max)));
+
+	t_entry = entry;
+	return to_bit_mask(entry <= exit) & to_bit_mask(boxes.min_corner.x <= boxes.max_corner.x);
+}
+
+// Loads lane_count boxes, each stored as six floats (min corner, max corner) like AABB in math.h.
+template <typename float_t>
+static wN_AABB<float_t> load_aabbs(const float* boxes)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	alignas(64) float components[6][lane_count];
+	for (u32 l = 0; l < lane_count; ++l)
+	{
+		for (u32 c = 0; c < 6; ++c)
+		{
+			components[c][l] = boxes[6 * l + c];
+		}
+	}
+	return
+	{
+		wN_vec3<float_t>(float_t(components[0]), float_t(components[1]), float_t(components[2])),
+		wN_vec3<float_t>(float_t(components[3]), float_t(components[4]), float_t(components[5])),
+	};
+}
+
+#undef WN_LANE
+
+
+using w4_vec2 = wN_vec2<w4_float>;
+using w4_vec3 = wN_vec3<w4_float>;
+using w4_vec4 = wN_vec4<w4_float>;
+using w4_quat = wN_quat<w4_float>;
+using w4_mat3 = wN_mat3<w4_float>;
+using w4_mat4 = wN_mat4<w4_float>;
+using w4_AABB = wN_AABB<w4_float>;
+
+using w8_vec2 = wN_vec2<w8_float>;
+using w8_vec3 = wN_vec3<w8_float>;
+using w8_vec4 = wN_vec4<w8_float>;
+using w8_quat = wN_quat<w8_float>;
+using w8_mat3 = wN_mat3<w8_float>;
+using w8_mat4 = wN_mat4<w8_float>;
+using w8_AABB = wN_AABB<w8_float>;
+
+using w16_vec2 = wN_vec2<w16_float>;
+using w16_vec3 = wN_vec3<w16_float>;
+using w16_vec4 = wN_vec4<w16_float>;
+using w16_quat = wN_quat<w16_float>;
+using w16_mat3 = wN_mat3<w16_float>;
+using w16_mat4 = wN_mat4<w16_float>;
+using w16_AABB = wN_AABB<w16_float>;
+
+#if defined(SIMD_NAMESPACE)
+}
+#endif
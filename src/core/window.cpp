@@ -3,7 +3,7 @@
 #include <Windowsx.h>
 
 
-static LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param);
+LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param);
 
 Window::Window(const TCHAR* name, u32 client_width, u32 client_height)
 {
@@ -184,7 +184,7 @@ void Window::set_fullscreen(bool fullscreen)
 
 
 
-static LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param)
+LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param)
 {
 	LRESULT result = 0;
 
@@ -57,5 +57,5 @@ private:
 	MouseMoveCallback mouse_move_callback;
 	MouseScrollCallback mouse_scroll_callback;
 
-	friend static LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param);
+	friend LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l_param);
 };
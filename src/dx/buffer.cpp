@@ -1,5 +1,6 @@
 #include "buffer.h"
 #include "context.h"
+#include "core/tlsf.h"
 
 
 static DXGI_FORMAT get_index_buffer_format(u64 element_size)
@@ -41,7 +42,7 @@ static std::shared_ptr<DXBuffer> allocate_buffer(u64 element_size, u64 element_c
 		resource->SetName(name);
 	}
 
-	std::shared_ptr<DXBuffer> result = std::make_shared<DXBuffer>();
+	std::shared_ptr<DXBuffer> result = make_object_shared<DXBuffer>();
 	result->resource = resource;
 	result->desc = desc;
 	result->element_size = element_size;
@@ -6,7 +6,9 @@
 #include "root_signature.h"
 #include "descriptor_heap.h"
 
-struct DXCommandList
+#include "core/lock_free.h"
+
+struct DXCommandList : LockFreeLink
 {
 	DXCommandList(D3D12_COMMAND_LIST_TYPE type);
 
@@ -54,7 +56,6 @@ struct DXCommandList
 	com<ID3D12CommandAllocator> allocator;
 
 	D3D12_COMMAND_LIST_TYPE type;
-	DXCommandList* next = nullptr;
 	u64 last_fence_value = 0;
 
 private:
@@ -1,6 +1,12 @@
 #include "command_queue.h"
 
 u64 DXCommandQueue::signal()
+{
+	std::lock_guard<std::mutex> lock(submission_mutex);
+	return signal_without_lock();
+}
+
+u64 DXCommandQueue::signal_without_lock()
 {
 	u64 fence_value = next_fence_value++;
 	check_dx(command_queue->Signal(fence.Get(), fence_value));
@@ -43,33 +49,21 @@ void DXCommandQueue::wait_for_list(DXCommandList* list)
 
 u32 DXCommandQueue::get_free_command_lists_count()
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return free_command_lists.count();
-	}
+	return free_command_lists.count();
 }
 
 u32 DXCommandQueue::get_running_command_lists_count()
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return running_command_lists.count();
-	}
+	return running_command_lists.count();
 }
 
 DXCommandList* DXCommandQueue::get_free_command_list()
 {
-	DXCommandList* result;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		result = free_command_lists.pop_front();
-	}
+	DXCommandList* result = free_command_lists.pop();
 
 	if (!result)
 	{
-		std::lock_guard<std::mutex> lock(arena_mutex);
-		result = command_list_arena.construct<DXCommandList>(command_list_type);
+		result = command_list_pool.construct(command_list_type);
 	}
 
 	return result;
@@ -80,16 +74,20 @@ u64 DXCommandQueue::execute_command_list(DXCommandList* cl)
 	check_dx(cl->cl->Close());
 
 	ID3D12CommandList* native_cl = cl->cl.Get();
-	command_queue->ExecuteCommandLists(1, &native_cl);
-
-	cl->last_fence_value = signal();
+	u64 fence_value;
 
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		running_command_lists.push_back(cl);
+		// Submit and signal atomically, so that fence values and running lists stay in submission order.
+		std::lock_guard<std::mutex> lock(submission_mutex);
+		command_queue->ExecuteCommandLists(1, &native_cl);
+
+		fence_value = signal_without_lock();
+		cl->last_fence_value = fence_value;
+
+		running_command_lists.push(cl);
 	}
 
-	return cl->last_fence_value;
+	return fence_value;
 }
 
 void DXCommandQueue::flush()
@@ -100,24 +98,15 @@ void DXCommandQueue::flush()
 
 void DXCommandQueue::add_free_command_list(DXCommandList* cl)
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		free_command_lists.push_front(cl);
-	}
+	free_command_lists.push(cl);
 }
 
 DXCommandList* DXCommandQueue::peek_oldest_running_command_list()
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return running_command_lists.peek_front();
-	}
+	return running_command_lists.peek();
 }
 
 DXCommandList* DXCommandQueue::pop_oldest_running_command_list()
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return running_command_lists.pop_front();
-	}
+	return running_command_lists.pop();
 }
@@ -2,8 +2,9 @@
 
 #include "dx.h"
 #include "command_list.h"
-#include "core/linked_list.h"
+#include "core/lock_free.h"
 #include "core/memory.h"
+#include "core/pool.h"
 
 struct DXCommandQueue
 {
@@ -22,6 +23,7 @@ struct DXCommandQueue
 
 	void flush();
 
+	// Only the command list cleanup thread may peek and pop running lists.
 	void add_free_command_list(DXCommandList* cl);
 	DXCommandList* peek_oldest_running_command_list();
 	DXCommandList* pop_oldest_running_command_list();
@@ -33,11 +35,17 @@ struct DXCommandQueue
 	com<ID3D12Fence> fence;
 	std::atomic<u64> next_fence_value = 0;
 
-	LinkedList<DXCommandList> free_command_lists;
-	LinkedList<DXCommandList> running_command_lists;
+	// Any thread can take free lists and submit. Running lists are only retired by the cleanup thread, so
+	// submitting threads never wait for it.
+	LockFreeStack<DXCommandList> free_command_lists;
+	MPSCQueue<DXCommandList> running_command_lists;
 
-	std::mutex mutex;
+	// Only held by submitting threads, never by the cleanup thread.
+	std::mutex submission_mutex;
 
-	static inline Arena command_list_arena;
-	static inline std::mutex arena_mutex;
+	static inline Arena command_list_arena{ "Command lists" };
+	static inline ConcurrentPool<DXCommandList> command_list_pool{ command_list_arena };
+
+private:
+	u64 signal_without_lock();
 };
@@ -230,11 +230,14 @@ static std::thread create_command_list_cleanup_thread(DXCommandQueue& render_que
 				}
 
 				DXCommandQueue* queue = waiting_queues[event_index];
-				DXCommandList* cl = queue->pop_oldest_running_command_list();
-				ASSERT(cl);
-				cl->reset();
 
-				queue->add_free_command_list(cl);
+				// This can fail while another thread is in the middle of submitting. The list stays in the queue
+				// and is retired in one of the next iterations.
+				if (DXCommandList* cl = queue->pop_oldest_running_command_list())
+				{
+					cl->reset();
+					queue->add_free_command_list(cl);
+				}
 
 				CloseHandle(waiting_events[event_index]);
 			}
@@ -285,6 +288,7 @@ void DXContext::begin_frame()
 	render_graveyard[wrapping_frame_id()].cleanup();
 	copy_graveyard.cleanup();
 	frame_scratch[wrapping_frame_id()].reset();
+	frame_arena.begin_frame(frame_id);
 }
 
 void DXContext::flush()
@@ -7,6 +7,7 @@
 #include "upload_buffer.h"
 
 #include "core/range.h"
+#include "core/frame_arena.h"
 
 struct DXContext
 {
@@ -50,6 +51,9 @@ struct DXContext
 
 	u64 frame_id = UINT64_MAX;
 
+	// CPU memory which stays valid for NUM_BUFFERED_FRAMES frames, like the frame scratch upload buffers.
+	FrameArena<NUM_BUFFERED_FRAMES> frame_arena;
+
 	DXFactory factory;
 	DXAdapter adapter;
 	DXDevice device;
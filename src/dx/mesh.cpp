@@ -1,6 +1,7 @@
 #include "mesh.h"
 #include "raytracing.h"
 #include "core/math.h"
+#include "core/task_graph.h"
 
 #include <numeric>
 
@@ -157,27 +158,37 @@ Mesh MeshBuilder::build()
 	Range<VertexAttribute> vertex_attributes = { (VertexAttribute*)vertex_attribute_arena.memory, vertex_count };
 	Range<IndexedTriangle> triangles = { (IndexedTriangle*)triangle_arena.memory, triangle_count };
 
-	DXVertexBufferGroup vertex_buffer =
+	for (Submesh& submesh : submeshes)
 	{
-		create_buffer(vertex_positions, false, L"Vertex position buffer"),
-		create_buffer(vertex_attributes, false, L"Vertex attribute buffer"),
-	};
+		submesh.bounds = grow(AABB::empty, Range<vec3>(vertex_positions.first + submesh.base_vertex, submesh.vertex_count));
+	}
 
-	DXIndexBuffer index_buffer = create_buffer(triangles.cast<IndexType>(), false, L"Index buffer");
+	Mesh result;
+	result.submeshes = std::make_shared<std::vector<Submesh>>(submeshes.begin(), submeshes.end());
 
-	Mesh result =
-	{
-		vertex_buffer,
-		index_buffer,
-		submeshes,
-	};
+	// The three uploads are independent. Only the BLAS needs all of them.
+	TaskGraph graph("Mesh build");
 
+	graph.add_task("Vertex position buffer", {}, { &result.vertex_buffer.vertex_positions }, [&]()
 	{
-		Arena& temp_arena = vertex_position_arena;
+		result.vertex_buffer.vertex_positions = create_buffer(vertex_positions, false, L"Vertex position buffer");
+	});
+	graph.add_task("Vertex attribute buffer", {}, { &result.vertex_buffer.vertex_attributes }, [&]()
+	{
+		result.vertex_buffer.vertex_attributes = create_buffer(vertex_attributes, false, L"Vertex attribute buffer");
+	});
+	graph.add_task("Index buffer", {}, { &result.index_buffer }, [&]()
+	{
+		result.index_buffer = create_buffer(triangles.cast<IndexType>(), false, L"Index buffer");
+	});
+	graph.add_task("BLAS", { &result.vertex_buffer.vertex_positions, &result.index_buffer, &result.submeshes }, { &result.blas }, [&]()
+	{
+		// Runs on whichever worker picks it up, so it takes that thread's scratch arena.
+		ScratchArena scratch = get_thread_scratch();
+		create_raytracing_blas(result, scratch);
+	});
 
-		ArenaMarker marker(temp_arena);
-		create_raytracing_blas(result, temp_arena);
-	}
+	graph.execute();
 	return result;
 }
 
@@ -196,6 +207,7 @@ std::tuple<Range<vec3>, Range<VertexAttribute>, Range<MeshBuilder::IndexedTriang
 	ASSERT(triangle_arena.current % sizeof(IndexedTriangle) == 0);
 	ASSERT(triangle_arena.current % 16 == 0);
 
+	ASSERT(submeshes.count() < max_submesh_count);
 	Submesh& submesh = submeshes.emplace_back();
 
 	submesh.base_vertex = (u32)(vertex_position_arena.current / sizeof(vec3));
@@ -210,6 +222,18 @@ std::tuple<Range<vec3>, Range<VertexAttribute>, Range<MeshBuilder::IndexedTriang
 	return { vertex_positions, vertex_attributes, triangles };
 }
 
+static_assert(sizeof(VertexAttribute) == vertex_attribute_component_count * sizeof(float), "Vertex attributes must be tightly packed.");
+
+void aos_to_soa(Range<VertexAttribute> aos, float* const soa[vertex_attribute_component_count])
+{
+	aos_to_soa(aos.first, sizeof(VertexAttribute), vertex_attribute_component_count, soa, aos.count);
+}
+
+void soa_to_aos(const float* const soa[vertex_attribute_component_count], Range<VertexAttribute> aos)
+{
+	soa_to_aos(soa, vertex_attribute_component_count, aos.first, sizeof(VertexAttribute), aos.count);
+}
+
 Mesh create_cube_mesh()
 {
 	return MeshBuilder()
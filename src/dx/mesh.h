@@ -6,6 +6,7 @@
 
 #include "core/range.h"
 #include "core/memory.h"
+#include "core/arena_array.h"
 
 struct Submesh
 {
@@ -13,6 +14,9 @@ struct Submesh
 	u32 index_count;
 	u32 base_vertex;
 	u32 vertex_count;
+
+	// Of the vertex positions, in mesh space.
+	AABB bounds;
 };
 
 struct Mesh
@@ -20,7 +24,8 @@ struct Mesh
 	DXVertexBufferGroup vertex_buffer;
 	DXIndexBuffer index_buffer;
 
-	std::vector<Submesh> submeshes;
+	// Shared between copies of the mesh, like the GPU buffers.
+	std::shared_ptr<std::vector<Submesh>> submeshes;
 
 	DXRaytracingBLAS blas;
 };
@@ -41,6 +46,11 @@ struct VertexAttribute
 	vec2 uv;
 };
 
+// The components of a vertex attribute are the normal (x, y, z) and the uv (u, v). See aos_to_soa in math.h.
+static constexpr u32 vertex_attribute_component_count = 5;
+void aos_to_soa(Range<VertexAttribute> aos, float* const soa[vertex_attribute_component_count]);
+void soa_to_aos(const float* const soa[vertex_attribute_component_count], Range<VertexAttribute> aos);
+
 
 
 
@@ -50,8 +60,9 @@ struct MeshBuilder
 	using IndexType = decltype(IndexedTriangle::a);
 
 	// You can call multiple of these functions on a single mesh builder. All meshes will be 
-	// merged into a single vertex and index buffer. The submeshes vector describes for each 
-	// pushed geometry the offset into the buffers.
+	// merged into a single vertex and index buffer. The submeshes array describes for each 
+	// pushed geometry the offset into the buffers. Building copies them into an array of exactly
+	// their count, which the mesh keeps.
 
 	MeshBuilder& push_cube_geometry(vec3 center, vec3 radius);
 	MeshBuilder& push_sphere_geometry(vec3 center, float radius);
@@ -62,11 +73,12 @@ struct MeshBuilder
 private:
 	std::tuple<Range<vec3>, Range<VertexAttribute>, Range<IndexedTriangle>> begin_primitive(u64 vertex_count, u64 triangle_count);
 
-	Arena vertex_position_arena;
-	Arena vertex_attribute_arena;
-	Arena triangle_arena;
+	Arena vertex_position_arena{ "Mesh builder vertex positions" };
+	Arena vertex_attribute_arena{ "Mesh builder vertex attributes" };
+	Arena triangle_arena{ "Mesh builder triangles" };
 
-	std::vector<Submesh> submeshes;
+	static constexpr u64 max_submesh_count = 1024;
+	ArenaArray<Submesh> submeshes{ "Mesh builder submeshes", max_submesh_count };
 };
 
 
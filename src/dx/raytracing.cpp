@@ -9,9 +9,9 @@ void create_raytracing_blas(Mesh& mesh, Arena& arena)
 {
 	ArenaMarker marker(arena);
 
-	Range<D3D12_RAYTRACING_GEOMETRY_DESC> descs = arena.allocate_range<D3D12_RAYTRACING_GEOMETRY_DESC>(mesh.submeshes.size());
+	Range<D3D12_RAYTRACING_GEOMETRY_DESC> descs = arena.allocate_range<D3D12_RAYTRACING_GEOMETRY_DESC>(mesh.submeshes->size());
 
-	for (auto [submesh, index] : Range(mesh.submeshes))
+	for (auto [submesh, index] : Range(*mesh.submeshes))
 	{
 		D3D12_RAYTRACING_GEOMETRY_DESC& desc = descs[index];
 
@@ -65,15 +65,13 @@ void create_raytracing_blas(Mesh& mesh, Arena& arena)
 	mesh.blas.blas = blas;
 }
 
-D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracingBLAS& blas, const Transform& transform, u32 instance_contribution_to_hitgroup_index)
+D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracingBLAS& blas, u32 instance_contribution_to_hitgroup_index)
 {
 	D3D12_RAYTRACING_INSTANCE_DESC instance;
 
 	instance.Flags = 0;// D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE;
 	instance.InstanceContributionToHitGroupIndex = instance_contribution_to_hitgroup_index;
 
-	mat4 m = transpose(transform_to_mat4(transform));
-	memcpy(instance.Transform, &m, sizeof(instance.Transform));
 	instance.AccelerationStructure = blas.blas->virtual_address();
 	instance.InstanceMask = 0xFF;
 	instance.InstanceID = 0; // This value will be exposed to the shader via InstanceID().
@@ -81,6 +79,20 @@ D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracin
 	return instance;
 }
 
+D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracingBLAS& blas, const Transform& transform, u32 instance_contribution_to_hitgroup_index)
+{
+	D3D12_RAYTRACING_INSTANCE_DESC instance = create_raytracing_instance_desc(blas, instance_contribution_to_hitgroup_index);
+	set_raytracing_instance_transforms(Range<D3D12_RAYTRACING_INSTANCE_DESC>(&instance, 1), &transform, sizeof(Transform));
+	return instance;
+}
+
+void set_raytracing_instance_transforms(Range<D3D12_RAYTRACING_INSTANCE_DESC> instances, const Transform* transforms, u64 transform_stride_in_bytes)
+{
+	// The instance transforms are the top three rows of the model matrices, row-major.
+	static_assert(sizeof(D3D12_RAYTRACING_INSTANCE_DESC::Transform) == 12 * sizeof(float));
+	transforms_to_rows_3x4(transforms, transform_stride_in_bytes, &instances.first->Transform[0][0], sizeof(D3D12_RAYTRACING_INSTANCE_DESC), instances.count);
+}
+
 void create_raytracing_tlas(DXRaytracingTLAS& tlas, Range<D3D12_RAYTRACING_INSTANCE_DESC> instances)
 {
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
@@ -165,7 +177,7 @@ DXRaytracingPipelineBuilder& DXRaytracingPipelineBuilder::raygen(const wchar* en
 
 DXRaytracingPipelineBuilder& DXRaytracingPipelineBuilder::hitgroup(const wchar* group_name, const wchar* miss, const wchar* closest_hit, const wchar* any_hit, D3D12_ROOT_SIGNATURE_DESC root_signature_desc)
 {
-	HitGroup* hitgroup = arena.allocate<HitGroup>(1);
+	HitGroup* hitgroup = scratch.arena.allocate<HitGroup>(1);
 	hitgroup->group_name = group_name;
 	hitgroup->miss = miss;
 	hitgroup->closest_hit = closest_hit;
@@ -180,7 +192,7 @@ DXRaytracingPipelineBuilder& DXRaytracingPipelineBuilder::hitgroup(const wchar*
 
 DXRaytracingPipelineBuilder& DXRaytracingPipelineBuilder::define(const wchar* label, u32 number)
 {
-	DXShaderDefine* define = arena.allocate<DXShaderDefine>(1);
+	DXShaderDefine* define = scratch.arena.allocate<DXShaderDefine>(1);
 	define->define = label;
 	define->number = number;
 
@@ -280,6 +292,7 @@ static com<IDxcBlob> compile_library(const std::filesystem::path& filename, Rang
 
 DXRaytracingPipeline DXRaytracingPipelineBuilder::build()
 {
+	Arena& arena = scratch.arena;
 	ArenaMarker marker(arena);
 
 	u32 hitgroup_count = hitgroup_descs.count();
@@ -415,15 +428,15 @@ DXRaytracingPipeline DXRaytracingPipelineBuilder::build()
 
 		next(miss_entry_points) = hitgroup_desc->miss;
 
-		next(defines) = { 0, hitgroup_desc->group_name, hitgroup_index };
+		next(defines) = { 0, 0, hitgroup_desc->group_name, hitgroup_index };
 
 		table_entry_size = max(table_entry_size, get_shader_binding_table_desc_size(hitgroup_desc->root_signature_desc));
 
 		++hitgroup_index;
 	}
 
-	next(defines) = { 0, L"HITGROUP_COUNT", hitgroup_count };
-	next(defines) = { 0, L"MAX_RECURSION_DEPTH", max_recursion_depth };
+	next(defines) = { 0, 0, L"HITGROUP_COUNT", hitgroup_count };
+	next(defines) = { 0, 0, L"MAX_RECURSION_DEPTH", max_recursion_depth };
 
 	for (DXShaderDefine* user_define = user_defines.first; user_define; user_define = user_define->next)
 	{
@@ -26,6 +26,11 @@ struct DXRaytracingTLAS
 void create_raytracing_blas(Mesh& mesh, Arena& arena);
 
 D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracingBLAS& blas, const Transform& transform, u32 instance_contribution_to_hitgroup_index);
+
+// Same without the transform, which set_raytracing_instance_transforms then writes for many instances at once.
+// transforms[i] is transform_stride_in_bytes * i bytes after transforms, so these can be fields of larger structures.
+D3D12_RAYTRACING_INSTANCE_DESC create_raytracing_instance_desc(const DXRaytracingBLAS& blas, u32 instance_contribution_to_hitgroup_index);
+void set_raytracing_instance_transforms(Range<D3D12_RAYTRACING_INSTANCE_DESC> instances, const Transform* transforms, u64 transform_stride_in_bytes);
 void create_raytracing_tlas(DXRaytracingTLAS& tlas, Range<D3D12_RAYTRACING_INSTANCE_DESC> instances);
 
 
@@ -56,6 +61,7 @@ struct DXRaytracingPipeline
 struct DXShaderDefine
 {
 	DXShaderDefine* next;
+	DXShaderDefine* prev;
 
 	const wchar* define;
 	u32 number;
@@ -64,7 +70,7 @@ struct DXShaderDefine
 struct DXRaytracingPipelineBuilder
 {
 	DXRaytracingPipelineBuilder(const std::filesystem::path& shader_filename, u32 payload_size, u32 max_recursion_depth)
-		: shader_filename(shader_filename), payload_size(payload_size), max_recursion_depth(max_recursion_depth)
+		: shader_filename(shader_filename), payload_size(payload_size), max_recursion_depth(max_recursion_depth), scratch(get_thread_scratch())
 	{}
 
 	DXRaytracingPipelineBuilder& global_root_signature(D3D12_ROOT_SIGNATURE_DESC root_signature_desc);
@@ -96,6 +102,7 @@ private:
 	struct HitGroup
 	{
 		HitGroup* next;
+		HitGroup* prev;
 
 		const wchar* group_name; 
 		const wchar* miss; 
@@ -118,10 +125,10 @@ private:
 	D3D12_ROOT_SIGNATURE_DESC global_root_signature_desc;
 
 	RayGen raygen_desc;
-	LinkedList<HitGroup> hitgroup_descs;
-	LinkedList<DXShaderDefine> user_defines;
+	DoublyLinkedList<HitGroup> hitgroup_descs;
+	DoublyLinkedList<DXShaderDefine> user_defines;
 
-	Arena arena;
+	ScratchArena scratch;
 };
 
 
@@ -135,7 +142,9 @@ struct DXRaytracingBindingTable
 template <typename ShaderData>
 struct DXRaytracingBindingTableBuilder
 {
-	DXRaytracingBindingTableBuilder(const DXRaytracingBindingTableDesc& desc);
+	// The binding table is assembled in a scratch arena of the calling thread. Pass any scratch arena the
+	// caller allocates from while the builder is alive as conflict.
+	DXRaytracingBindingTableBuilder(const DXRaytracingBindingTableDesc& desc, Arena* conflict = nullptr);
 
 	void push(Range<ShaderData> data_for_all_hitgroups);
 
@@ -152,19 +161,25 @@ private:
 	DXRaytracingBindingTableDesc binding_table_desc;
 	u32 entry_count = 0;
 
-	Arena arena;
+	ScratchArena scratch;
+	u64 table_begin;
 };
 
 template<typename ShaderData>
-inline DXRaytracingBindingTableBuilder<ShaderData>::DXRaytracingBindingTableBuilder(const DXRaytracingBindingTableDesc& desc) 
-	: binding_table_desc(desc)
+inline DXRaytracingBindingTableBuilder<ShaderData>::DXRaytracingBindingTableBuilder(const DXRaytracingBindingTableDesc& desc, Arena* conflict) 
+	: binding_table_desc(desc), scratch(get_thread_scratch(conflict))
 {
-	ASSERT(arena.current == desc.raygen_offset);
+	Arena& arena = scratch.arena;
+
+	arena.align_next_to(D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+	table_begin = arena.current;
+
+	ASSERT(arena.current - table_begin == desc.raygen_offset);
 	BindingTableEntry* raygen_entry = arena.allocate<BindingTableEntry>(1);
 	memcpy(raygen_entry->identifier, desc.raygen, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
 
 	arena.align_next_to(D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
-	ASSERT(arena.current == desc.miss_offset);
+	ASSERT(arena.current - table_begin == desc.miss_offset);
 
 	for (u32 i = 0; i < desc.hitgroup_count; ++i)
 	{
@@ -173,7 +188,7 @@ inline DXRaytracingBindingTableBuilder<ShaderData>::DXRaytracingBindingTableBuil
 	}
 
 	arena.align_next_to(D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
-	ASSERT(arena.current == desc.hit_offset);
+	ASSERT(arena.current - table_begin == desc.hit_offset);
 }
 
 template<typename ShaderData>
@@ -183,7 +198,7 @@ inline void DXRaytracingBindingTableBuilder<ShaderData>::push(Range<ShaderData>
 
 	for (auto [shader_data, index] : data_for_all_hitgroups)
 	{
-		BindingTableEntry* hitgroup_entry = arena.allocate<BindingTableEntry>(1);
+		BindingTableEntry* hitgroup_entry = scratch.arena.allocate<BindingTableEntry>(1);
 		memcpy(hitgroup_entry->identifier, binding_table_desc.hitgroups[index], D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
 		hitgroup_entry->shader_data = shader_data;
 	}
@@ -194,9 +209,10 @@ inline void DXRaytracingBindingTableBuilder<ShaderData>::push(Range<ShaderData>
 template<typename ShaderData>
 inline DXRaytracingBindingTable DXRaytracingBindingTableBuilder<ShaderData>::build()
 {
-	ASSERT(arena.current > 0);
+	Arena& arena = scratch.arena;
+	ASSERT(arena.current > table_begin);
 
-	std::shared_ptr<DXBuffer> buffer = create_buffer(arena.memory, arena.current, 1, false, L"Raytracing binding table");
+	std::shared_ptr<DXBuffer> buffer = create_buffer(arena.memory + table_begin, arena.current - table_begin, 1, false, L"Raytracing binding table");
 	return DXRaytracingBindingTable{ buffer, entry_count };
 }
 
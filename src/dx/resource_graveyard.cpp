@@ -2,38 +2,39 @@
 
 void ResourceGraveyard::add_resource(u64 fence_value, DXResource resource)
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	ResourceGrave* grave = free_graves.pop_front();
-
-	if (!grave)
-	{
-		grave = arena.allocate<ResourceGrave>(1);
-	}
+	ResourceGrave* grave = grave_pool.construct();
 
 	grave->fence_value = fence_value;
 	grave->resource = resource;
 
-	full_graves.push_back(grave);
+	new_graves.push(grave);
 }
 
 void ResourceGraveyard::cleanup()
 {
-	std::lock_guard<std::mutex> lock(mutex);
+	// New graves come in newest first. Pushing each to the front restores the order in which they were added.
+	DoublyLinkedList<ResourceGrave> added_graves;
+	for (ResourceGrave* grave = new_graves.pop_all(); grave; )
+	{
+		ResourceGrave* next = LockFreeStack<ResourceGrave>::next(grave);
+		added_graves.push_front(grave);
+		grave = next;
+	}
+	full_graves.splice_back(added_graves);
 
-	ResourceGrave* before = nullptr;
-	for (ResourceGrave* grave = full_graves.first; grave; grave = grave->next)
+	ResourceGrave* grave = full_graves.first;
+	while (grave)
 	{
+		// Read the successor before the grave is handed back to the pool, which reuses its memory.
+		ResourceGrave* next = grave->next;
+
 		if (queue->is_fence_complete(grave->fence_value))
 		{
 			//std::cout << "Releasing resource\n";
-			grave->resource.Reset();
-
-			full_graves.remove(grave, before);
-			free_graves.push_back(grave);
+			full_graves.remove(grave);
+			grave_pool.destroy(grave);
 		}
 
-		before = grave;
+		grave = next;
 	}
 }
-
-
@@ -2,10 +2,14 @@
 
 #include "command_queue.h"
 #include "descriptor_heap.h"
+#include "core/pool.h"
+#include "core/linked_list.h"
+#include "core/lock_free.h"
 
-struct ResourceGrave
+struct ResourceGrave : LockFreeLink
 {
 	ResourceGrave* next;
+	ResourceGrave* prev;
 
 	DXResource resource;
 
@@ -14,12 +18,13 @@ struct ResourceGrave
 
 struct ResourceGraveyard
 {
+	// Any thread may add resources. Cleanup must only run on one thread at a time.
 	void add_resource(u64 fence_value, DXResource resource);
 	void cleanup();
 
 	DXCommandQueue* queue;
-	Arena arena;
-	LinkedList<ResourceGrave> free_graves;
-	LinkedList<ResourceGrave> full_graves;
-	std::mutex mutex;
+	Arena arena{ "Resource graveyard" };
+	ConcurrentPool<ResourceGrave> grave_pool{ arena };
+	LockFreeStack<ResourceGrave> new_graves;
+	DoublyLinkedList<ResourceGrave> full_graves; // Only touched by cleanup.
 };
@@ -1,5 +1,6 @@
 #include "texture.h"
 #include "context.h"
+#include "core/tlsf.h"
 
 #include <cmath>
 
@@ -154,7 +155,7 @@ static std::shared_ptr<DXTexture> allocate_texture(D3D12_RESOURCE_DESC desc, D3D
 
 	desc = resource->GetDesc();
 
-	std::shared_ptr<DXTexture> result = std::make_shared<DXTexture>();
+	std::shared_ptr<DXTexture> result = make_object_shared<DXTexture>();
 	result->resource = resource;
 	result->desc = desc;
 
@@ -2,11 +2,14 @@
 #include "dx/context.h"
 
 #include "core/input.h"
+#include "core/job_system.h"
 
 #include "scene/scene.h"
 
 i32 main(i32 argc, char** argv)
 {
+	initialize_job_system();
+
 	DXWindow window(TEXT("Minimal DX"), 1280, 720);
 	//window.set_vsync(true);
 
@@ -37,5 +40,9 @@ i32 main(i32 argc, char** argv)
 		window.end_frame(fence);
 	}
 
+	shutdown_job_system();
+
+	print_arena_statistics();
+
 	return EXIT_SUCCESS;
 }
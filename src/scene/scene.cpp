@@ -11,8 +11,27 @@ void Scene::push_object(const Mesh& mesh, vec3 color, vec3 position, quat rotati
 
 void Scene::build()
 {
-	build_binding_table();
-	build_tlas();
+	Range<D3D12_RAYTRACING_INSTANCE_DESC> instance_descs = dx_context.frame_arena.allocate_range<D3D12_RAYTRACING_INSTANCE_DESC>(objects.count());
+	Range<u32> instance_contributions_to_hitgroup_index = dx_context.frame_arena.allocate_range<u32>(objects.count());
+
+	// The binding table and the TLAS chains only meet at the objects, which both just read, so they run concurrently.
+	TaskGraph graph("Scene build");
+
+	graph.add_task("Allocate descriptor heap", {}, { &descriptor_heap }, [this]() { allocate_descriptor_heap(); });
+	graph.add_task("Fill binding table", { &objects }, { &descriptor_heap, &binding_table }, [this]() { fill_binding_table(); });
+
+	graph.add_task("Compute hitgroup offsets", { &objects }, { &instance_contributions_to_hitgroup_index },
+		[this, instance_contributions_to_hitgroup_index]() { compute_hitgroup_offsets(instance_contributions_to_hitgroup_index); });
+	graph.add_task("Create instance descriptors", { &objects, &instance_contributions_to_hitgroup_index }, { &instance_descs },
+		[this, instance_descs, instance_contributions_to_hitgroup_index]() { create_instance_descs(instance_descs, instance_contributions_to_hitgroup_index); });
+	graph.add_task("Build TLAS", { &instance_descs }, { &tlas }, [this, instance_descs]() { create_raytracing_tlas(tlas, instance_descs); });
+
+	graph.execute();
+
+	if (print_build_critical_path)
+	{
+		graph.print_critical_path();
+	}
 }
 
 void Scene::update(const Input& input, u32 render_width, u32 render_height, float dt)
@@ -37,28 +56,30 @@ u64 Scene::total_submesh_count()
 	u64 total_submesh_count = 0;
 	for (SceneObject& obj : objects)
 	{
-		total_submesh_count += obj.mesh.submeshes.size();
+		total_submesh_count += obj.mesh.submeshes->size();
 	}
 	return total_submesh_count;
 }
 
-void Scene::build_binding_table()
+void Scene::allocate_descriptor_heap()
 {
-	ArenaMarker marker(temp_arena);
-
-
 	// Allocate descriptor heap and reserve space needed by the renderer
 	descriptor_heap.initialize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true, renderer.total_descriptor_heap_space(total_submesh_count()));
 	descriptor_heap.allocate(renderer.reserved_descriptor_heap_space());
+}
 
+void Scene::fill_binding_table()
+{
+	ScratchArena scratch = get_thread_scratch();
 
 	const DXRaytracingBindingTableDesc& binding_table_desc = renderer.get_pipeline().binding_table_desc;
-	Range<PerObjectRenderResources> data_for_all_hitgroups = temp_arena.allocate_range<PerObjectRenderResources>(binding_table_desc.hitgroup_count);
+	Range<PerObjectRenderResources> data_for_all_hitgroups = scratch.arena.allocate_range<PerObjectRenderResources>(binding_table_desc.hitgroup_count);
 
-	DXRaytracingBindingTableBuilder<PerObjectRenderResources> binding_table_builder(binding_table_desc);
+	// The builder needs its own scratch arena, since it must keep the binding table contiguous.
+	DXRaytracingBindingTableBuilder<PerObjectRenderResources> binding_table_builder(binding_table_desc, &scratch.arena);
 	for (SceneObject& obj : objects)
 	{
-		for (auto submesh : obj.mesh.submeshes)
+		for (auto submesh : *obj.mesh.submeshes)
 		{
 			// Let renderer initialize the required data
 			renderer.setup_hitgroup(data_for_all_hitgroups, descriptor_heap, obj.mesh, submesh, obj.color);
@@ -71,27 +92,34 @@ void Scene::build_binding_table()
 	binding_table = binding_table_builder.build();
 }
 
-void Scene::build_tlas()
+void Scene::compute_hitgroup_offsets(Range<u32> instance_contributions_to_hitgroup_index)
 {
-	ArenaMarker marker(temp_arena);
-
-
 	const DXRaytracingBindingTableDesc& binding_table_desc = renderer.get_pipeline().binding_table_desc;
 
-	Range<D3D12_RAYTRACING_INSTANCE_DESC> instance_descs = temp_arena.allocate_range<D3D12_RAYTRACING_INSTANCE_DESC>(objects.size());
-
 	u32 instance_contribution_to_hitgroup_index = 0;
 
-	for (auto [obj, obj_index] : Range(objects))
+	for (auto [obj, obj_index] : objects.range())
 	{
-		// Instantiate object in TLAS
-		instance_descs[obj_index] = create_raytracing_instance_desc(obj.mesh.blas, obj.transform, instance_contribution_to_hitgroup_index);
+		instance_contributions_to_hitgroup_index[obj_index] = instance_contribution_to_hitgroup_index;
 
 		// Adjust the index to the next object. Since each submesh has an entry for each hitgroup, we need to advance by the product of the two.
-		instance_contribution_to_hitgroup_index += (u32)obj.mesh.submeshes.size() * binding_table_desc.hitgroup_count;
+		instance_contribution_to_hitgroup_index += (u32)obj.mesh.submeshes->size() * binding_table_desc.hitgroup_count;
 	}
+}
 
-	create_raytracing_tlas(tlas, instance_descs);
+void Scene::create_instance_descs(Range<D3D12_RAYTRACING_INSTANCE_DESC> instance_descs, Range<u32> instance_contributions_to_hitgroup_index)
+{
+	// Instantiate objects in TLAS. Only the hitgroup offsets depend on previous objects. The transforms of each chunk
+	// are converted in one batch, straight into the descs.
+	parallel_for_chunks(objects.count(), [&](u64 begin, u64 end)
+	{
+		for (u64 obj_index = begin; obj_index < end; ++obj_index)
+		{
+			instance_descs[obj_index] = create_raytracing_instance_desc(objects[obj_index].mesh.blas, instance_contributions_to_hitgroup_index[obj_index]);
+		}
+		set_raytracing_instance_transforms(Range<D3D12_RAYTRACING_INSTANCE_DESC>(instance_descs.first + begin, end - begin),
+			&objects[begin].transform, sizeof(SceneObject));
+	}, 256);
 }
 
 void Camera::update(const Input& input, u32 viewport_width, u32 viewport_height, float dt)
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "core/memory.h"
+#include "core/arena_array.h"
 #include "core/math.h"
 #include "core/input.h"
+#include "core/job_system.h"
+#include "core/task_graph.h"
 
 #include "renderer.h"
 
@@ -36,16 +39,21 @@ struct Scene
 	void update(const Input& input, u32 render_width, u32 render_height, float dt);
 	std::shared_ptr<DXTexture> render(u32 render_width, u32 render_height);
 
+	// Prints the timed critical path of every build, see TaskGraph::print_critical_path.
+	bool print_build_critical_path = false;
+
 private:
 
 	u64 total_submesh_count();
 
-	void build_binding_table();
-	void build_tlas();
-
-	std::vector<SceneObject> objects;
+	void allocate_descriptor_heap();
+	void fill_binding_table();
+	void compute_hitgroup_offsets(Range<u32> instance_contributions_to_hitgroup_index);
+	void create_instance_descs(Range<D3D12_RAYTRACING_INSTANCE_DESC> instance_descs, Range<u32> instance_contributions_to_hitgroup_index);
 
-	Arena temp_arena;
+	// Only address space is reserved for all of them.
+	static constexpr u64 max_object_count = 1 << 16;
+	ArenaArray<SceneObject> objects{ "Scene objects", max_object_count };
 
 	Renderer renderer;
 
@@ -0,0 +1,52 @@
+#include "simd_tests.h"
+#include "core/cpu_features.h"
+#include "core/simd_kernels.h"
+
+static u32 check_count = 0;
+static u32 failure_count = 0;
+
+void check(bool condition, const std::string& description)
+{
+	++check_count;
+	if (!condition)
+	{
+		++failure_count;
+		std::cerr << "FAILED: " << description << '\n';
+	}
+}
+
+// Runs the tests of every instruction set level which the compiler and the CPU support, and of the scalar
+// implementation. The batched functions in math.h are tested with the kernels of every level. Returns non-zero if
+// any check failed.
+int main()
+{
+	bool (*const level_tests[])() = { run_simd_tests_sse2, run_simd_tests_sse4_1, run_simd_tests_avx2, run_simd_tests_avx512 };
+	static_assert(arraysize(level_tests) == (u32)SimdLevel::Count);
+
+	for (u32 level = 0; level <= (u32)get_cpu_simd_level(); ++level)
+	{
+		u32 failures_before = failure_count;
+		u32 checks_before = check_count;
+
+		if (level_tests[level]())
+		{
+			// The kernels are compiled with the same flags as the tests of their level.
+			check(set_simd_level((SimdLevel)level) == (SimdLevel)level, std::string("Kernels of level ") + get_simd_level_name((SimdLevel)level));
+			run_math_tests();
+
+			std::cout << get_simd_level_name((SimdLevel)level) << ": " << (check_count - checks_before) << " checks, "
+				<< (failure_count - failures_before) << " failed\n";
+		}
+		else
+		{
+			std::cout << get_simd_level_name((SimdLevel)level) << ": not compiled\n";
+		}
+	}
+
+	u32 failures_before = failure_count;
+	u32 checks_before = check_count;
+	run_simd_tests_scalar();
+	std::cout << "Scalar: " << (check_count - checks_before) << " checks, " << (failure_count - failures_before) << " failed\n";
+
+	return (failure_count == 0) ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+// Tests of the batched functions in math.h against their scalar versions. These run on the kernels of the current
+// level, see set_simd_level in simd_kernels.h.
+
+#include "simd_tests.h"
+#include "core/half.h"
+#include "core/math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Every component count up to that of a transform, with tight and padded strides, element counts around the width
+// of every level and a large one, and unaligned arrays. soa_to_aos must not touch the floats between the elements,
+// and neither direction may write past the end.
+static void test_aos_to_soa()
+{
+	const float untouched = -12345.f;
+
+	for (u32 component_count = 1; component_count <= transform_component_count; ++component_count)
+	{
+		for (u32 padding : { 0, 1, 3 })
+		{
+			u64 stride = component_count + padding;
+			u64 failed_count = UINT64_MAX;
+
+			for (u64 count = 0; count <= 1000 + 7; count += (count < 40) ? 1 : 1000 + 7 - 40)
+			{
+				// One float in front of both, so that neither is aligned.
+				std::vector<float> aos_memory(count * stride + 2, untouched);
+				std::vector<float> soa_memory(component_count * (count + 2), untouched);
+				float* aos = aos_memory.data() + 1;
+				float* soa[transform_component_count];
+				for (u32 c = 0; c < component_count; ++c)
+				{
+					soa[c] = soa_memory.data() + c * (count + 2) + 1;
+				}
+
+				for (u64 i = 0; i < count; ++i)
+				{
+					for (u32 c = 0; c < component_count; ++c)
+					{
+						aos[i * stride + c] = (float)(i * component_count + c);
+					}
+				}
+
+				bool correct = true;
+				aos_to_soa(aos, stride * sizeof(float), component_count, soa, count);
+				for (u32 c = 0; c < component_count; ++c)
+				{
+					for (u64 i = 0; i < count; ++i)
+					{
+						correct &= (soa[c][i] == (float)(i * component_count + c));
+					}
+					correct &= (soa[c][-1] == untouched && soa[c][count] == untouched);
+				}
+
+				std::fill(aos_memory.begin(), aos_memory.end(), untouched);
+				soa_to_aos(soa, component_count, aos, stride * sizeof(float), count);
+				for (u64 i = 0; i < count; ++i)
+				{
+					for (u32 c = 0; c < stride; ++c)
+					{
+						correct &= (aos[i * stride + c] == ((c < component_count) ? (float)(i * component_count + c) : untouched));
+					}
+				}
+				correct &= (aos[-1] == untouched && aos[count * stride] == untouched);
+
+				if (!correct && failed_count == UINT64_MAX)
+				{
+					failed_count = count;
+				}
+			}
+
+			check(failed_count == UINT64_MAX, "aos_to_soa and soa_to_aos with " + std::to_string(component_count) + " components, stride "
+				+ std::to_string(stride) + ((failed_count == UINT64_MAX) ? std::string() : ", wrong for " + std::to_string(failed_count) + " elements"));
+		}
+	}
+}
+
+// The batched conversions against half, for every half, for every float exponent and sign with the mantissa bits
+// which decide the rounding of normal halves (exact, just below, at and just above halfway), and for random floats.
+// The AVX2 and AVX-512 kernels convert with F16C, so this also checks that the software path gives the same bits.
+// The arrays are unaligned and their length is odd, for the tails.
+static void test_half_conversion()
+{
+	const u32 half_count = 65536 + 7;
+	std::vector<half> all_halves(half_count + 1);
+	for (u32 h = 0; h < half_count; ++h)
+	{
+		all_halves[h + 1].bits = (u16)h;
+	}
+	std::vector<float> floats(half_count + 1);
+	half_to_float(all_halves.data() + 1, floats.data() + 1, half_count);
+
+	u32 failed_half = UINT32_MAX;
+	for (u32 h = 0; h < half_count && failed_half == UINT32_MAX; ++h)
+	{
+		float expected = (float)all_halves[h + 1];
+		if (memcmp(&floats[h + 1], &expected, sizeof(float)) != 0)
+		{
+			failed_half = (u16)h;
+		}
+	}
+	check(failed_half == UINT32_MAX, "half_to_float" + ((failed_half == UINT32_MAX) ? std::string() : " wrong for half " + std::to_string(failed_half)));
+
+	// Below the normal halves, rounding happens at higher mantissa bits, which the random floats cover.
+	const u32 low_bits[] = { 0x0000, 0x0001, 0x0FFF, 0x1000, 0x1001, 0x1FFF };
+	const u32 random_count = (1 << 20) + 7;
+	std::vector<float> samples(1 + (1 << 19) * arraysize(low_bits) + random_count);
+	u64 f = 1;
+	for (u32 high = 0; high < (1 << 19); ++high)
+	{
+		for (u32 low : low_bits)
+		{
+			u32 bits = (high << 13) | low;
+			memcpy(&samples[f++], &bits, sizeof(float));
+		}
+	}
+	std::mt19937 random(1);
+	for (u32 i = 0; i < random_count; ++i)
+	{
+		u32 bits = (u32)random();
+		memcpy(&samples[f++], &bits, sizeof(float));
+	}
+
+	std::vector<half> halves(samples.size());
+	float_to_half(samples.data() + 1, halves.data() + 1, samples.size() - 1);
+
+	u64 failed_float = UINT64_MAX;
+	for (u64 i = 1; i < samples.size() && failed_float == UINT64_MAX; ++i)
+	{
+		if (halves[i].bits != half(samples[i]).bits)
+		{
+			failed_float = i;
+		}
+	}
+
+	char description[128];
+	if (failed_float == UINT64_MAX)
+	{
+		snprintf(description, sizeof(description), "float_to_half");
+	}
+	else
+	{
+		u32 bits;
+		memcpy(&bits, &samples[failed_float], sizeof(bits));
+		snprintf(description, sizeof(description), "float_to_half wrong for float bits 0x%08X: 0x%04X instead of 0x%04X",
+			bits, halves[failed_float].bits, half(samples[failed_float]).bits);
+	}
+	check(failed_float == UINT64_MAX, description);
+}
+
+// The batched transforms of positions and directions against the single versions, for a mat4, a Transform and a
+// dual_quat, with odd counts for the tails. The kernels may fuse multiplies and adds, and transforms and dual
+// quaternions go through a matrix, so the results may differ by rounding. Transforming in place must give the same
+// bits as into another array.
+static void test_transform_positions()
+{
+	quat rotation = normalize(quat(vec3(0.3f, 1.f, 0.2f), 0.7f));
+	Transform transform(vec3(1.f, 2.f, 3.f), rotation, vec3(2.f, 3.f, 0.5f));
+	mat4 m = transform_to_mat4(transform);
+	dual_quat q(rotation, vec3(-4.f, 0.5f, 7.f));
+
+	auto test = [](const char* name, const auto& t, bool positions)
+	{
+		float max_error = 0.f;
+		bool same_in_place = true;
+
+		for (u64 count = 0; count <= 1000 + 7; count += (count < 40) ? 1 : 1000 + 7 - 40)
+		{
+			std::vector<vec3> input(count), result(count), in_place(count);
+			for (u64 i = 0; i < count; ++i)
+			{
+				input[i] = vec3((float)(i % 1000) - 500.f, (float)(i % 777) * 0.5f, -(float)(i % 313));
+			}
+			in_place = input;
+
+			if (positions)
+			{
+				transform_positions(t, Range<vec3>(input.data(), count), Range<vec3>(result.data(), count));
+				transform_positions(t, Range<vec3>(in_place.data(), count));
+			}
+			else
+			{
+				transform_directions(t, Range<vec3>(input.data(), count), Range<vec3>(result.data(), count));
+				transform_directions(t, Range<vec3>(in_place.data(), count));
+			}
+
+			for (u64 i = 0; i < count; ++i)
+			{
+				vec3 expected = positions ? transform_position(t, input[i]) : transform_direction(t, input[i]);
+				max_error = max(max_error, length(result[i] - expected) / max(length(expected), 1.f));
+			}
+			same_in_place &= (count == 0) || (memcmp(result.data(), in_place.data(), count * sizeof(vec3)) == 0);
+		}
+		char description[128];
+		snprintf(description, sizeof(description), "%s: max relative error %.2e, in place %s", name, max_error, same_in_place ? "the same" : "different");
+		check(max_error < 1e-6f && same_in_place, description);
+	};
+
+	test("transform_positions(mat4)", m, true);
+	test("transform_directions(mat4)", m, false);
+	test("transform_positions(Transform)", transform, true);
+	test("transform_directions(Transform)", transform, false);
+	test("transform_positions(dual_quat)", q, true);
+	test("transform_directions(dual_quat)", q, false);
+}
+
+// Largest difference between the elements of a and b, relative to the largest element of b.
+static float relative_difference(const float* a, const float* b, u32 count)
+{
+	float difference = 0.f, magnitude = 0.f;
+	for (u32 i = 0; i < count; ++i)
+	{
+		difference = max(difference, fabsf(a[i] - b[i]));
+		magnitude = max(magnitude, fabsf(b[i]));
+	}
+	return difference / max(magnitude, 1e-30f);
+}
+
+// The batched matrix functions against the scalar versions, with odd counts for the tails, and with the result in
+// place of an input. The scalar transforms_to_rows_3x4 is transpose(transform_to_mat4(t)), of which the top three
+// rows are copied. Every fourth matrix given to invert is singular.
+static void test_matrices()
+{
+	struct Rows3x4
+	{
+		float m[12];
+		float padding;
+	};
+
+	const float untouched = -12345.f;
+	float max_errors[5] = {};
+	bool in_place_correct = true;
+	bool padding_untouched = true;
+
+	for (u64 count = 0; count <= 100 + 7; count += (count < 40) ? 1 : 100 + 7 - 40)
+	{
+		std::vector<Transform> transforms(count);
+		std::vector<mat4> a(count), b(count), result(count), in_place(count);
+		std::vector<Rows3x4> rows(count);
+		for (u64 i = 0; i < count; ++i)
+		{
+			float f = (float)i;
+			transforms[i] = Transform(vec3(f * 0.1f, 2.f - f * 0.01f, 3.f), normalize(quat(vec3(0.3f + f * 0.001f, 1.f, 0.2f), 0.7f + f)), vec3(1.f + (i % 7) * 0.3f, 2.f, 0.5f));
+			a[i] = transform_to_mat4(transforms[i]);
+			b[i] = transform_to_mat4(Transform(vec3(1.f, -2.f, f), normalize(quat(vec3(1.f, 0.5f, f), 0.3f)), vec3(1.5f)));
+			b[i].m30 = 0.1f;
+			b[i].m31 = 0.2f * (i % 3);
+			for (float& r : rows[i].m)
+			{
+				r = untouched;
+			}
+			rows[i].padding = untouched;
+		}
+
+		auto compare = [&](u32 function, auto&& expected)
+		{
+			for (u64 i = 0; i < count; ++i)
+			{
+				mat4 e = expected(i);
+				max_errors[function] = max(max_errors[function], relative_difference(result[i].m, e.m, 16));
+			}
+		};
+		auto same_in_place = [&]()
+		{
+			return (count == 0) || (memcmp(result.data(), in_place.data(), count * sizeof(mat4)) == 0);
+		};
+
+		multiply(Range<mat4>(a.data(), count), Range<mat4>(b.data(), count), Range<mat4>(result.data(), count));
+		in_place = a;
+		multiply(Range<mat4>(in_place.data(), count), Range<mat4>(b.data(), count), Range<mat4>(in_place.data(), count));
+		compare(0, [&](u64 i) { return a[i] * b[i]; });
+		in_place_correct &= same_in_place();
+
+		if (count > 0)
+		{
+			multiply(a[0], Range<mat4>(b.data(), count), Range<mat4>(result.data(), count));
+			in_place = b;
+			multiply(a[0], Range<mat4>(in_place.data(), count), Range<mat4>(in_place.data(), count));
+			compare(0, [&](u64 i) { return a[0] * b[i]; });
+			in_place_correct &= same_in_place();
+
+			multiply(Range<mat4>(a.data(), count), b[0], Range<mat4>(result.data(), count));
+			in_place = a;
+			multiply(Range<mat4>(in_place.data(), count), b[0], Range<mat4>(in_place.data(), count));
+			compare(0, [&](u64 i) { return a[i] * b[0]; });
+			in_place_correct &= same_in_place();
+		}
+
+		for (u64 i = 3; i < count; i += 4)
+		{
+			b[i].m30 = b[i].m31 = b[i].m32 = b[i].m33 = 0.f;
+		}
+		invert(Range<mat4>(b.data(), count), Range<mat4>(result.data(), count));
+		in_place = b;
+		invert(Range<mat4>(in_place.data(), count), Range<mat4>(in_place.data(), count));
+		compare(1, [&](u64 i) { return (i % 4 == 3) ? mat4::zero : invert(b[i]); });
+		in_place_correct &= same_in_place();
+
+		invert_affine_matrices(Range<mat4>(a.data(), count), Range<mat4>(result.data(), count));
+		in_place = a;
+		invert_affine_matrices(Range<mat4>(in_place.data(), count), Range<mat4>(in_place.data(), count));
+		compare(2, [&](u64 i) { return invert_affine_matrix(a[i]); });
+		in_place_correct &= same_in_place();
+
+		transforms_to_mat4(Range<Transform>(transforms.data(), count), Range<mat4>(result.data(), count));
+		compare(3, [&](u64 i) { return transform_to_mat4(transforms[i]); });
+
+		transforms_to_rows_3x4(transforms.data(), sizeof(Transform), rows.empty() ? nullptr : rows[0].m, sizeof(Rows3x4), count);
+		for (u64 i = 0; i < count; ++i)
+		{
+			mat4 expected = transpose(transform_to_mat4(transforms[i]));
+			max_errors[4] = max(max_errors[4], relative_difference(rows[i].m, expected.m, 12));
+			padding_untouched &= (rows[i].padding == untouched);
+		}
+	}
+
+	// Some of the general matrices have inverses with elements in the hundreds, where the rounding of the
+	// determinant and the cofactors, which depends on their order and on fused multiplies and adds, shows more.
+	const char* names[] = { "multiply", "invert", "invert_affine_matrices", "transforms_to_mat4", "transforms_to_rows_3x4" };
+	const float bounds[] = { 1e-6f, 4e-6f, 1e-6f, 1e-6f, 1e-6f };
+	for (u32 function = 0; function < arraysize(names); ++function)
+	{
+		char description[128];
+		snprintf(description, sizeof(description), "%s: max relative error %.2e", names[function], max_errors[function]);
+		check(max_errors[function] < bounds[function], description);
+	}
+	check(in_place_correct, "Batched matrix functions give the same bits in place");
+	check(padding_untouched, "transforms_to_rows_3x4 leaves the floats between the rows untouched");
+}
+
+// The batched grow against a loop over the single one, which must give the same bits, with odd counts for the tails.
+static void test_aabb_grow()
+{
+	bool correct = true;
+	for (u64 count = 0; count <= 1000 + 7; count += (count < 40) ? 1 : 1000 + 7 - 40)
+	{
+		std::vector<vec3> points(count);
+		for (u64 i = 0; i < count; ++i)
+		{
+			points[i] = vec3(sinf(i * 0.37f) * 100.f, cosf(i * 0.11f) * 50.f, (float)(i % 977) - 400.f);
+		}
+
+		AABB expected = AABB::empty;
+		for (const vec3& point : points)
+		{
+			expected = grow(expected, point);
+		}
+		AABB box = grow(AABB::empty, Range<vec3>(points.data(), count));
+		correct &= (memcmp(&box, &expected, sizeof(AABB)) == 0);
+	}
+	check(correct, "Batched grow of an AABB gives the same bits as the single one");
+}
+
+void run_math_tests()
+{
+	test_aos_to_soa();
+	test_half_conversion();
+	test_transform_positions();
+	test_matrices();
+	test_aabb_grow();
+}
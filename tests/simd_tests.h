@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/common.h"
+
+#include <string>
+
+// Counts the check and prints the description if it failed. Defined in main.cpp.
+void check(bool condition, const std::string& description);
+
+// Runs all tests of simd.h for one instruction set level, see simd_tests_impl.h. Returns false if the compiler does
+// not support that level.
+bool run_simd_tests_sse2();
+bool run_simd_tests_sse4_1();
+bool run_simd_tests_avx2();
+bool run_simd_tests_avx512();
+
+// Runs the same tests with SIMD_SCALAR defined.
+bool run_simd_tests_scalar();
+
+// Runs the tests of the batched functions in math.h with the current kernels, see math_tests.cpp.
+void run_math_tests();
@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx2
+#include "simd_tests_impl.h"
+
+bool run_simd_tests_avx2()
+{
+#if defined(SIMD_AVX_2) && defined(SIMD_FMA)
+	avx2::run_simd_tests();
+	return true;
+#else
+	return false;
+#endif
+}
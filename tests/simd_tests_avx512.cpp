@@ -0,0 +1,12 @@
+#define SIMD_NAMESPACE avx512
+#include "simd_tests_impl.h"
+
+bool run_simd_tests_avx512()
+{
+#if defined(SIMD_AVX_512) && defined(SIMD_FMA)
+	avx512::run_simd_tests();
+	return true;
+#else
+	return false;
+#endif
+}
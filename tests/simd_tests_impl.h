@@ -0,0 +1,632 @@
+// Tests of simd.h, included once by every simd_tests_<level>.cpp. Like simd_kernels_impl.h, these define
+// SIMD_NAMESPACE first and are compiled with the instruction set flags of their level, and with the floating point
+// mode of the project, so that every code path is tested the way it ships.
+
+#if !defined(SIMD_NAMESPACE)
+#error Define SIMD_NAMESPACE before including simd_tests_impl.h.
+#endif
+
+#include "core/random.h"
+#include "core/simd.h"
+#include "simd_tests.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace SIMD_NAMESPACE {
+
+static bool same_bits(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static std::string describe(const char* function, const char* type_name, float x, float result, float expected)
+{
+	return std::string(function) + "(" + type_name + "(" + std::to_string(x) + ")) = " + std::to_string(result) + ", expected " + std::to_string(expected);
+}
+
+// Rounding must not be folded away by fast math, must round halfway cases to even, keep the sign of zero, and leave
+// magnitudes of 2^23 and above alone, which are integral already.
+template <typename float_t>
+static void test_rounding(const char* type_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	const float values[] = { 0.f, -0.f, 0.25f, -0.25f, 0.5f, -0.5f, 0.75f, -0.75f, 1.5f, -1.5f, 2.5f, -2.5f, 2.6f, -2.6f,
+		1000000.5f, -1000000.5f, 8388607.5f, -8388607.5f, 8388608.f, -8388609.f, 16777215.f, 3e9f, -3e9f, 1e30f, -1e30f };
+	constexpr u32 value_count = arraysize(values);
+
+	for (u32 first = 0; first < value_count; first += lane_count)
+	{
+		alignas(64) float x[lane_count];
+		alignas(64) float rounded[lane_count];
+		alignas(64) float floored[lane_count];
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			x[l] = values[(first + l) % value_count];
+		}
+
+		round(float_t(x)).store(rounded);
+		floor(float_t(x)).store(floored);
+
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			// Neither changes the sign, but with fast math std:: may lose it for -0, depending on the optimization level.
+			float expected_rounded = std::copysign(std::nearbyint(x[l]), x[l]);
+			float expected_floored = std::copysign(std::floor(x[l]), x[l]);
+			check(same_bits(rounded[l], expected_rounded), describe("round", type_name, x[l], rounded[l], expected_rounded));
+			check(same_bits(floored[l], expected_floored), describe("floor", type_name, x[l], floored[l], expected_floored));
+		}
+	}
+}
+
+// xorshift64, so that the arguments are the same on every platform.
+struct TestRandom
+{
+	u64 state = 0x9E3779B97F4A7C15ull;
+
+	double uniform(double low, double high)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return low + (high - low) * (double)(state >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	// Uniform in the logarithm, for arguments over many orders of magnitude.
+	double logarithmic(double low, double high)
+	{
+		return std::exp(uniform(std::log(low), std::log(high)));
+	}
+};
+
+enum class ErrorMetric
+{
+	Absolute,
+	Relative,
+	Ulp,
+};
+
+// Distance between adjacent floats at the magnitude of value, that of the smallest normal float for denormals.
+static double ulp_at(double value)
+{
+	float magnitude = ::max((float)std::abs(value), FLT_MIN);
+	return (double)(std::nextafter(magnitude, FLT_MAX) - magnitude);
+}
+
+// Largest error of approximation(x, y) against the double precision reference(x, y) over arguments from
+// generate(random, x, y), which must not exceed bound.
+template <typename float_t, typename Approximation, typename Reference, typename Generate>
+static void test_error_bound(const char* function, const char* type_name, ErrorMetric metric, double bound, Approximation&& approximation, Reference&& reference, Generate&& generate)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	constexpr u32 argument_count = 1 << 16;
+
+	TestRandom random;
+	double max_error = 0.0;
+	float worst_x = 0.f, worst_y = 0.f, worst_result = 0.f;
+
+	for (u32 first = 0; first < argument_count; first += lane_count)
+	{
+		alignas(64) float x[lane_count];
+		alignas(64) float y[lane_count];
+		alignas(64) float result[lane_count];
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			y[l] = 0.f;
+			generate(random, x[l], y[l]);
+		}
+
+		approximation(float_t(x), float_t(y)).store(result);
+
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			double expected = reference((double)x[l], (double)y[l]);
+			double error = std::abs((double)result[l] - expected);
+			if (metric == ErrorMetric::Relative)
+			{
+				error /= std::abs(expected);
+			}
+			else if (metric == ErrorMetric::Ulp)
+			{
+				error /= ulp_at(expected);
+			}
+
+			// Written so that NaN counts as a failure.
+			if (!(error <= max_error))
+			{
+				max_error = error;
+				worst_x = x[l];
+				worst_y = y[l];
+				worst_result = result[l];
+			}
+		}
+	}
+
+	const char* metric_names[] = { "absolute error", "relative error", "ulp" };
+	char description[256];
+	snprintf(description, sizeof(description), "%s on %s: %.3g %s at (%.9g, %.9g) = %.9g, documented bound %.3g",
+		function, type_name, max_error, metric_names[(u32)metric], worst_x, worst_y, worst_result, bound);
+	check(max_error <= bound, description);
+}
+
+// The error bounds documented in simd.h, on the domains of the simd_math benchmark.
+template <typename float_t>
+static void test_precision_tiers(const char* type_name)
+{
+	const double pi = 3.14159265358979323846;
+
+#if defined(SIMD_FMA)
+	const double exp2_accurate_ulp = 0.93;
+	const double exp_accurate_ulp = 1.1;
+#else
+	const double exp2_accurate_ulp = 1.2;
+	const double exp_accurate_ulp = 1.3;
+#endif
+
+	auto within_pi = [=](TestRandom& random, float& x, float&) { x = (float)random.uniform(-pi, pi); };
+	auto within_1000 = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-1000.0, 1000.0); };
+	auto exp2_domain = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-126.0, 127.9); };
+	auto exp2_denormal_results = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-149.0, -126.0); };
+	auto positive_normals = [](TestRandom& random, float& x, float&) { x = (float)random.logarithmic(1e-37, 1e37); };
+	auto positive_denormals = [](TestRandom& random, float& x, float&) { x = (float)random.logarithmic(1e-44, 1e-38); };
+	auto around_1 = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(0.5, 2.0); };
+	auto exp_domain = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-87.0, 88.0); };
+	auto pow_domain = [](TestRandom& random, float& x, float& y) { x = (float)random.logarithmic(1e-2, 1e2); y = (float)random.uniform(-4.0, 4.0); };
+	auto within_10 = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-10.0, 10.0); };
+	auto real_line = [=](TestRandom& random, float& x, float&) { x = (float)std::tan(random.uniform(-pi / 2 + 1e-3, pi / 2 - 1e-3)); };
+	auto within_1 = [](TestRandom& random, float& x, float&) { x = (float)random.uniform(-1.0, 1.0); };
+
+	// x holds the x coordinate, y the y coordinate, at all angles and radii from 1e-3 to 1e3.
+	auto plane = [=](TestRandom& random, float& x, float& y)
+	{
+		double angle = random.uniform(-pi, pi);
+		double radius = random.logarithmic(1e-3, 1e3);
+		x = (float)(radius * std::cos(angle));
+		y = (float)(radius * std::sin(angle));
+	};
+
+	auto cos_reference = [](double x, double) { return std::cos(x); };
+	auto sin_reference = [](double x, double) { return std::sin(x); };
+	auto exp2_reference = [](double x, double) { return std::exp2(x); };
+	auto log2_reference = [](double x, double) { return std::log2(x); };
+	auto exp_reference = [](double x, double) { return std::exp(x); };
+	auto pow_reference = [](double x, double y) { return std::pow(x, y); };
+	auto tanh_reference = [](double x, double) { return std::tanh(x); };
+	auto atan_reference = [](double x, double) { return std::atan(x); };
+	auto atan2_reference = [](double x, double y) { return std::atan2(y, x); };
+	auto acos_reference = [](double x, double) { return std::acos(x); };
+
+	test_error_bound<float_t>("cos<Fast>", type_name, ErrorMetric::Absolute, 1.2e-3, [](float_t x, float_t) { return cos<Precision::Fast>(x); }, cos_reference, within_1000);
+	test_error_bound<float_t>("cos<Balanced>", type_name, ErrorMetric::Absolute, 6.5e-7, [](float_t x, float_t) { return cos<Precision::Balanced>(x); }, cos_reference, within_1000);
+	test_error_bound<float_t>("cos<Accurate>", type_name, ErrorMetric::Absolute, 9.3e-8, [](float_t x, float_t) { return cos<Precision::Accurate>(x); }, cos_reference, within_1000);
+	test_error_bound<float_t>("cos<Accurate>", type_name, ErrorMetric::Ulp, 1.6, [](float_t x, float_t) { return cos<Precision::Accurate>(x); }, cos_reference, within_pi);
+
+	test_error_bound<float_t>("sin<Fast>", type_name, ErrorMetric::Absolute, 1.2e-3, [](float_t x, float_t) { return sin<Precision::Fast>(x); }, sin_reference, within_1000);
+	test_error_bound<float_t>("sin<Balanced>", type_name, ErrorMetric::Absolute, 6.5e-7, [](float_t x, float_t) { return sin<Precision::Balanced>(x); }, sin_reference, within_1000);
+	test_error_bound<float_t>("sin<Accurate>", type_name, ErrorMetric::Absolute, 9.3e-8, [](float_t x, float_t) { return sin<Precision::Accurate>(x); }, sin_reference, within_1000);
+	test_error_bound<float_t>("sin<Accurate>", type_name, ErrorMetric::Ulp, 1.6, [](float_t x, float_t) { return sin<Precision::Accurate>(x); }, sin_reference, within_pi);
+
+	test_error_bound<float_t>("exp2<Fast>", type_name, ErrorMetric::Relative, 7.5e-5, [](float_t x, float_t) { return exp2<Precision::Fast>(x); }, exp2_reference, exp2_domain);
+	test_error_bound<float_t>("exp2<Balanced>", type_name, ErrorMetric::Relative, 2.8e-6, [](float_t x, float_t) { return exp2<Precision::Balanced>(x); }, exp2_reference, exp2_domain);
+	test_error_bound<float_t>("exp2<Accurate>", type_name, ErrorMetric::Ulp, exp2_accurate_ulp, [](float_t x, float_t) { return exp2<Precision::Accurate>(x); }, exp2_reference, exp2_domain);
+	test_error_bound<float_t>("exp2<Accurate>", type_name, ErrorMetric::Ulp, exp2_accurate_ulp, [](float_t x, float_t) { return exp2<Precision::Accurate>(x); }, exp2_reference, exp2_denormal_results);
+
+	test_error_bound<float_t>("log2<Fast>", type_name, ErrorMetric::Absolute, 6.1e-5, [](float_t x, float_t) { return log2<Precision::Fast>(x); }, log2_reference, positive_normals);
+	test_error_bound<float_t>("log2<Balanced>", type_name, ErrorMetric::Absolute, 6.2e-7, [](float_t x, float_t) { return log2<Precision::Balanced>(x); }, log2_reference, around_1);
+	test_error_bound<float_t>("log2<Balanced>", type_name, ErrorMetric::Relative, 1.3e-6, [](float_t x, float_t) { return log2<Precision::Balanced>(x); }, log2_reference, positive_normals);
+	test_error_bound<float_t>("log2<Accurate>", type_name, ErrorMetric::Ulp, 1.9, [](float_t x, float_t) { return log2<Precision::Accurate>(x); }, log2_reference, positive_normals);
+	test_error_bound<float_t>("log2<Accurate>", type_name, ErrorMetric::Ulp, 1.9, [](float_t x, float_t) { return log2<Precision::Accurate>(x); }, log2_reference, around_1);
+	test_error_bound<float_t>("log2<Accurate>", type_name, ErrorMetric::Ulp, 1.9, [](float_t x, float_t) { return log2<Precision::Accurate>(x); }, log2_reference, positive_denormals);
+
+	test_error_bound<float_t>("exp<Fast>", type_name, ErrorMetric::Relative, 3.6e-2, [](float_t x, float_t) { return exp<Precision::Fast>(x); }, exp_reference, exp_domain);
+	test_error_bound<float_t>("exp<Balanced>", type_name, ErrorMetric::Relative, 6.4e-6, [](float_t x, float_t) { return exp<Precision::Balanced>(x); }, exp_reference, exp_domain);
+	test_error_bound<float_t>("exp<Accurate>", type_name, ErrorMetric::Ulp, exp_accurate_ulp, [](float_t x, float_t) { return exp<Precision::Accurate>(x); }, exp_reference, exp_domain);
+
+	test_error_bound<float_t>("pow<Fast>", type_name, ErrorMetric::Relative, 2.3e-4, [](float_t x, float_t y) { return pow<Precision::Fast>(x, y); }, pow_reference, pow_domain);
+	test_error_bound<float_t>("pow<Balanced>", type_name, ErrorMetric::Relative, 5.3e-6, [](float_t x, float_t y) { return pow<Precision::Balanced>(x, y); }, pow_reference, pow_domain);
+	test_error_bound<float_t>("pow<Accurate>", type_name, ErrorMetric::Relative, 1.5e-6, [](float_t x, float_t y) { return pow<Precision::Accurate>(x, y); }, pow_reference, pow_domain);
+
+	test_error_bound<float_t>("tanh<Fast>", type_name, ErrorMetric::Absolute, 6.6e-3, [](float_t x, float_t) { return tanh<Precision::Fast>(x); }, tanh_reference, within_10);
+	test_error_bound<float_t>("tanh<Balanced>", type_name, ErrorMetric::Relative, 1.9e-6, [](float_t x, float_t) { return tanh<Precision::Balanced>(x); }, tanh_reference, within_10);
+	test_error_bound<float_t>("tanh<Accurate>", type_name, ErrorMetric::Ulp, 2.0, [](float_t x, float_t) { return tanh<Precision::Accurate>(x); }, tanh_reference, within_10);
+
+	test_error_bound<float_t>("atan<Fast>", type_name, ErrorMetric::Absolute, 2.9e-3, [](float_t x, float_t) { return atan<Precision::Fast>(x); }, atan_reference, real_line);
+	test_error_bound<float_t>("atan<Balanced>", type_name, ErrorMetric::Absolute, 1.9e-6, [](float_t x, float_t) { return atan<Precision::Balanced>(x); }, atan_reference, real_line);
+	test_error_bound<float_t>("atan<Accurate>", type_name, ErrorMetric::Ulp, 4.1, [](float_t x, float_t) { return atan<Precision::Accurate>(x); }, atan_reference, real_line);
+
+	test_error_bound<float_t>("atan2<Fast>", type_name, ErrorMetric::Absolute, 2.9e-3, [](float_t x, float_t y) { return atan2<Precision::Fast>(y, x); }, atan2_reference, plane);
+	test_error_bound<float_t>("atan2<Balanced>", type_name, ErrorMetric::Absolute, 2.0e-6, [](float_t x, float_t y) { return atan2<Precision::Balanced>(y, x); }, atan2_reference, plane);
+	test_error_bound<float_t>("atan2<Accurate>", type_name, ErrorMetric::Ulp, 4.7, [](float_t x, float_t y) { return atan2<Precision::Accurate>(y, x); }, atan2_reference, plane);
+
+	test_error_bound<float_t>("acos<Fast>", type_name, ErrorMetric::Absolute, 6.9e-5, [](float_t x, float_t) { return acos<Precision::Fast>(x); }, acos_reference, within_1);
+	test_error_bound<float_t>("acos<Balanced>", type_name, ErrorMetric::Ulp, 2.9, [](float_t x, float_t) { return acos<Precision::Balanced>(x); }, acos_reference, within_1);
+	test_error_bound<float_t>("acos<Accurate>", type_name, ErrorMetric::Ulp, 1.3, [](float_t x, float_t) { return acos<Precision::Accurate>(x); }, acos_reference, within_1);
+}
+
+static u32 lane_bits(float x) { u32 u; memcpy(&u, &x, sizeof(u)); return u; }
+static u32 lane_bits(i32 x) { return (u32)x; }
+
+// Applies operation to wide_t and to reference_t arguments with the same lanes, and checks that the results have
+// the same bits. generate(random, a, b, c) fills one lane of each of the three arguments.
+template <typename wide_t, typename reference_t, typename Operation, typename Generate>
+static void test_same_lanes(const char* function, const char* type_name, Operation&& operation, Generate&& generate)
+{
+	constexpr u32 lane_count = sizeof(wide_t) / sizeof(u32);
+	constexpr u32 argument_count = 1 << 14;
+	using lane_t = decltype(std::declval<reference_t>()[0]);
+
+	TestRandom random;
+	u32 mismatch_count = 0;
+	char description[512];
+	snprintf(description, sizeof(description), "%s(%s) matches the scalar path", function, type_name);
+
+	for (u32 first = 0; first < argument_count; first += lane_count)
+	{
+		alignas(64) lane_t a[lane_count];
+		alignas(64) lane_t b[lane_count];
+		alignas(64) lane_t c[lane_count];
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			generate(random, a[l], b[l], c[l]);
+		}
+
+		auto result = operation(wide_t(a), wide_t(b), wide_t(c));
+		auto expected = operation(reference_t(a), reference_t(b), reference_t(c));
+		static_assert(sizeof(decltype(result)) == sizeof(decltype(expected)));
+
+		// Results are either wide or a single i32, like to_bit_mask.
+		constexpr u32 word_count = sizeof(decltype(result)) / sizeof(u32);
+		u32 result_words[word_count];
+		u32 expected_words[word_count];
+		memcpy(result_words, &result, sizeof(result));
+		memcpy(expected_words, &expected, sizeof(expected));
+
+		for (u32 w = 0; w < word_count; ++w)
+		{
+			if (result_words[w] != expected_words[w])
+			{
+				if (mismatch_count == 0)
+				{
+					snprintf(description, sizeof(description), "%s(%s) lane %u is 0x%08X, the scalar path gives 0x%08X, for arguments 0x%08X, 0x%08X, 0x%08X",
+						function, type_name, w, result_words[w], expected_words[w], lane_bits(a[w]), lane_bits(b[w]), lane_bits(c[w]));
+				}
+				++mismatch_count;
+			}
+		}
+	}
+
+	check(mismatch_count == 0, std::string(description) + ", " + std::to_string(mismatch_count) + " lanes differ");
+}
+
+// Every operation of the wide types against the scalar implementation, which defines their semantics (see
+// simd_scalar.h). This covers the emulations for instruction sets without a direct instruction, like the SSE2
+// multiplication, variable shifts and blends, and the integer division through doubles. Arguments stay finite and
+// away from denormals, where fast math lets the scalar code differ.
+template <typename float_t, typename int_t>
+static void test_against_scalar(const char* float_name, const char* int_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	using reference_float = scalar_w_float<lane_count>;
+	using reference_int = scalar_w_int<lane_count>;
+
+	// Signed zeros, small integers and halfway cases, and magnitudes from 1e-15 to 1e15.
+	auto random_float = [](TestRandom& random)
+	{
+		double kind = random.uniform(0.0, 1.0);
+		if (kind < 0.05) { return (kind < 0.025) ? 0.f : -0.f; }
+		if (kind < 0.3) { return (float)(std::floor(random.uniform(-16.0, 16.0)) * 0.5); }
+		double magnitude = random.logarithmic(1e-15, 1e15);
+		return (float)((random.uniform(-1.0, 1.0) < 0.0) ? -magnitude : magnitude);
+	};
+
+	// Small and negative values, and any bits.
+	auto random_int = [](TestRandom& random)
+	{
+		double kind = random.uniform(0.0, 1.0);
+		if (kind < 0.3) { return (i32)std::floor(random.uniform(-100.0, 100.0)); }
+		return (i32)(u32)random.uniform(0.0, 4294967296.0);
+	};
+
+	auto floats = [=](TestRandom& random, float& a, float& b, float& c) { a = random_float(random); b = random_float(random); c = random_float(random); };
+	auto nonzero_divisors = [=](TestRandom& random, float& a, float& b, float& c) { floats(random, a, b, c); b = (b == 0.f) ? 3.f : b; };
+	auto ints = [=](TestRandom& random, i32& a, i32& b, i32& c) { a = random_int(random); b = random_int(random); c = random_int(random); };
+	auto int_divisors = [=](TestRandom& random, i32& a, i32& b, i32& c)
+	{
+		ints(random, a, b, c);
+		b = (b == 0 || (a == INT32_MIN && b == -1)) ? 7 : b;
+	};
+	// Shift counts from 0 to 40, also beyond the width of a lane.
+	auto shift_counts = [=](TestRandom& random, i32& a, i32& b, i32& c) { ints(random, a, b, c); b = (i32)random.uniform(0.0, 41.0); };
+
+	auto test_floats = [&](const char* function, auto&& operation, auto&& generate) { test_same_lanes<float_t, reference_float>(function, float_name, operation, generate); };
+	auto test_ints = [&](const char* function, auto&& operation, auto&& generate) { test_same_lanes<int_t, reference_int>(function, int_name, operation, generate); };
+
+	// Comparisons give bit masks on AVX-512, so they are compared through if_then. There, w8 and w16 only select by
+	// bit masks, and w16 has no to_bit_mask, so these are tested where they exist.
+	auto as_lanes = [](auto mask, auto a) { using wide = decltype(a); return if_then(mask, wide::all_ones(), wide::zero()); };
+	auto select_by_sign = [](auto a, auto b, auto c) -> decltype(if_then(a, b, c)) { return if_then(a, b, c); };
+	auto sign_bits = [](auto a, auto, auto) -> decltype(to_bit_mask(a)) { return to_bit_mask(a); };
+
+	test_floats("operator+", [](auto a, auto b, auto) { return a + b; }, floats);
+	test_floats("operator-", [](auto a, auto b, auto) { return a - b; }, floats);
+	test_floats("operator*", [](auto a, auto b, auto) { return a * b; }, floats);
+	test_floats("operator/", [](auto a, auto b, auto) { return a / b; }, nonzero_divisors);
+	test_floats("negation", [](auto a, auto, auto) { return -a; }, floats);
+	test_floats("operator&", [](auto a, auto b, auto) { return a & b; }, floats);
+	test_floats("operator|", [](auto a, auto b, auto) { return a | b; }, floats);
+	test_floats("operator^", [](auto a, auto b, auto) { return a ^ b; }, floats);
+	test_floats("operator~", [](auto a, auto, auto) { return ~a; }, floats);
+	test_floats("and_not", [](auto a, auto b, auto) { return and_not(a, b); }, floats);
+	test_floats("operator>>", [](auto a, auto, auto) { return a >> 9; }, floats);
+	test_floats("operator<<", [](auto a, auto, auto) { return a << 1; }, floats);
+	test_floats("operator==", [=](auto a, auto b, auto) { return as_lanes(a == b, a); }, floats);
+	test_floats("operator!=", [=](auto a, auto b, auto) { return as_lanes(a != b, a); }, floats);
+	test_floats("operator<", [=](auto a, auto b, auto) { return as_lanes(a < b, a); }, floats);
+	test_floats("operator<=", [=](auto a, auto b, auto) { return as_lanes(a <= b, a); }, floats);
+	test_floats("operator>", [=](auto a, auto b, auto) { return as_lanes(a > b, a); }, floats);
+	test_floats("operator>=", [=](auto a, auto b, auto) { return as_lanes(a >= b, a); }, floats);
+	test_floats("operator== on equal values", [=](auto a, auto, auto) { return as_lanes(a == a, a); }, floats);
+	test_floats("minimum", [](auto a, auto b, auto) { return minimum(a, b); }, floats);
+	test_floats("maximum", [](auto a, auto b, auto) { return maximum(a, b); }, floats);
+	test_floats("abs", [](auto a, auto, auto) { return abs(a); }, floats);
+	test_floats("sqrt", [](auto a, auto, auto) { return sqrt(abs(a)); }, floats);
+	test_floats("floor", [](auto a, auto, auto) { return floor(a); }, floats);
+	test_floats("round", [](auto a, auto, auto) { return round(a); }, floats);
+	if constexpr (std::is_invocable_v<decltype(select_by_sign), float_t, float_t, float_t>)
+	{
+		test_floats("if_then", select_by_sign, floats);
+	}
+	test_floats("all_ones", [](auto a, auto, auto) { return decltype(a)::all_ones(); }, floats);
+	if constexpr (std::is_invocable_v<decltype(sign_bits), float_t, float_t, float_t>)
+	{
+		test_floats("to_bit_mask", sign_bits, floats);
+	}
+	test_floats("convert", [](auto a, auto, auto) { return convert(a); }, floats);
+	test_floats("reinterpret", [](auto a, auto, auto) { return reinterpret(a); }, floats);
+
+	// Without FMA instructions, fmadd and fmsub multiply and add separately (see simd.h).
+	test_floats("fmadd", [](auto a, auto b, auto c)
+	{
+#if !defined(SIMD_FMA) && !defined(SIMD_SCALAR)
+		if constexpr (std::is_same_v<decltype(a), reference_float>) { return a * b + c; }
+#endif
+		return fmadd(a, b, c);
+	}, floats);
+	test_floats("fmsub", [](auto a, auto b, auto c)
+	{
+#if !defined(SIMD_FMA) && !defined(SIMD_SCALAR)
+		if constexpr (std::is_same_v<decltype(a), reference_float>) { return a * b - c; }
+#endif
+		return fmsub(a, b, c);
+	}, floats);
+
+	test_ints("operator+", [](auto a, auto b, auto) { return a + b; }, ints);
+	test_ints("operator-", [](auto a, auto b, auto) { return a - b; }, ints);
+	test_ints("operator*", [](auto a, auto b, auto) { return a * b; }, ints);
+	test_ints("operator/", [](auto a, auto b, auto) { return a / b; }, int_divisors);
+	test_ints("negation", [](auto a, auto, auto) { return -a; }, ints);
+	test_ints("operator&", [](auto a, auto b, auto) { return a & b; }, ints);
+	test_ints("operator|", [](auto a, auto b, auto) { return a | b; }, ints);
+	test_ints("operator^", [](auto a, auto b, auto) { return a ^ b; }, ints);
+	test_ints("operator~", [](auto a, auto, auto) { return ~a; }, ints);
+	test_ints("and_not", [](auto a, auto b, auto) { return and_not(a, b); }, ints);
+	test_ints("operator>> by lane", [](auto a, auto b, auto) { return a >> b; }, shift_counts);
+	test_ints("operator<< by lane", [](auto a, auto b, auto) { return a << b; }, shift_counts);
+	for (i32 count : { 0, 1, 17, 31, 32, 40 })
+	{
+		std::string count_name = std::to_string(count);
+		test_ints(("operator>> " + count_name).c_str(), [=](auto a, auto, auto) { return a >> count; }, ints);
+		test_ints(("operator<< " + count_name).c_str(), [=](auto a, auto, auto) { return a << count; }, ints);
+	}
+	test_ints("operator==", [=](auto a, auto b, auto) { return as_lanes(a == b, a); }, ints);
+	test_ints("operator!=", [=](auto a, auto b, auto) { return as_lanes(a != b, a); }, ints);
+	test_ints("operator<", [=](auto a, auto b, auto) { return as_lanes(a < b, a); }, ints);
+	test_ints("operator<=", [=](auto a, auto b, auto) { return as_lanes(a <= b, a); }, ints);
+	test_ints("operator>", [=](auto a, auto b, auto) { return as_lanes(a > b, a); }, ints);
+	test_ints("operator>=", [=](auto a, auto b, auto) { return as_lanes(a >= b, a); }, ints);
+	if constexpr (std::is_invocable_v<decltype(select_by_sign), int_t, int_t, int_t>)
+	{
+		test_ints("if_then", select_by_sign, ints);
+	}
+	test_ints("all_ones", [](auto a, auto, auto) { return decltype(a)::all_ones(); }, ints);
+	if constexpr (std::is_invocable_v<decltype(sign_bits), int_t, int_t, int_t>)
+	{
+		test_ints("to_bit_mask", sign_bits, ints);
+	}
+	test_ints("popcount", [](auto a, auto, auto) { return popcount(a); }, ints);
+	test_ints("convert", [](auto a, auto, auto) { return convert(a); }, ints);
+	test_ints("reinterpret", [](auto a, auto, auto) { return reinterpret(a); }, ints);
+}
+
+// compress_store of float_t and int_t for every bit mask, against a scalar loop. The lanes must come out in order,
+// and nothing may be written past the register.
+template <typename float_t, typename int_t>
+static void test_compress_store(const char* type_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	const float untouched = -12345.f;
+
+	alignas(64) float lanes[lane_count];
+	for (u32 l = 0; l < lane_count; ++l)
+	{
+		lanes[l] = (float)(l + 1);
+	}
+	float_t value(lanes);
+
+	u32 failed_mask = UINT32_MAX;
+	for (u32 mask = 0; mask < (1u << lane_count); ++mask)
+	{
+		float expected[lane_count];
+		u32 expected_count = 0;
+		for (u32 l = 0; l < lane_count; ++l)
+		{
+			if ((mask >> l) & 1)
+			{
+				expected[expected_count++] = lanes[l];
+			}
+		}
+
+		float floats[lane_count + 1];
+		i32 ints[lane_count + 1];
+		floats[lane_count] = untouched;
+		ints[lane_count] = -1;
+
+		u32 float_count = compress_store(floats, value, (i32)mask);
+		u32 int_count = compress_store(ints, convert(value), (i32)mask);
+
+		bool correct = (float_count == expected_count) && (int_count == expected_count) && (floats[lane_count] == untouched) && (ints[lane_count] == -1);
+		for (u32 i = 0; i < expected_count && correct; ++i)
+		{
+			correct = (floats[i] == expected[i]) && (ints[i] == (i32)expected[i]);
+		}
+
+		if (!correct && failed_mask == UINT32_MAX)
+		{
+			failed_mask = mask;
+		}
+	}
+
+	check(failed_mask == UINT32_MAX, std::string("compress_store(") + type_name + ")" + ((failed_mask == UINT32_MAX) ? "" : " wrong for bit mask " + std::to_string(failed_mask)));
+}
+
+// random_bits and random_float of the wide ints against those of u32, which must give the same bits in every lane,
+// for consecutive pixels like in a render loop and for coordinates with the high bits set.
+template <typename float_t, typename int_t>
+static void test_random(const char* type_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+
+	u32 mismatch_count = 0;
+	for (u32 first_x : { 0u, 1000u, 0x7FFFFFF0u, 0xFFFFFFF0u })
+	{
+		for (u32 y : { 0u, 1u, 77u, 0x80000000u })
+		{
+			for (u32 dimension = 0; dimension < 4; ++dimension)
+			{
+				alignas(64) i32 x_lanes[lane_count];
+				for (u32 l = 0; l < lane_count; ++l)
+				{
+					x_lanes[l] = (i32)(first_x + l);
+				}
+
+				RandomBits<int_t> bits = random_bits(int_t(x_lanes), int_t((i32)y), int_t(3), int_t((i32)dimension));
+				float_t f = random_float(int_t(x_lanes), int_t((i32)y), int_t(3), int_t((i32)dimension));
+
+				for (u32 l = 0; l < lane_count; ++l)
+				{
+					RandomBits<u32> expected = random_bits<u32>(first_x + l, y, 3, dimension);
+					mismatch_count += ((u32)bits.x[l] != expected.x) + ((u32)bits.y[l] != expected.y) + ((u32)bits.z[l] != expected.z) + ((u32)bits.w[l] != expected.w);
+					mismatch_count += !same_bits(f[l], random_float<u32>(first_x + l, y, 3, dimension));
+				}
+			}
+		}
+	}
+
+	check(mismatch_count == 0, std::string("random_bits and random_float(") + type_name + ") against u32, " + std::to_string(mismatch_count) + " lanes differ");
+}
+
+// intersect_ray against a scalar slab test with the same operations, so the hits and the entry distances of every
+// lane must come out the same. The inverse directions are made up rather than divided, since with fast math the
+// compiler may turn a multiply by a reciprocal back into a division in one of the two. Every group has an empty box
+// in one lane.
+template <typename float_t>
+static void test_intersect_ray(const char* type_name)
+{
+	constexpr u32 lane_count = sizeof(float_t) / sizeof(float);
+	const u32 group_count = 16;
+
+	// Like minimum and maximum of the wide types, these return the second operand if either one is NaN.
+	auto minimum_of = [](float a, float b) { return (a < b) ? a : b; };
+	auto maximum_of = [](float a, float b) { return (a > b) ? a : b; };
+
+	float boxes[group_count * lane_count][6];
+	for (u32 b = 0; b < group_count * lane_count; ++b)
+	{
+		float center[3] = { (float)(b % 7) * 3.f - 9.f, (float)(b % 5) * 3.f - 6.f, (float)(b % 11) * 2.f };
+		for (u32 c = 0; c < 3; ++c)
+		{
+			boxes[b][c] = center[c] - (float)(1 + b % 3);
+			boxes[b][c + 3] = center[c] + (float)(1 + b % 2);
+		}
+		if (b % lane_count == (b / lane_count) % lane_count)
+		{
+			boxes[b][0] = boxes[b][1] = boxes[b][2] = FLT_MAX;
+			boxes[b][3] = boxes[b][4] = boxes[b][5] = -FLT_MAX;
+		}
+	}
+
+	u32 hit_count = 0;
+	u32 mismatch_count = 0;
+	for (u32 r = 0; r < 64; ++r)
+	{
+		float origin[3] = { (float)(r % 9) - 4.f, (float)(r % 4) - 2.f, -5.f };
+		float inv_direction[3] = { sinf(r * 0.7f) * 3.f + 0.01f, cosf(r * 0.3f) * 7.f + 0.01f, 0.75f };
+		float t_min = (r % 2) ? 0.f : 3.f;
+		float t_max = (r % 5) ? FLT_MAX : 12.f;
+
+		wN_vec3<float_t> wide_origin(origin[0], origin[1], origin[2]);
+		wN_vec3<float_t> wide_inv_direction(inv_direction[0], inv_direction[1], inv_direction[2]);
+
+		for (u32 g = 0; g < group_count; ++g)
+		{
+			float_t t_entry;
+			u32 mask = (u32)intersect_ray(wide_origin, wide_inv_direction, load_aabbs<float_t>(&boxes[g * lane_count][0]), float_t(t_min), float_t(t_max), t_entry);
+
+			for (u32 l = 0; l < lane_count; ++l)
+			{
+				const float* box = boxes[g * lane_count + l];
+				float near_t[3], far_t[3];
+				for (u32 c = 0; c < 3; ++c)
+				{
+					float t0 = (box[c] - origin[c]) * inv_direction[c];
+					float t1 = (box[c + 3] - origin[c]) * inv_direction[c];
+					near_t[c] = minimum_of(t0, t1);
+					far_t[c] = maximum_of(t0, t1);
+				}
+				float entry = maximum_of(near_t[0], maximum_of(near_t[1], maximum_of(near_t[2], t_min)));
+				float exit = minimum_of(far_t[0], minimum_of(far_t[1], minimum_of(far_t[2], t_max)));
+				bool hit = (entry <= exit) && (box[0] <= box[3]);
+
+				hit_count += hit;
+				mismatch_count += (((mask >> l) & 1) != (u32)hit) + !same_bits(t_entry[l], entry);
+			}
+		}
+	}
+
+	check(mismatch_count == 0 && hit_count > 0, std::string("intersect_ray(") + type_name + ") against a scalar slab test, " + std::to_string(hit_count) + " hits, "
+		+ std::to_string(mismatch_count) + " lanes differ");
+}
+
+static void run_simd_tests()
+{
+	test_against_scalar<w4_float, w4_int>("w4_float", "w4_int");
+	test_against_scalar<w8_float, w8_int>("w8_float", "w8_int");
+	test_against_scalar<w16_float, w16_int>("w16_float", "w16_int");
+
+	test_compress_store<w4_float, w4_int>("w4");
+	test_compress_store<w8_float, w8_int>("w8");
+	test_compress_store<w16_float, w16_int>("w16");
+
+	test_random<w4_float, w4_int>("w4");
+	test_random<w8_float, w8_int>("w8");
+	test_random<w16_float, w16_int>("w16");
+
+	test_intersect_ray<w4_float>("w4");
+	test_intersect_ray<w8_float>("w8");
+	test_intersect_ray<w16_float>("w16");
+
+	test_rounding<w4_float>("w4_float");
+	test_rounding<w8_float>("w8_float");
+	test_rounding<w16_float>("w16_float");
+
+	test_precision_tiers<w4_float>("w4_float");
+	test_precision_tiers<w8_float>("w8_float");
+	test_precision_tiers<w16_float>("w16_float");
+}
+
+}
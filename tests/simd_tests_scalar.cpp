@@ -0,0 +1,10 @@
+// The scalar implementation, which every target without SSE2 uses for all widths.
+#define SIMD_SCALAR
+#define SIMD_NAMESPACE scalar
+#include "simd_tests_impl.h"
+
+bool run_simd_tests_scalar()
+{
+	scalar::run_simd_tests();
+	return true;
+}
@@ -0,0 +1,8 @@
+#define SIMD_NAMESPACE sse2
+#include "simd_tests_impl.h"
+
+bool run_simd_tests_sse2()
+{
+	sse2::run_simd_tests();
+	return true;
+}
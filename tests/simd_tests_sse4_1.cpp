@@ -0,0 +1,17 @@
+// MSVC has no compiler switch for SSE4.1, but always accepts its intrinsics.
+#if defined(_MSC_VER) && defined(_M_X64)
+#define SIMD_SSE_4_1
+#endif
+
+#define SIMD_NAMESPACE sse4_1
+#include "simd_tests_impl.h"
+
+bool run_simd_tests_sse4_1()
+{
+#if defined(SIMD_SSE_4_1)
+	sse4_1::run_simd_tests();
+	return true;
+#else
+	return false;
+#endif
+}